@@ -0,0 +1,175 @@
+#!/usr/bin/env python
+"""
+CSV to Pack
+
+Converts CSV recordings (as saved by serial-data-collect-csv.py and found in
+Datasets/) into a single binary pack file. The harnesses (main.cpp) and the
+lab 06 tools map a pack and iterate its recordings in place, without parsing
+text or opening a file per recording. The format is documented in
+lib/imu-pack/imu-pack.h.
+
+Every CSV file needs the columns timestamp, accX, accY, accZ, gyrX, gyrY and
+gyrZ. The label of a recording is its filename up to the first '.' (e.g.
+alpha.0696972008ba.csv is "alpha"). The sampling interval of a recording is
+the difference between its first two timestamps.
+
+Call this script as follows:
+
+    python csv-to-pack.py \\
+        ../Datasets/magic-wand-standardized/testing \\
+        -o ../Datasets/magic-wand-standardized/testing.pack
+
+Inputs can be CSV files or directories (every *.csv file in the directory,
+sorted by name). Then pass the pack to a harness instead of CSV files:
+
+    ./build/app.out ../Datasets/magic-wand-standardized/testing.pack
+
+Only the Python standard library is needed.
+
+Author: EdgeImpulse, Inc.
+License: Apache-2.0 (apache.org/licenses/LICENSE-2.0)
+"""
+
+import argparse
+import csv
+import os
+import struct
+
+# Settings
+COLUMNS = ["accX", "accY", "accZ", "gyrX", "gyrY", "gyrZ"]  # Stored channels
+TIME_COLUMN = "timestamp"                                   # Time column (ms)
+
+# Format (see imu-pack.h)
+MAGIC = b"IMUPACK\0"
+VERSION = 1
+FORMAT_FLOAT32 = 0
+ALIGNMENT = 64
+HEADER_FORMAT = "<8s6I4Q"
+RECORD_FORMAT = "<3IfQ"
+
+################################################################################
+# Functions
+
+def list_csv_files(paths):
+    """Expand directories into their CSV files (sorted by name)"""
+    files = []
+    for path in paths:
+        if os.path.isdir(path):
+            names = sorted(n for n in os.listdir(path) if n.endswith(".csv"))
+            files.extend(os.path.join(path, n) for n in names)
+        else:
+            files.append(path)
+    return files
+
+def read_recording(path):
+    """Read the rows (one list of floats per row) and interval of a CSV file"""
+    with open(path, 'r', newline='') as file:
+        reader = csv.DictReader(file)
+        missing = [c for c in [TIME_COLUMN] + COLUMNS if c not in (reader.fieldnames or [])]
+        if missing:
+            raise ValueError("{}: missing column(s) {}".format(path, ", ".join(missing)))
+        timestamps = []
+        rows = []
+        for row in reader:
+            timestamps.append(float(row[TIME_COLUMN]))
+            rows.append([float(row[c]) for c in COLUMNS])
+    interval_ms = timestamps[1] - timestamps[0] if len(timestamps) > 1 else 0.0
+    return rows, interval_ms
+
+def align(offset):
+    """Round an offset up to the section alignment"""
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+def pad(buf):
+    """Pad a bytearray with zeros up to the section alignment"""
+    buf.extend(b"\0" * (align(len(buf)) - len(buf)))
+
+def write_pack(path, files):
+    """Write every CSV file into one pack"""
+
+    # Read recordings and collect the labels in order of appearance
+    recordings = []
+    labels = []
+    for file in files:
+        name = os.path.basename(file)
+        label = name.split('.')[0]
+        if label not in labels:
+            labels.append(label)
+        rows, interval_ms = read_recording(file)
+        recordings.append((name, labels.index(label), rows, interval_ms))
+
+    # Strings section: label names, then recording names
+    strings = bytearray()
+    def add_string(s):
+        offset = len(strings)
+        strings.extend(s.encode('utf-8') + b"\0")
+        return offset
+    label_offsets = [add_string(label) for label in labels]
+    name_offsets = [add_string(r[0]) for r in recordings]
+
+    # Section offsets
+    header_size = struct.calcsize(HEADER_FORMAT)
+    labels_offset = align(header_size)
+    index_offset = align(labels_offset + 4 * len(labels))
+    strings_offset = align(index_offset + struct.calcsize(RECORD_FORMAT) * len(recordings))
+    data_offset = align(strings_offset + len(strings))
+
+    # Data section and index
+    data = bytearray()
+    index = bytearray()
+    for (name, label_idx, rows, interval_ms), name_offset in zip(recordings, name_offsets):
+        index.extend(struct.pack(RECORD_FORMAT, name_offset, label_idx, len(rows), interval_ms,
+            data_offset + len(data)))
+        for row in rows:
+            data.extend(struct.pack("<{}f".format(len(COLUMNS)), *row))
+        pad(data)
+
+    # Assemble the file
+    out = bytearray(struct.pack(HEADER_FORMAT, MAGIC, VERSION, FORMAT_FLOAT32, len(COLUMNS),
+        len(labels), len(recordings), 0, labels_offset, index_offset, strings_offset, len(strings)))
+    pad(out)
+    out.extend(struct.pack("<{}I".format(len(labels)), *label_offsets))
+    pad(out)
+    out.extend(index)
+    pad(out)
+    out.extend(strings)
+    pad(out)
+    out.extend(data)
+
+    with open(path, 'wb') as file:
+        file.write(out)
+
+    return recordings, labels
+
+################################################################################
+# Main
+
+# Command line arguments
+parser = argparse.ArgumentParser(description="Convert CSV recordings into a pack file")
+parser.add_argument('inputs',
+                    type=str,
+                    nargs='+',
+                    help="CSV files or directories of CSV files")
+parser.add_argument('-o',
+                    '--output',
+                    dest='output',
+                    type=str,
+                    required=True,
+                    help="Output pack file (e.g. testing.pack)")
+
+# Parse arguments
+args = parser.parse_args()
+
+files = list_csv_files(args.inputs)
+if not files:
+    print("ERROR: no CSV files found")
+    exit(1)
+
+try:
+    recordings, labels = write_pack(args.output, files)
+except ValueError as e:
+    print("ERROR: " + str(e))
+    exit(1)
+
+print("Wrote {} recordings ({} labels: {}) to {}".format(len(recordings), len(labels),
+    ", ".join(labels), args.output))
@@ -0,0 +1,515 @@
+#!/usr/bin/env python
+"""
+Fold Standardization
+
+Folds the sensor unit conversion and standardization into the quantized input
+of an EON compiled model (trained_model_compiled.cpp), so the device can feed
+raw LSM9DS1 readings to the model.
+
+On the device, every reading currently goes through three affine transforms:
+
+    x = (raw * convert - mean) / std_dev        (units, standardization)
+    q = round(x / input_scale) + zero_point     (input quantization)
+
+Per channel, x / input_scale is raw * k + t with
+
+    k = convert / (std_dev * input_scale)
+    t = -mean / (std_dev * input_scale)
+
+The integer part of t is added to the zero point of that channel. The first
+layer sums weight * (q - zero_point), so the fractional part of t only adds
+a constant to each output, which is folded into the bias of the first fully
+connected layer. The weights and the input scale do not change. The device
+then needs a single multiply-add-round per element:
+
+    q = round(raw * folded_input_scale[ch]) + folded_input_zero_point[ch]
+
+The regenerated trained_model_compiled.cpp (only the first bias differs) and
+folded_input.h with the per-channel constants are written to the output
+directory. The deviation against the original pipeline is measured over the
+CSV files given with --dataset, with a reference int8 implementation of the
+model (fully connected + softmax).
+
+Only the Python standard library is needed.
+
+Call this script as follows:
+
+    python fold-standardization.py \\
+        -m ../06-inference-with-continuous-input/lib/ei-cpp-sdk/tflite-model/trained_model_compiled.cpp \\
+        -s ../Datasets/magic-wand-standardized/metrics.txt \\
+        -d ../Datasets/magic-wand-raw \\
+        -o folded-model
+
+Dataset files hold accelerometer readings in m/s^2 (see 01-data-capture),
+while the LSM9DS1 reports G. The raw readings are recovered by dividing the
+accelerometer columns by --convert.
+
+Author: EdgeImpulse, Inc.
+License: Apache-2.0 (apache.org/licenses/LICENSE-2.0)
+"""
+
+import argparse
+import ast
+import csv
+import math
+import operator
+import os
+import re
+import struct
+
+# Settings
+DEFAULT_CONVERT = 9.80665           # Used to convert G to m/s^2
+DEFAULT_ACCEL_CHANNELS = "0,1,2"    # Channels that are converted from G
+DEFAULT_NUM_READINGS = 100          # 100 readings at 100 Hz is 1 sec window
+
+INT8_MIN = -128
+INT8_MAX = 127
+INT32_MIN = -(1 << 31)
+INT32_MAX = (1 << 31) - 1
+
+################################################################################
+# Float32 and TFLite integer arithmetic
+
+# Round a Python float to the nearest float32 (ops on two float32 values done
+# in double and rounded once give the same result as float32 ops)
+def f32(x):
+    return struct.unpack('f', struct.pack('f', x))[0]
+
+# Same as round() in C: halfway cases away from zero
+def c_round(x):
+    return int(math.floor(abs(x) + 0.5)) * (1 if x >= 0 else -1)
+
+def clamp_int8(x):
+    return min(max(x, INT8_MIN), INT8_MAX)
+
+# tflite::QuantizeMultiplier()
+def quantize_multiplier(real_multiplier):
+    if real_multiplier == 0.0:
+        return 0, 0
+    q, shift = math.frexp(real_multiplier)
+    q_fixed = c_round(q * (1 << 31))
+    if q_fixed == (1 << 31):
+        q_fixed //= 2
+        shift += 1
+    if shift < -31:
+        return 0, 0
+    return q_fixed, shift
+
+# gemmlowp::SaturatingRoundingDoublingHighMul()
+def saturating_rounding_doubling_high_mul(a, b):
+    if a == b == INT32_MIN:
+        return INT32_MAX
+    ab = a * b
+    nudge = (1 << 30) if ab >= 0 else 1 - (1 << 30)
+    return int((ab + nudge) / (1 << 31))
+
+# gemmlowp::RoundingDivideByPOT()
+def rounding_divide_by_pot(x, exponent):
+    mask = (1 << exponent) - 1
+    remainder = x & mask
+    threshold = (mask >> 1) + (1 if x < 0 else 0)
+    return (x >> exponent) + (1 if remainder > threshold else 0)
+
+# tflite::MultiplyByQuantizedMultiplier()
+def multiply_by_quantized_multiplier(x, multiplier, shift):
+    left_shift = shift if shift > 0 else 0
+    right_shift = 0 if shift > 0 else -shift
+    return rounding_divide_by_pot(
+        saturating_rounding_doubling_high_mul(x * (1 << left_shift), multiplier),
+        right_shift)
+
+################################################################################
+# EON compiled model
+
+# Parse a C array initializer ("{ 1, -2, 3, }") into a list of numbers
+def parse_values(text, cast):
+    return [cast(v) for v in text.replace('\n', ' ').split(',') if v.strip()]
+
+# Read the tensors and nodes of an EON compiled model
+def load_model(src):
+    model = {'data': {}, 'quant': {}, 'opdata': {}, 'io': {}}
+
+    for m in re.finditer(r'const ALIGN\(\d+\) (\w+) (tensor_data\d+)\[[^\]]*\] = \{(.*?)\};', src, re.S):
+        cast = float if m.group(1) == 'float' else int
+        model['data'][m.group(2)] = (m.start(3), m.end(3), m.group(1), parse_values(m.group(3), cast))
+
+    for m in re.finditer(r'const TfArray<\d+, float> (quant\d+)_scale = \{ \d+, \{ (.*?) \} \};', src):
+        model['quant'].setdefault(m.group(1), {})['scale'] = parse_values(m.group(2), float)
+    for m in re.finditer(r'const TfArray<\d+, int> (quant\d+)_zero = \{ \d+, \{ (.*?) \} \};', src):
+        model['quant'].setdefault(m.group(1), {})['zero'] = parse_values(m.group(2), int)
+
+    for m in re.finditer(r'const (\w+) (opdata\d+) = \{ (.*?) \};', src):
+        model['opdata'][m.group(2)] = (m.group(1), [v.strip() for v in m.group(3).split(',')])
+    for m in re.finditer(r'const TfArray<\d+, int> ((?:inputs|outputs)\d+) = \{ \d+, \{ (.*?) \} \};', src):
+        model['io'][m.group(1)] = parse_values(m.group(2), int)
+
+    # Tensors in tensorData[] order: constant data (or None) and quantization
+    model['tensors'] = []
+    table = re.search(r'const TensorInfo_t tensorData\[\] = \{(.*?)\n\};', src, re.S).group(1)
+    for m in re.finditer(r'\{ kTfLite\w+, kTfLite\w+, (.*?), .*?&(quant\d+)\)\)\}, \},', table):
+        data = re.search(r'(tensor_data\d+)', m.group(1))
+        model['tensors'].append({
+            'data': data.group(1) if data else None,
+            'quant': model['quant'][m.group(2)],
+        })
+
+    # Nodes in nodeData[] order
+    model['nodes'] = []
+    table = re.search(r'const NodeInfo_t nodeData\[\] = \{(.*?)\n\};', src, re.S).group(1)
+    for m in re.finditer(r'&(inputs\d+).*?&(outputs\d+).*?&(opdata\d+).*?(OP_\w+)', table):
+        model['nodes'].append({
+            'inputs': model['io'][m.group(1)],
+            'outputs': model['io'][m.group(2)],
+            'params': model['opdata'][m.group(3)],
+            'op': m.group(4),
+        })
+
+    return model
+
+def tensor_values(model, ix):
+    return model['data'][model['tensors'][ix]['data']][3]
+
+def tensor_scale(model, ix):
+    return model['tensors'][ix]['quant']['scale'][0]
+
+def tensor_zero_point(model, ix):
+    return model['tensors'][ix]['quant']['zero'][0]
+
+# Precompute what the runtime computes in Prepare() for every node
+def prepare_model(model):
+    for node in model['nodes']:
+        if node['op'] == 'OP_FULLY_CONNECTED':
+            in_ix, w_ix, b_ix = node['inputs']
+            out_ix = node['outputs'][0]
+            weights = tensor_values(model, w_ix)
+            node['weight_rows'] = len(tensor_values(model, b_ix))
+            node['weight_cols'] = len(weights) // node['weight_rows']
+            cols = node['weight_cols']
+            node['rows'] = [weights[r * cols:(r + 1) * cols] for r in range(node['weight_rows'])]
+
+            real_multiplier = (f32(tensor_scale(model, in_ix)) * f32(tensor_scale(model, w_ix))) / \
+                f32(tensor_scale(model, out_ix))
+            node['multiplier'], node['shift'] = quantize_multiplier(real_multiplier)
+
+            act_min, act_max = INT8_MIN, INT8_MAX
+            if node['params'][1][0] == 'kTfLiteActRelu':
+                act_min = max(INT8_MIN, tensor_zero_point(model, out_ix))
+            node['act_range'] = (act_min, act_max)
+        elif node['op'] != 'OP_SOFTMAX':
+            raise ValueError("Unsupported op " + node['op'])
+
+# Run the model over a quantized input. Returns the int8 logits (input of the
+# softmax) and the scores. The softmax is computed in float and quantized to
+# the output tensor, the runtime's fixed-point softmax can be 1 LSB apart.
+def run_model(model, input_q, bias_override=None):
+    values = {0: input_q}
+    logits = None
+    scores = None
+    for ix, node in enumerate(model['nodes']):
+        if node['op'] == 'OP_FULLY_CONNECTED':
+            in_ix, w_ix, b_ix = node['inputs']
+            out_ix = node['outputs'][0]
+            x = values[in_ix]
+            input_offset = -tensor_zero_point(model, in_ix)
+            output_offset = tensor_zero_point(model, out_ix)
+            bias = tensor_values(model, b_ix)
+            if bias_override is not None and ix == 0:
+                bias = bias_override
+            x_off = [v + input_offset for v in x]
+            act_min, act_max = node['act_range']
+            out = []
+            for row, b in zip(node['rows'], bias):
+                acc = sum(map(operator.mul, row, x_off)) + b
+                acc = multiply_by_quantized_multiplier(acc, node['multiplier'], node['shift'])
+                out.append(min(max(acc + output_offset, act_min), act_max))
+            values[out_ix] = out
+        else:
+            in_ix = node['inputs'][0]
+            out_ix = node['outputs'][0]
+            logits = values[in_ix]
+            scale = tensor_scale(model, in_ix)
+            zero_point = tensor_zero_point(model, in_ix)
+            top = max(logits)
+            exps = [math.exp((v - top) * scale) for v in logits]
+            total = sum(exps)
+            out_scale = tensor_scale(model, out_ix)
+            out_zero_point = tensor_zero_point(model, out_ix)
+            scores = [(clamp_int8(c_round(e / total / out_scale) + out_zero_point) - out_zero_point) * out_scale
+                      for e in exps]
+            values[out_ix] = scores
+
+    return logits, scores
+
+################################################################################
+# Folding
+
+# Means and standard deviations from the dataset curation (metrics.txt)
+def load_metrics(path):
+    metrics = {}
+    with open(path, 'r') as file:
+        for line in file:
+            if ':' in line:
+                key, value = line.split(':', 1)
+                metrics[key.strip().lower()] = ast.literal_eval(value.strip())
+    return metrics['means'], metrics['std devs']
+
+# Per-channel input scale and zero point, and the fractional offsets that go
+# into the bias
+def fold_input(means, std_devs, converts, input_scale, zero_point):
+    scales = []
+    zero_points = []
+    fractions = []
+    for mean, std_dev, convert in zip(means, std_devs, converts):
+        k = convert / (std_dev * input_scale)
+        t = -mean / (std_dev * input_scale)
+        n = c_round(t)
+        scales.append(f32(k))
+        zero_points.append(zero_point + n)
+        fractions.append(t - n)
+    return scales, zero_points, fractions
+
+# New first layer bias: bias + sum(weight * fraction of the column's channel)
+def fold_bias(node, bias, fractions):
+    num_channels = len(fractions)
+    new_bias = []
+    for row, b in zip(node['rows'], bias):
+        offset = sum(w * fractions[j % num_channels] for j, w in enumerate(row))
+        new_bias.append(b + c_round(offset))
+    return new_bias
+
+# Replace the values of a constant tensor in the model source
+def replace_tensor_data(src, entry, values):
+    start, end = entry[0], entry[1]
+    return src[:start] + ' ' + ', '.join(str(v) for v in values) + ', ' + src[end:]
+
+def write_header(path, scales, zero_points, model_path):
+    lines = [
+        "/**",
+        " * Folded input quantization, generated by fold-standardization.py from",
+        " * " + os.path.basename(model_path) + ". Quantize raw sensor readings (accelerometer",
+        " * in G, gyroscope in dps) straight into the model input with:",
+        " *",
+        " *   q = round(raw * folded_input_scale[ch]) + folded_input_zero_point[ch]",
+        " *",
+        " * and clamp q to [-128, 127].",
+        " */",
+        "",
+        "#ifndef FOLDED_INPUT_H",
+        "#define FOLDED_INPUT_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        "#define FOLDED_INPUT_CHANNELS   " + str(len(scales)),
+        "",
+        "static const float folded_input_scale[FOLDED_INPUT_CHANNELS] = { " +
+            ", ".join(repr(s) + "f" for s in scales) + " };",
+        "static const int32_t folded_input_zero_point[FOLDED_INPUT_CHANNELS] = { " +
+            ", ".join(str(z) for z in zero_points) + " };",
+        "",
+        "#endif // FOLDED_INPUT_H",
+        "",
+    ]
+    with open(path, 'w') as file:
+        file.write("\n".join(lines))
+
+################################################################################
+# Deviation report
+
+# Read the first num_readings rows of a dataset CSV (zero padded)
+def load_window(path, num_channels, num_readings):
+    rows = []
+    with open(path, 'r') as file:
+        reader = csv.reader(file)
+        next(reader)
+        for row in reader:
+            if len(rows) >= num_readings:
+                break
+            rows.append([float(v) for v in row[1:1 + num_channels]])
+    while len(rows) < num_readings:
+        rows.append([0.0] * num_channels)
+    return rows
+
+# Original device pipeline: convert, standardize, quantize (float32 math)
+def quantize_original(raw, means, std_devs, converts, input_scale, zero_point):
+    q = []
+    saturated = 0
+    for reading in raw:
+        for ch, r in enumerate(reading):
+            x = f32(r * converts[ch]) if converts[ch] != 1.0 else r
+            x = f32(f32(x - means[ch]) / std_devs[ch])
+            v = c_round(f32(x / input_scale)) + zero_point
+            saturated += v != clamp_int8(v)
+            q.append(clamp_int8(v))
+    return q, saturated
+
+# Folded pipeline: one multiply, round, and add per element
+def quantize_folded(raw, scales, zero_points):
+    q = []
+    saturated = 0
+    for reading in raw:
+        for ch, r in enumerate(reading):
+            v = c_round(f32(r * scales[ch])) + zero_points[ch]
+            saturated += v != clamp_int8(v)
+            q.append(clamp_int8(v))
+    return q, saturated
+
+def report_deviation(model, dataset_dirs, means, std_devs, converts, scales, zero_points,
+                     new_bias, num_readings):
+    input_scale = f32(tensor_scale(model, 0))
+    zero_point = tensor_zero_point(model, 0)
+    num_channels = len(means)
+    means = [f32(v) for v in means]
+    std_devs = [f32(v) for v in std_devs]
+    converts_f32 = [f32(v) for v in converts]
+
+    files = []
+    for d in dataset_dirs:
+        files += sorted(os.path.join(d, f) for f in os.listdir(d) if f.endswith('.csv'))
+
+    stats = {
+        'windows': 0, 'elements': 0, 'input_diff': 0, 'input_max_diff': 0,
+        'sat_original': 0, 'sat_folded': 0, 'logits': 0, 'logit_diff': 0, 'logit_max_diff': 0,
+        'score_max_diff': 0.0, 'score_sum_diff': 0.0, 'argmax_diff': 0,
+    }
+    for path in files:
+        window = load_window(path, num_channels, num_readings)
+
+        # Dataset files are converted already, recover the sensor readings
+        raw = [[f32(r / converts[ch]) if converts[ch] != 1.0 else f32(r) for ch, r in enumerate(reading)]
+               for reading in window]
+
+        q_orig, sat_orig = quantize_original(raw, means, std_devs, converts_f32, input_scale, zero_point)
+        q_fold, sat_fold = quantize_folded(raw, scales, zero_points)
+        logits_orig, scores_orig = run_model(model, q_orig)
+        logits_fold, scores_fold = run_model(model, q_fold, new_bias)
+
+        stats['windows'] += 1
+        stats['elements'] += len(q_orig)
+        stats['sat_original'] += sat_orig
+        stats['sat_folded'] += sat_fold
+        stats['logits'] += len(logits_orig)
+        for a, b in zip(logits_orig, logits_fold):
+            stats['logit_diff'] += a != b
+            stats['logit_max_diff'] = max(stats['logit_max_diff'], abs(a - b))
+        diffs = [abs(a - b) for a, b in zip(scores_orig, scores_fold)]
+        stats['score_max_diff'] = max(stats['score_max_diff'], max(diffs))
+        stats['score_sum_diff'] += sum(diffs) / len(diffs)
+        stats['argmax_diff'] += scores_orig.index(max(scores_orig)) != scores_fold.index(max(scores_fold))
+
+    windows = max(stats['windows'], 1)
+    lines = [
+        "Deviation over {} windows ({} files in {})".format(stats['windows'], len(files), ", ".join(dataset_dirs)),
+        "  Saturated inputs (original / folded): {} / {} of {}".format(
+            stats['sat_original'], stats['sat_folded'], stats['elements']),
+        "  Logits that differ: {} of {} (max {} LSB)".format(
+            stats['logit_diff'], stats['logits'], stats['logit_max_diff']),
+        "  Score difference: mean {:.6f}, max {:.6f}".format(stats['score_sum_diff'] / windows,
+            stats['score_max_diff']),
+        "  Predictions that differ: {} of {}".format(stats['argmax_diff'], stats['windows']),
+    ]
+    return "\n".join(lines)
+
+################################################################################
+# Main
+
+# Command line arguments
+parser = argparse.ArgumentParser(description="Fold standardization into the model input")
+parser.add_argument('-m',
+                    '--model',
+                    dest='model',
+                    type=str,
+                    required=True,
+                    help="EON compiled model (trained_model_compiled.cpp)")
+parser.add_argument('-s',
+                    '--metrics',
+                    dest='metrics',
+                    type=str,
+                    required=True,
+                    help="metrics.txt with the means and std devs from dataset curation")
+parser.add_argument('-d',
+                    '--dataset',
+                    dest='dataset',
+                    type=str,
+                    action='append',
+                    default=[],
+                    help="Directory with raw CSV files for the deviation report (can be repeated)")
+parser.add_argument('-o',
+                    '--output',
+                    dest='output',
+                    type=str,
+                    default="folded-model",
+                    help="Output directory (default = folded-model)")
+parser.add_argument('-c',
+                    '--convert',
+                    dest='convert',
+                    type=float,
+                    default=DEFAULT_CONVERT,
+                    help="Accelerometer unit conversion (default = " + str(DEFAULT_CONVERT) + ")")
+parser.add_argument('-a',
+                    '--accel-channels',
+                    dest='accel_channels',
+                    type=str,
+                    default=DEFAULT_ACCEL_CHANNELS,
+                    help="Channels that are converted (default = " + DEFAULT_ACCEL_CHANNELS + ")")
+parser.add_argument('-n',
+                    '--num-readings',
+                    dest='num_readings',
+                    type=int,
+                    default=DEFAULT_NUM_READINGS,
+                    help="Readings per window (default = " + str(DEFAULT_NUM_READINGS) + ")")
+
+# Parse arguments
+args = parser.parse_args()
+accel_channels = [int(c) for c in args.accel_channels.split(',') if c.strip()]
+
+# Read model and dataset metrics
+with open(args.model, 'r') as file:
+    src = file.read()
+model = load_model(src)
+prepare_model(model)
+means, std_devs = load_metrics(args.metrics)
+converts = [args.convert if ch in accel_channels else 1.0 for ch in range(len(means))]
+
+first = model['nodes'][0]
+if first['op'] != 'OP_FULLY_CONNECTED' or first['inputs'][0] != 0:
+    print("ERROR: the first node must be a fully connected layer on the model input")
+    exit(1)
+if first['weight_cols'] % len(means) != 0:
+    print("ERROR: model input is not a multiple of {} channels".format(len(means)))
+    exit(1)
+
+# Fold the affine transforms into the input quantization and the first bias
+input_scale = f32(tensor_scale(model, 0))
+zero_point = tensor_zero_point(model, 0)
+scales, zero_points, fractions = fold_input(means, std_devs, converts, input_scale, zero_point)
+bias_ix = first['inputs'][2]
+bias_name = model['tensors'][bias_ix]['data']
+new_bias = fold_bias(first, tensor_values(model, bias_ix), fractions)
+
+print("Folded input quantization:")
+for ch in range(len(scales)):
+    print("  channel {}: scale {:.9g}, zero point {}, bias fraction {:+.4f}".format(
+        ch, scales[ch], zero_points[ch], fractions[ch]))
+
+# Write the regenerated model and the constants for the device
+try:
+    os.makedirs(args.output)
+except FileExistsError:
+    pass
+model_out = os.path.join(args.output, os.path.basename(args.model))
+with open(model_out, 'w') as file:
+    file.write(replace_tensor_data(src, model['data'][bias_name], new_bias))
+print("Model written to:", model_out)
+header_out = os.path.join(args.output, "folded_input.h")
+write_header(header_out, scales, zero_points, args.model)
+print("Constants written to:", header_out)
+
+# Measure how far the folded pipeline is from the original one
+if args.dataset:
+    report = report_deviation(model, args.dataset, means, std_devs, converts, scales, zero_points,
+                              new_bias, args.num_readings)
+    print(report)
+    report_out = os.path.join(args.output, "report.txt")
+    with open(report_out, 'w') as file:
+        file.write(report + "\n")
+    print("Report written to:", report_out)
@@ -1,36 +1,39 @@
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200112L
 
+#include <errno.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "time-emulator.h"
 
+// Sleep until CLOCK_MONOTONIC has advanced by the given number of microseconds.
+// The deadline is absolute, so the thread sleeps once in the kernel instead of
+// waking up to poll the clock, and signals do not stretch the delay.
+static void sleep_monotonic_us(unsigned long us) {
+    struct timespec deadline;
+    if (clock_gettime(CLOCK_MONOTONIC, &deadline) == -1) {
+        return;
+    }
+    deadline.tv_sec += us / 1000000;
+    deadline.tv_nsec += (us % 1000000) * 1000;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+}
+
 // Sleeps the program by the number of milliseconds specified
 // Note: Linux is NOT (by default) a real-time OS. Delay is best effort.
 void delay(unsigned long ms) {
-    struct timespec req, rem;
-    req.tv_sec = 0;
-    req.tv_nsec = 500000;
-
-    // Wake up every half millisecond to check timer
-    unsigned long t_start = millis();
-    while (millis() - t_start < ms) {
-        nanosleep(&req, &rem);
-    }
+    sleep_monotonic_us(ms * 1000);
 }
 
 // Sleeps the program by the number of microseconds specified
 // Note: Linux is NOT (by default) a real-time OS. Delay is best effort.
 void delayMicroseconds(unsigned long us) {
-    struct timespec req, rem;
-    req.tv_sec = 0;
-    req.tv_nsec = 500;
-
-    // Wake up every half microsecond to check timer
-    unsigned long t_start = micros();
-    while (micros() - t_start < us) {
-        nanosleep(&req, &rem);
-    }
+    sleep_monotonic_us(us);
 }
 
 // Return elapsed time in microseconds
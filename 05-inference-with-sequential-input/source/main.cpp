@@ -10,6 +10,10 @@
  * to read a full CSV file (1 second's worth of data), perform inference, and
  * print the predicted label and value to the console.
  * 
+ * Arguments can also be pack files (*.pack, see 01-data-capture/csv-to-pack.py
+ * and lib/imu-pack/imu-pack.h). loop() is then called once for each recording
+ * in the pack, which is read in place instead of parsed.
+ * 
  * Author: Shawn Hymel (EdgeImpulse, Inc.)
  * Date: August 28, 2022
  * License: Apache-2.0
@@ -17,9 +21,11 @@
 
 #include <stdio.h>
 #include <cstdlib>
+#include <algorithm>
 #include <array>
 
 #include "csv.h"
+#include "imu-pack.h"
 #include "time-emulator.h"
 #include "imu-emulator.h"
 #include "submission.h"
@@ -28,6 +34,8 @@
 int findClosestIdx(unsigned long time_ms);
 int readAccelerometerCallback(float& x, float& y, float& z);
 int readGyroscopeCallback(float& x, float& y, float& z);
+static void pushReading(float timestamp, const float *values);
+static void replayReadings();
 
 // Vector of raw readings to be supplied to the user via callbacks
 static std::vector<std::array<float, 7>> raw_readings;
@@ -36,6 +44,16 @@ static std::vector<std::array<float, 7>> raw_readings;
 static unsigned long first_reading_timestamp = 0;
 static bool is_first_reading = true;
 
+// Sample rate (milliseconds) from the first two readings, used to rebuild the
+// timestamps of every reading
+static float sample_rate = 0.0;
+static int reading_idx = 0;
+
+// Result of the last findClosestIdx() lookup (the next lookup starts there)
+static size_t lookup_idx = 0;
+static unsigned long lookup_time_ms = 0;
+static bool lookup_valid = false;
+
 // How the arrays in the raw readings vector are indexed
 enum VectorIDXs {
     TIME_IDX = 0,
@@ -47,6 +65,9 @@ enum VectorIDXs {
     GYR_Z_IDX
 };
 
+// Number of values in a reading besides the timestamp
+#define NUM_AXES    (GYR_Z_IDX - TIME_IDX)
+
 /*******************************************************************************
  * Main
  */
@@ -55,10 +76,6 @@ enum VectorIDXs {
 int main(int argc, char **argv) {
 
     float timestamp, accX, accY, accZ, gyrX, gyrY, gyrZ;
-    std::array<float, 7> reading;
-    
-    float sample_rate = 0.0;
-    int reading_idx = 0;
 
     // Check to make sure we've beens supplied at least one input file
     if (argc < 2) {
@@ -76,6 +93,29 @@ int main(int argc, char **argv) {
     // Loop through all files provided as arguments
     for (int file_idx = 1; file_idx < argc; file_idx++) {
 
+        // Replay every recording in a pack file, straight from the mapping
+        if (isImuPackFile(argv[file_idx])) {
+            ImuPack pack;
+            if (!pack.open(argv[file_idx])) {
+                return 1;
+            }
+            if (pack.channels() != NUM_AXES) {
+                printf("ERROR: %s has %u channels, expected %d\r\n", 
+                        argv[file_idx], (unsigned int)pack.channels(), NUM_AXES);
+                return 1;
+            }
+            for (size_t rec_idx = 0; rec_idx < pack.size(); rec_idx++) {
+                raw_readings.clear();
+                const float *values = pack.data(rec_idx);
+                for (size_t row = 0; row < pack.rows(rec_idx); row++) {
+                    pushReading(row * pack.intervalMs(rec_idx), values);
+                    values += pack.channels();
+                }
+                replayReadings();
+            }
+            continue;
+        }
+
         // Clear the raw readings vector
         raw_readings.clear();
 
@@ -98,37 +138,12 @@ int main(int argc, char **argv) {
                                     gyrX, 
                                     gyrY, 
                                     gyrZ)) {
-
-            // Calculate sample rate (and use that instead of what's in CSV)
-            if (reading_idx == 0) {
-                sample_rate = timestamp;
-            } else if (reading_idx == 1) {
-                sample_rate = timestamp - sample_rate;
-            }
-            timestamp = sample_rate * raw_readings.size();
-
-            // Read values into array
-            reading[TIME_IDX] = timestamp;
-            reading[ACC_X_IDX] = accX;
-            reading[ACC_Y_IDX] = accY;
-            reading[ACC_Z_IDX] = accZ;
-            reading[GYR_X_IDX] = gyrX;
-            reading[GYR_Y_IDX] = gyrY;
-            reading[GYR_Z_IDX] = gyrZ;
-
-            // Push array onto vector
-            raw_readings.push_back(reading);
-
-            // Increment our index
-            reading_idx++;
+            const float values[] = {accX, accY, accZ, gyrX, gyrY, gyrZ};
+            pushReading(timestamp, values);
         }
 
-        // Reset timestamp readings for callbacks
-        first_reading_timestamp = 0;
-        is_first_reading = true;
-
         // Call user supplied loop() function (once for each CSV file)
-        loop();
+        replayReadings();
     }
 
     // We're done here
@@ -139,6 +154,43 @@ int main(int argc, char **argv) {
  * Functions
  */
 
+// Add one reading (accX, accY, accZ, gyrX, gyrY, gyrZ) to the raw readings
+static void pushReading(float timestamp, const float *values) {
+
+    std::array<float, 7> reading;
+
+    // Calculate sample rate (and use that instead of what's in CSV)
+    if (reading_idx == 0) {
+        sample_rate = timestamp;
+    } else if (reading_idx == 1) {
+        sample_rate = timestamp - sample_rate;
+    }
+    timestamp = sample_rate * raw_readings.size();
+
+    // Read values into array
+    reading[TIME_IDX] = timestamp;
+    for (int i = ACC_X_IDX; i <= GYR_Z_IDX; i++) {
+        reading[i] = values[i - ACC_X_IDX];
+    }
+
+    // Push array onto vector
+    raw_readings.push_back(reading);
+
+    // Increment our index
+    reading_idx++;
+}
+
+// Call the user supplied loop() function on the raw readings of one recording
+static void replayReadings() {
+
+    // Reset timestamp readings for callbacks
+    first_reading_timestamp = 0;
+    is_first_reading = true;
+    lookup_valid = false;
+
+    loop();
+}
+
 // Read accelerometer callback function
 int readAccelerometerCallback(float& x, float& y, float& z) {
 
@@ -199,22 +251,58 @@ int readGyroscopeCallback(float& x, float& y, float& z) {
     return 1;
 }
 
-// Get closest reading from vector of readings
+// Timestamp (milliseconds) of a reading, as compared by findClosestIdx()
+static unsigned long readingTime(size_t idx) {
+    return raw_readings[idx][TIME_IDX];
+}
+
+// Get closest reading from vector of readings. Timestamps never decrease, so
+// the distance to time_ms shrinks up to the closest reading and grows after
+// it. Reads move forward in time: continue from the previous result instead
+// of scanning the whole vector, and binary search only if time goes back.
+// Ties go to the earlier reading.
 int findClosestIdx(unsigned long time_ms) {
 
-    unsigned long closest_time = raw_readings[0][TIME_IDX];
-    int closest_time_idx = 0;
-    unsigned long num;
-
-    // Loop through timestamps in vector to find closest
-    for (long unsigned int i = 0; i < raw_readings.size(); i++) {
-        num = raw_readings[i][TIME_IDX];
-        if (abs((long long)time_ms - (long long)num) < 
-            abs((long long)time_ms - (long long)closest_time)) {
-                closest_time = num;
-                closest_time_idx = i;
+    // Accelerometer and gyroscope reads at the same tick share one lookup
+    if (lookup_valid && time_ms == lookup_time_ms) {
+        return (int)lookup_idx;
+    }
+
+    // Start from the previous result, or search again if time went back
+    size_t idx = lookup_idx;
+    if (!lookup_valid || time_ms < lookup_time_ms || idx >= raw_readings.size()) {
+        idx = std::lower_bound(raw_readings.begin(), raw_readings.end(), time_ms,
+            [](const std::array<float, 7>& reading, unsigned long t) {
+                return (unsigned long)reading[TIME_IDX] < t;
+            }) - raw_readings.begin();
+
+        // Back up to the first reading with the previous timestamp
+        if (idx > 0) {
+            unsigned long prev_time = readingTime(idx - 1);
+            idx = std::lower_bound(raw_readings.begin(), raw_readings.begin() + idx, prev_time,
+                [](const std::array<float, 7>& reading, unsigned long t) {
+                    return (unsigned long)reading[TIME_IDX] < t;
+                }) - raw_readings.begin();
         }
     }
 
-    return closest_time_idx;
+    // Walk forward while readings get closer (skipping duplicate timestamps)
+    size_t closest_time_idx = idx;
+    long long closest_dist = llabs((long long)time_ms - (long long)readingTime(idx));
+    while (idx + 1 < raw_readings.size()) {
+        long long dist = llabs((long long)time_ms - (long long)readingTime(idx + 1));
+        if (dist < closest_dist) {
+            closest_dist = dist;
+            closest_time_idx = idx + 1;
+        } else if (readingTime(idx + 1) != readingTime(idx)) {
+            break;
+        }
+        idx++;
+    }
+
+    lookup_idx = closest_time_idx;
+    lookup_time_ms = time_ms;
+    lookup_valid = true;
+
+    return (int)closest_time_idx;
 }
\ No newline at end of file
@@ -68,5 +68,14 @@
 #endif // CPU_ARC
 #endif // EI_CLASSIFIER_TFLITE_ENABLE_ARC
 
+// AVX2 / AVX-512 VNNI kernels for x86 hosts, selected at runtime via CPUID
+#ifndef EI_CLASSIFIER_TFLITE_ENABLE_X86_SIMD
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define EI_CLASSIFIER_TFLITE_ENABLE_X86_SIMD        1
+#else
+#define EI_CLASSIFIER_TFLITE_ENABLE_X86_SIMD        0
+#endif // x86
+#endif // EI_CLASSIFIER_TFLITE_ENABLE_X86_SIMD
+
 // clang-format on
 #endif // _EI_CLASSIFIER_CONFIG_H_
@@ -25,6 +25,11 @@
 
 #include <stdint.h>
 #include "model-parameters/model_metadata.h"
+#include "edge-impulse-sdk/dsp/config.hpp"
+
+#if EIDSP_TRACK_ALLOCATIONS
+#include "edge-impulse-sdk/dsp/memory.hpp"
+#endif
 
 typedef struct {
     const char *label;
@@ -48,6 +53,20 @@ typedef struct {
     int64_t dsp_us;
     int64_t classification_us;
     int64_t anomaly_us;
+    // Nanosecond timing (monotonic clock). Classification is split into
+    // quantize (features into the input tensor; 0 when the input tensor is
+    // filled straight from the signal, that time is in dsp_ns), invoke and
+    // postprocess (output tensor into the results).
+    int64_t dsp_ns;
+    int64_t quantize_ns;
+    int64_t invoke_ns;
+    int64_t postprocess_ns;
+    // Time it took to sample the window (continuous mode: the slice), and
+    // the largest deviation from the expected time between samples (or
+    // slices), set by run_impulse(), run_classifier_continuous() or the
+    // application that does the sampling
+    int64_t sampling_us;
+    int64_t sampling_jitter_us;
 } ei_impulse_result_timing_t;
 
 typedef struct {
@@ -60,6 +79,10 @@ typedef struct {
     float anomaly;
     ei_impulse_result_timing_t timing;
     int32_t label_detected;
+#if EIDSP_TRACK_ALLOCATIONS
+    // DSP allocations made by this call, if it was sampled
+    ei_dsp_alloc_stats_t alloc_stats;
+#endif
 } ei_impulse_result_t;
 
 #endif // _EDGE_IMPULSE_RUN_CLASSIFIER_TYPES_H_
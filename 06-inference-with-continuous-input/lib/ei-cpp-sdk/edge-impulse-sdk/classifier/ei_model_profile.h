@@ -0,0 +1,204 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _EI_CLASSIFIER_MODEL_PROFILE_H_
+#define _EI_CLASSIFIER_MODEL_PROFILE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+/**
+ * Per-node profiling of the neural network.
+ *
+ * Build with -DEI_CLASSIFIER_PROFILE_NODES=1 (for the whole project, the
+ * TFLite Micro interpreter checks it in its own translation unit) and both
+ * the EON compiled model and the TFLite Micro interpreter time every node
+ * of the model. After an inference, ei_get_model_profile() returns the
+ * profile of that inference. Without the flag nothing is recorded and the
+ * model code is unchanged.
+ */
+#ifndef EI_CLASSIFIER_PROFILE_NODES
+#define EI_CLASSIFIER_PROFILE_NODES             0
+#endif
+
+// Nodes recorded per inference, later nodes are counted in the totals only
+#ifndef EI_CLASSIFIER_PROFILE_MAX_NODES
+#define EI_CLASSIFIER_PROFILE_MAX_NODES         32
+#endif
+
+// Clock for the profile, in nanoseconds
+#ifndef EI_CLASSIFIER_PROFILE_READ_NS
+#define EI_CLASSIFIER_PROFILE_READ_NS()         ei_read_timer_ns()
+#endif
+
+typedef struct {
+    // Operator of the node, as named by the TFLite schema (e.g. "FULLY_CONNECTED")
+    const char *op_name;
+    // Time spent in the node
+    uint64_t ns;
+    // Size of the tensors the node reads and writes (inputs incl. weights, outputs)
+    size_t bytes;
+} ei_node_profile_t;
+
+typedef struct {
+    ei_node_profile_t nodes[EI_CLASSIFIER_PROFILE_MAX_NODES];
+    // Number of nodes in the nodes array
+    size_t node_count;
+    // Sums over all nodes that ran
+    uint64_t total_ns;
+    size_t total_bytes;
+} ei_model_profile_t;
+
+typedef struct {
+    const char *op_name;
+    // Number of nodes with this operator
+    size_t count;
+    uint64_t ns;
+    size_t bytes;
+} ei_op_profile_t;
+
+/**
+ * Clear a profile before an inference
+ */
+static inline void ei_model_profile_clear(ei_model_profile_t *profile)
+{
+    profile->node_count = 0;
+    profile->total_ns = 0;
+    profile->total_bytes = 0;
+}
+
+/**
+ * Add a node that ran to a profile
+ */
+static inline void ei_model_profile_add(ei_model_profile_t *profile, const char *op_name, uint64_t ns, size_t bytes)
+{
+    if (profile->node_count < EI_CLASSIFIER_PROFILE_MAX_NODES) {
+        ei_node_profile_t *node = &profile->nodes[profile->node_count++];
+        node->op_name = op_name;
+        node->ns = ns;
+        node->bytes = bytes;
+    }
+    profile->total_ns += ns;
+    profile->total_bytes += bytes;
+}
+
+/**
+ * Sum the nodes of a profile per operator, in order of first appearance
+ * @param profile Profile of an inference
+ * @param ops Output array
+ * @param ops_size Size of the output array
+ * @returns Number of operators written to ops
+ */
+static inline size_t ei_model_profile_by_op(const ei_model_profile_t *profile, ei_op_profile_t *ops, size_t ops_size)
+{
+    size_t ops_count = 0;
+
+    for (size_t ix = 0; ix < profile->node_count; ix++) {
+        const ei_node_profile_t *node = &profile->nodes[ix];
+
+        size_t op_ix = 0;
+        while (op_ix < ops_count && strcmp(ops[op_ix].op_name, node->op_name) != 0) {
+            op_ix++;
+        }
+        if (op_ix == ops_count) {
+            if (ops_count == ops_size) {
+                continue;
+            }
+            ops[op_ix].op_name = node->op_name;
+            ops[op_ix].count = 0;
+            ops[op_ix].ns = 0;
+            ops[op_ix].bytes = 0;
+            ops_count++;
+        }
+
+        ops[op_ix].count++;
+        ops[op_ix].ns += node->ns;
+        ops[op_ix].bytes += node->bytes;
+    }
+
+    return ops_count;
+}
+
+#if EI_CLASSIFIER_PROFILE_NODES && defined(__cplusplus)
+#include "edge-impulse-sdk/tensorflow/lite/micro/micro_profiler.h"
+
+/**
+ * MicroProfiler for the TFLite Micro interpreter that records its node events
+ * into an ei_model_profile_t (the interpreter tags every event with the
+ * operator name and reports the tensor bytes of the node)
+ */
+class EiMicroProfiler : public tflite::MicroProfiler {
+public:
+    EiMicroProfiler()
+    {
+        ei_model_profile_clear(&_profile);
+    }
+
+    uint32_t BeginEvent(const char* tag) override {
+        if (_profile.node_count == EI_CLASSIFIER_PROFILE_MAX_NODES) {
+            _overflow_start_ns = EI_CLASSIFIER_PROFILE_READ_NS();
+            return EI_CLASSIFIER_PROFILE_MAX_NODES;
+        }
+        uint32_t handle = (uint32_t)_profile.node_count;
+        ei_model_profile_add(&_profile, tag, 0, 0);
+        _start_ns[handle] = EI_CLASSIFIER_PROFILE_READ_NS();
+        return handle;
+    }
+
+    void EndEvent(uint32_t event_handle) override {
+        uint64_t end_ns = EI_CLASSIFIER_PROFILE_READ_NS();
+        if (event_handle >= EI_CLASSIFIER_PROFILE_MAX_NODES) {
+            _profile.total_ns += end_ns - _overflow_start_ns;
+            return;
+        }
+        uint64_t ns = end_ns - _start_ns[event_handle];
+        _profile.nodes[event_handle].ns = ns;
+        _profile.total_ns += ns;
+    }
+
+    void SetEventBytes(uint32_t event_handle, size_t bytes) override {
+        if (event_handle < EI_CLASSIFIER_PROFILE_MAX_NODES) {
+            _profile.nodes[event_handle].bytes = bytes;
+        }
+        _profile.total_bytes += bytes;
+    }
+
+    void Clear() {
+        ClearEvents();
+        ei_model_profile_clear(&_profile);
+    }
+
+    const ei_model_profile_t *profile() const {
+        return &_profile;
+    }
+
+private:
+    ei_model_profile_t _profile;
+    uint64_t _start_ns[EI_CLASSIFIER_PROFILE_MAX_NODES];
+    uint64_t _overflow_start_ns = 0;
+};
+#endif // EI_CLASSIFIER_PROFILE_NODES && __cplusplus
+
+#endif // _EI_CLASSIFIER_MODEL_PROFILE_H_
@@ -85,10 +85,102 @@ namespace {
 
 #define EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR   (EI_CLASSIFIER_OBJECT_DETECTION && !(EI_CLASSIFIER_OBJECT_DETECTION_CONSTRAINED))
 
+// Raw impulses without anomaly block can bind the signal straight to the
+// quantized model input in run_classifier(), and stream it in
+// run_classifier_continuous() instead of rebuilding the whole window
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1) && \
+    (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1) && !EI_CLASSIFIER_OBJECT_DETECTION && (EI_CLASSIFIER_HAS_ANOMALY != 1)
+#define EI_CLASSIFIER_HAS_RAW_INPUT_STREAM      1
+#else
+#define EI_CLASSIFIER_HAS_RAW_INPUT_STREAM      0
+#endif
+
+// Largest window (in values) that run_classifier() reads once and shares
+// between the DSP blocks of multi-block impulses
+#ifndef EI_CLASSIFIER_DSP_SHARED_WINDOW_MAX_SIZE
+#define EI_CLASSIFIER_DSP_SHARED_WINDOW_MAX_SIZE    2048
+#endif
+
+// Maximum number of windows that run_classifier_batch() stacks into one invoke
+#ifndef EI_CLASSIFIER_MAX_BATCH_SIZE
+#define EI_CLASSIFIER_MAX_BATCH_SIZE            16
+#endif
+
+#if EIDSP_SCRATCH_ARENA
+// Largest FFT the DSP blocks of the impulse run (0 if none)
+#ifndef EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH
+#if !defined(EI_CLASSIFIER_HAS_FFT_INFO) || EI_CLASSIFIER_HAS_FFT_INFO != 1 || EI_CLASSIFIER_LOAD_FFT_4096 == 1
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  4096
+#elif EI_CLASSIFIER_LOAD_FFT_2048 == 1
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  2048
+#elif EI_CLASSIFIER_LOAD_FFT_1024 == 1
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  1024
+#elif EI_CLASSIFIER_LOAD_FFT_512 == 1
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  512
+#elif EI_CLASSIFIER_LOAD_FFT_256 == 1
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  256
+#elif EI_CLASSIFIER_LOAD_FFT_128 == 1
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  128
+#elif EI_CLASSIFIER_LOAD_FFT_64 == 1
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  64
+#elif EI_CLASSIFIER_LOAD_FFT_32 == 1
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  32
+#else
+#define EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH  0
+#endif
+#endif // EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH
+
+// Arena space of a scratch buffer of n floats
+#define EI_CLASSIFIER_DSP_ARENA_FLOATS(n)       ((n) * sizeof(float) + EI_DSP_ARENA_BLOCK_OVERHEAD)
+
+/**
+ * Worst-case DSP and feature scratch of one run_classifier() or
+ * run_classifier_continuous() call of this impulse, the size of the arena to
+ * bind with ei_dsp_arena_bind():
+ *
+ * - the features matrix
+ * - the window shared by the DSP blocks of multi-block impulses
+ * - the working set of a raw, flatten or spectral analysis block: a copy of
+ *   the window and its transpose, and for spectral analysis the spectrum of
+ *   every axis plus the per-axis buffers at the largest FFT length, and the
+ *   small buffers (RMS, peaks, edges, filter state)
+ *
+ * Audio and image blocks need frame stacks and filterbanks that depend on
+ * their config, so impulses with a microphone or camera have to define
+ * EI_CLASSIFIER_DSP_ARENA_SIZE themselves (the `peak` of an arena that was
+ * big enough tells how much one call takes). The arena counts allocations
+ * that did not fit in `failed`, and the call returns an error.
+ */
+#ifndef EI_CLASSIFIER_DSP_ARENA_SIZE
+#if (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_MICROPHONE) || (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_CAMERA)
+#error "Define EI_CLASSIFIER_DSP_ARENA_SIZE to use a DSP scratch arena with audio or image impulses"
+#endif
+#define EI_CLASSIFIER_DSP_ARENA_SIZE ( \
+    EI_CLASSIFIER_DSP_ARENA_FLOATS(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) + \
+    EI_CLASSIFIER_DSP_ARENA_FLOATS(EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE) * 3 + \
+    EI_CLASSIFIER_DSP_ARENA_FLOATS((EI_CLASSIFIER_DSP_ARENA_MAX_FFT_LENGTH / 2 + 1) * 2) * \
+        (EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME + 3) + \
+    EI_CLASSIFIER_DSP_ARENA_FLOATS(64) * 16)
+#endif // EI_CLASSIFIER_DSP_ARENA_SIZE
+#endif // EIDSP_SCRATCH_ARENA
+
 /* Function prototypes ----------------------------------------------------- */
 extern "C" EI_IMPULSE_ERROR run_inference(ei::matrix_t *fmatrix, ei_impulse_result_t *result, bool debug);
 extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(signal_t *signal, ei_impulse_result_t *result, bool debug);
 static EI_IMPULSE_ERROR can_run_classifier_image_quantized();
+#if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI)
+template<typename SignalT>
+EI_IMPULSE_ERROR run_classifier_image_quantized(SignalT *signal, ei_impulse_result_t *result, bool debug);
+#endif
+template<typename SignalT>
+static EI_IMPULSE_ERROR run_dsp_blocks(SignalT *signal, ei::matrix_t *features_matrix, ei_impulse_result_t *result, bool debug);
+static EI_IMPULSE_ERROR run_anomaly(ei::matrix_t *fmatrix, ei_impulse_result_t *result, bool debug);
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+static bool can_run_classifier_raw_input();
+template<typename SignalT>
+static EI_IMPULSE_ERROR run_classifier_raw_input(ei_eon_session_t *session, SignalT *signal, ei_impulse_result_t *result, bool debug);
+static EI_IMPULSE_ERROR run_classifier_continuous_raw(signal_t *signal, ei_impulse_result_t *result, bool debug);
+#endif
 static void calc_cepstral_mean_and_var_normalization_mfcc(ei_matrix *matrix, void *config_ptr);
 static void calc_cepstral_mean_and_var_normalization_mfe(ei_matrix *matrix, void *config_ptr);
 static void calc_cepstral_mean_and_var_normalization_spectrogram(ei_matrix *matrix, void *config_ptr);
@@ -96,11 +188,23 @@ static void calc_cepstral_mean_and_var_normalization_spectrogram(ei_matrix *matr
 /* Private variables ------------------------------------------------------- */
 
 static uint64_t classifier_continuous_features_written = 0;
+// When the previous slice was passed to run_classifier_continuous() (0: none yet)
+static uint64_t classifier_continuous_last_slice_us = 0;
+
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+static ei_eon_input_stream_t classifier_continuous_input_stream;
+#endif
 
 #if (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_MICROPHONE)
 static RecognizeEvents *avg_scores = NULL;
 #endif
 
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1) && !EI_CLASSIFIER_OBJECT_DETECTION
+// Batched session of run_classifier_batch(), opened on first use and kept
+// until run_classifier_deinit()
+static ei_eon_session_t classifier_batch_session = { };
+#endif
+
 /* Private functions ------------------------------------------------------- */
 
 /**
@@ -109,7 +213,11 @@ static RecognizeEvents *avg_scores = NULL;
 extern "C" void run_classifier_init(void)
 {
     classifier_continuous_features_written = 0;
+    classifier_continuous_last_slice_us = 0;
     ei_dsp_clear_continuous_audio_state();
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+    ei_eon_input_stream_reset(&classifier_continuous_input_stream);
+#endif
 
 #if (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_MICROPHONE)
     const ei_model_performance_calibration_t *calibration = &ei_calibration;
@@ -123,6 +231,9 @@ extern "C" void run_classifier_init(void)
 
 extern "C" void run_classifier_deinit(void)
 {
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1) && !EI_CLASSIFIER_OBJECT_DETECTION
+    ei_eon_session_close(&classifier_batch_session);
+#endif
 #if (EI_CLASSIFIER_SENSOR == EI_CLASSIFIER_SENSOR_MICROPHONE)
     if((void *)avg_scores != NULL) {
         delete avg_scores;
@@ -130,9 +241,32 @@ extern "C" void run_classifier_deinit(void)
 #endif
 }
 
+/**
+ * @brief      Set the sampling time of a continuous slice: the time since the
+ *             previous slice came in, and how far off that is from the
+ *             duration of a slice (nothing for the first slice)
+ */
+static void set_continuous_sampling_timing(ei_impulse_result_t *result)
+{
+    uint64_t now_us = ei_read_timer_us();
+
+    if (classifier_continuous_last_slice_us != 0) {
+        int64_t sampling_us = (int64_t)(now_us - classifier_continuous_last_slice_us);
+        int64_t jitter_us = sampling_us - (int64_t)(EI_CLASSIFIER_SLICE_SIZE * EI_CLASSIFIER_INTERVAL_MS * 1000);
+
+        result->timing.sampling_us = sampling_us;
+        result->timing.sampling = (int)(sampling_us / 1000);
+        result->timing.sampling_jitter_us = jitter_us < 0 ? -jitter_us : jitter_us;
+    }
+
+    classifier_continuous_last_slice_us = now_us;
+}
+
 /**
  * @brief      Fill the complete matrix with sample slices. From there, run inference
- *             on the matrix.
+ *             on the matrix. The window is kept by the SDK, pass only the new
+ *             slice (EI_CLASSIFIER_SLICE_SIZE samples). Inference runs once
+ *             a full window has been seen.
  *
  * @param      signal  Sample data
  * @param      result  Classification output
@@ -143,14 +277,26 @@ extern "C" void run_classifier_deinit(void)
 extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impulse_result_t *result,
                                                       bool debug = false, bool enable_maf = true)
 {
-    static ei::matrix_t static_features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
-    if (!static_features_matrix.buffer) {
+    EI_DSP_ALLOC_STATS_SCOPE(&result->alloc_stats);
+
+    set_continuous_sampling_timing(result);
+
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+    if (can_run_classifier_raw_input()) {
+        return run_classifier_continuous_raw(signal, result, debug);
+    }
+#endif
+
+    // Kept across calls, so always on the heap (never in a DSP scratch arena)
+    static float *static_features_buffer = (float*)ei_calloc(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, sizeof(float));
+    if (!static_features_buffer) {
         return EI_IMPULSE_ALLOC_FAILED;
     }
+    static ei::matrix_t static_features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, static_features_buffer);
 
     EI_IMPULSE_ERROR ei_impulse_error = EI_IMPULSE_OK;
 
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     size_t out_features_index = 0;
     bool is_mfcc = false;
@@ -183,8 +329,14 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
             extract_fn_slice = &extract_mfe_per_slice_features;
             is_mfe = true;
         }
+        else if (block.extract_fn == extract_raw_features) {
+            extract_fn_slice = &extract_raw_per_slice_features;
+        }
+        else if (block.extract_fn == extract_flatten_features) {
+            extract_fn_slice = &extract_flatten_per_slice_features;
+        }
         else {
-            ei_printf("ERR: Unknown extract function, only MFCC, MFE and spectrogram supported\n");
+            ei_printf("ERR: Unknown extract function, only MFCC, MFE, spectrogram, raw and flatten supported\n");
             return EI_IMPULSE_DSP_ERROR;
         }
 
@@ -215,7 +367,8 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
         out_features_index += block.n_output_features;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
@@ -228,7 +381,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
     }
 
     if (classifier_continuous_features_written >= EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
-        dsp_start_us = ei_read_timer_us();
+        dsp_start_ns = ei_read_timer_ns();
         ei::matrix_t classify_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
 
         /* Create a copy of the matrix for normalization */
@@ -245,7 +398,8 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
         else if (is_mfe) {
             calc_cepstral_mean_and_var_normalization_mfe(&classify_matrix, ei_dsp_blocks[0].config);
         }
-        result->timing.dsp_us += ei_read_timer_us() - dsp_start_us;
+        result->timing.dsp_ns += ei_read_timer_ns() - dsp_start_ns;
+        result->timing.dsp_us = result->timing.dsp_ns / 1000;
         result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
 #if EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_NONE
@@ -264,6 +418,113 @@ extern "C" EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal, ei_impul
     return ei_impulse_error;
 }
 
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+/**
+ * @brief      Whether the impulse is a single raw block that produces the
+ *             whole model input, so the signal is the model input up to the
+ *             block's scale factor
+ */
+static bool can_run_classifier_raw_input()
+{
+    return ei_dsp_blocks_size == 1 && ei_dsp_blocks[0].extract_fn == &extract_raw_features &&
+        ei_dsp_blocks[0].n_output_features == EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+}
+
+/**
+ * @brief      Inference for impulses with a single raw block. The signal is
+ *             scaled and quantized straight into the input tensor, without
+ *             building a feature matrix first.
+ *
+ * @param      session  EON session to run on
+ * @param      signal   Raw signal (signal_t or any other signal type)
+ * @param      result   Classification output
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+template<typename SignalT>
+static EI_IMPULSE_ERROR run_classifier_raw_input(ei_eon_session_t *session, SignalT *signal, ei_impulse_result_t *result, bool debug)
+{
+    ei_model_dsp_t block = ei_dsp_blocks[0];
+    ei_dsp_config_raw_t *config = (ei_dsp_config_raw_t *)block.config;
+
+    if (block.axes_size == EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+        return run_nn_inference_signal(session, signal, config->scale_axes, result, debug);
+    }
+
+#if EIDSP_SIGNAL_C_FN_POINTER
+    ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
+    return EI_IMPULSE_DSP_ERROR;
+#else
+    SignalAxes<SignalT> input(signal, block.axes, block.axes_size);
+    return run_nn_inference_signal(session, &input, config->scale_axes, result, debug);
+#endif
+}
+
+/**
+ * @brief      Continuous inference for impulses with a single raw block. The
+ *             block only scales the signal, so the features of a slice are
+ *             the scaled slice itself. Only the new slice is scaled and
+ *             quantized, the window is kept quantized in
+ *             classifier_continuous_input_stream.
+ *
+ * @param      signal  Sample data of one slice
+ * @param      result  Classification output
+ * @param[in]  debug   Debug output enable boot
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR run_classifier_continuous_raw(signal_t *signal, ei_impulse_result_t *result, bool debug)
+{
+    ei_model_dsp_t block = ei_dsp_blocks[0];
+    ei_dsp_config_raw_t *config = (ei_dsp_config_raw_t *)block.config;
+
+    uint64_t dsp_start_ns = ei_read_timer_ns();
+
+#if EIDSP_SIGNAL_C_FN_POINTER
+    if (block.axes_size != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+        ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
+        return EI_IMPULSE_DSP_ERROR;
+    }
+    signal_t *slice = signal;
+#else
+    SignalWithAxes swa(signal, block.axes, block.axes_size);
+    signal_t *slice = swa.get_signal();
+#endif
+
+    ei::matrix_t slice_features(1, slice->total_length);
+    if (!slice_features.buffer) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    int ret = slice->get_data(0, slice->total_length, slice_features.buffer);
+    if (ret == EIDSP_OK) {
+        ret = numpy::scale(&slice_features, config->scale_axes);
+    }
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    ei_eon_input_stream_push(&classifier_continuous_input_stream, slice_features.buffer, slice_features.cols);
+    classifier_continuous_features_written += slice_features.cols;
+
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
+    result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+
+    if (classifier_continuous_input_stream.written < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
+        return EI_IMPULSE_OK;
+    }
+
+    if (debug) {
+        ei_printf("Running neural network...\n");
+    }
+
+    return run_nn_inference_stream(&eon_default_session, &classifier_continuous_input_stream, result, debug);
+}
+#endif // EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+
 /**
  * @brief      Do inferencing over the processed feature matrix
  *
@@ -366,6 +627,24 @@ extern "C" EI_IMPULSE_ERROR run_inference(
     }
 #endif // EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE
 
+    return run_anomaly(fmatrix, result, debug);
+}
+
+/**
+ * @brief      Run anomaly detection (if the impulse has it) over the processed
+ *             feature matrix
+ *
+ * @param      fmatrix  Processed matrix
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+static EI_IMPULSE_ERROR run_anomaly(
+    ei::matrix_t *fmatrix,
+    ei_impulse_result_t *result,
+    bool debug)
+{
 #if EI_CLASSIFIER_HAS_ANOMALY == 1
 
     // Anomaly detection
@@ -403,17 +682,22 @@ extern "C" EI_IMPULSE_ERROR run_inference(
 }
 
 /**
- * Run the classifier over a raw features array
- * @param raw_features Raw features array
- * @param raw_features_size Size of the features array
+ * Run the classifier over a signal of any type with the same interface as
+ * signal_t (e.g. SignalSpan, see ei_signal_span.h). The signal's get_data is
+ * called directly instead of through a callback, so it can be inlined into
+ * the raw and flatten blocks.
+ * @param signal Raw signal
  * @param result Object to store the results in
  * @param debug Whether to show debug messages (default: false)
  */
-extern "C" EI_IMPULSE_ERROR run_classifier(
-    signal_t *signal,
+template<typename SignalT>
+EI_IMPULSE_ERROR run_classifier(
+    SignalT *signal,
     ei_impulse_result_t *result,
     bool debug = false)
 {
+    EI_DSP_ALLOC_STATS_SCOPE(&result->alloc_stats);
+
 #if (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW)) || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI
 
     // Shortcut for quantized image models
@@ -436,10 +720,230 @@ extern "C" EI_IMPULSE_ERROR run_classifier(
 
     memset(result, 0, sizeof(ei_impulse_result_t));
 
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+    // Shortcut for raw impulses, no feature matrix needed
+    if (can_run_classifier_raw_input()) {
+        return run_classifier_raw_input(&eon_default_session, signal, result, debug);
+    }
+#endif
+
     ei::matrix_t features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
 
-    uint64_t dsp_start_us = ei_read_timer_us();
+    EI_IMPULSE_ERROR dsp_res = run_dsp_blocks(signal, &features_matrix, result, debug);
+    if (dsp_res != EI_IMPULSE_OK) {
+        return dsp_res;
+    }
+
+#if EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_NONE
+    if (debug) {
+        ei_printf("Running neural network...\n");
+    }
+#endif
+
+    return run_inference(&features_matrix, result, debug);
+}
+
+/**
+ * Run the classifier over a raw features array
+ * @param raw_features Raw features array
+ * @param raw_features_size Size of the features array
+ * @param result Object to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier(
+    signal_t *signal,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return run_classifier<signal_t>(signal, result, debug);
+}
+
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+/**
+ * Run the classifier on a persistent EON session. Sessions other than the
+ * default one have their own model instance, so this can be called from
+ * several threads at once as long as each thread uses its own session.
+ * @param session Session opened with ei_eon_session_open()
+ * @param signal Raw signal
+ * @param result Object to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_session(
+    ei_eon_session_t *session,
+    signal_t *signal,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    EI_DSP_ALLOC_STATS_SCOPE(&result->alloc_stats);
+
+    memset(result, 0, sizeof(ei_impulse_result_t));
+
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+    if (can_run_classifier_raw_input()) {
+        return run_classifier_raw_input(session, signal, result, debug);
+    }
+#endif
+
+    ei::matrix_t features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
 
+    EI_IMPULSE_ERROR dsp_res = run_dsp_blocks(signal, &features_matrix, result, debug);
+    if (dsp_res != EI_IMPULSE_OK) {
+        return dsp_res;
+    }
+
+    if (debug) {
+        ei_printf("Running neural network...\n");
+    }
+
+    EI_IMPULSE_ERROR run_res = run_nn_inference_session(session, &features_matrix, result, debug);
+    if (run_res != EI_IMPULSE_OK) {
+        return run_res;
+    }
+
+    return run_anomaly(&features_matrix, result, debug);
+}
+
+#if !EI_CLASSIFIER_OBJECT_DETECTION
+/**
+ * Run the classifier over several signals on a batched EON session owned by
+ * the caller. DSP runs per signal, after which up to the session's batch_size
+ * windows are stacked and every layer of the network runs once per stack.
+ * Keeping the session open across calls keeps the model prepared.
+ * @param session Session opened with ei_eon_session_open() and a batch_size
+ * @param signals Array of n raw signals
+ * @param n Number of signals
+ * @param results Array of n objects to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_batch_session(
+    ei_eon_session_t *session,
+    signal_t *signals,
+    size_t n,
+    ei_impulse_result_t *results,
+    bool debug = false)
+{
+    if (n == 0) {
+        return EI_IMPULSE_OK;
+    }
+
+    // The stats of the whole batch go to the first result
+    EI_DSP_ALLOC_STATS_SCOPE(&results[0].alloc_stats);
+
+    memset(results, 0, n * sizeof(ei_impulse_result_t));
+
+    ei::matrix_t features_matrix(n, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+    if (!features_matrix.buffer) {
+        return EI_IMPULSE_ALLOC_FAILED;
+    }
+
+    for (size_t ix = 0; ix < n; ix++) {
+        ei::matrix_t row(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, features_matrix.get_row_ptr(ix));
+
+        EI_IMPULSE_ERROR dsp_res = run_dsp_blocks(&signals[ix], &row, &results[ix], debug);
+        if (dsp_res != EI_IMPULSE_OK) {
+            return dsp_res;
+        }
+    }
+
+    EI_IMPULSE_ERROR run_res = run_nn_inference_batch(session, &features_matrix, results, debug);
+    if (run_res != EI_IMPULSE_OK) {
+        return run_res;
+    }
+
+    for (size_t ix = 0; ix < n; ix++) {
+        ei::matrix_t row(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, features_matrix.get_row_ptr(ix));
+
+        EI_IMPULSE_ERROR anomaly_res = run_anomaly(&row, &results[ix], debug);
+        if (anomaly_res != EI_IMPULSE_OK) {
+            return anomaly_res;
+        }
+    }
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Run the classifier over several signals, e.g. windows from a dataset, with
+ * up to EI_CLASSIFIER_MAX_BATCH_SIZE windows per invoke (see
+ * run_classifier_batch_session()). The batched session is opened on the first
+ * call and reused until run_classifier_deinit().
+ * @param signals Array of n raw signals
+ * @param n Number of signals
+ * @param results Array of n objects to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+extern "C" EI_IMPULSE_ERROR run_classifier_batch(
+    signal_t *signals,
+    size_t n,
+    ei_impulse_result_t *results,
+    bool debug = false)
+{
+    if (n == 0) {
+        return EI_IMPULSE_OK;
+    }
+
+    if (!classifier_batch_session.is_open) {
+        classifier_batch_session.batch_size = EI_CLASSIFIER_MAX_BATCH_SIZE;
+        EI_IMPULSE_ERROR open_res = ei_eon_session_open(&classifier_batch_session);
+        if (open_res != EI_IMPULSE_OK) {
+            return open_res;
+        }
+    }
+
+    return run_classifier_batch_session(&classifier_batch_session, signals, n, results, debug);
+}
+#endif // !EI_CLASSIFIER_OBJECT_DETECTION
+#endif // EI_CLASSIFIER_COMPILED == 1
+
+/**
+ * @brief      Run one DSP block over a signal of any type. Raw and flatten
+ *             blocks take the signal as is, other blocks get it wrapped in a
+ *             signal_t.
+ *
+ * @return     The DSP error code.
+ */
+template<typename SignalT>
+static int run_dsp_block(SignalT *signal, ei_model_dsp_t *block, ei::matrix_t *fm)
+{
+    if (block->extract_fn == &extract_raw_features) {
+        return extract_raw_features_generic(signal, fm, block->config, EI_CLASSIFIER_FREQUENCY);
+    }
+    if (block->extract_fn == &extract_flatten_features) {
+        return extract_flatten_features_generic(signal, fm, block->config, EI_CLASSIFIER_FREQUENCY);
+    }
+
+#if EIDSP_SIGNAL_C_FN_POINTER
+    ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER only supports raw and flatten blocks for this signal type\n");
+    return EIDSP_NOT_SUPPORTED;
+#else
+    signal_t wrapped_signal;
+    signal_from(signal, &wrapped_signal);
+    return block->extract_fn(&wrapped_signal, fm, block->config, EI_CLASSIFIER_FREQUENCY);
+#endif
+}
+
+/**
+ * @brief      Run one DSP block over a signal_t, which every block takes as is
+ *
+ * @return     The DSP error code.
+ */
+static int run_dsp_block(signal_t *signal, ei_model_dsp_t *block, ei::matrix_t *fm)
+{
+    return block->extract_fn(signal, fm, block->config, EI_CLASSIFIER_FREQUENCY);
+}
+
+/**
+ * @brief      Run all DSP blocks of the impulse over a signal of any type,
+ *             without timing or debug output (see run_dsp_blocks())
+ *
+ * @param      signal           Raw signal
+ * @param      features_matrix  Output features, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE wide
+ *
+ * @return     The ei impulse error.
+ */
+template<typename SignalT>
+static EI_IMPULSE_ERROR extract_dsp_blocks(SignalT *signal, ei::matrix_t *features_matrix)
+{
     size_t out_features_index = 0;
 
     for (size_t ix = 0; ix < ei_dsp_blocks_size; ix++) {
@@ -450,18 +954,16 @@ extern "C" EI_IMPULSE_ERROR run_classifier(
             return EI_IMPULSE_DSP_ERROR;
         }
 
-        ei::matrix_t fm(1, block.n_output_features, features_matrix.buffer + out_features_index);
+        ei::matrix_t fm(1, block.n_output_features, features_matrix->buffer + out_features_index);
 
-#if EIDSP_SIGNAL_C_FN_POINTER
-        if (block.axes_size != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
-            ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER can only be used when all axes are selected for DSP blocks\n");
-            return EI_IMPULSE_DSP_ERROR;
+        int ret;
+        if (block.axes_size == EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+            ret = run_dsp_block(signal, &block, &fm);
+        }
+        else {
+            SignalAxes<SignalT> axes_signal(signal, block.axes, block.axes_size);
+            ret = run_dsp_block(&axes_signal, &block, &fm);
         }
-        int ret = block.extract_fn(signal, &fm, block.config, EI_CLASSIFIER_FREQUENCY);
-#else
-        SignalWithAxes swa(signal, block.axes, block.axes_size);
-        int ret = block.extract_fn(swa.get_signal(), &fm, block.config, EI_CLASSIFIER_FREQUENCY);
-#endif
 
         if (ret != EIDSP_OK) {
             ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
@@ -475,25 +977,71 @@ extern "C" EI_IMPULSE_ERROR run_classifier(
         out_features_index += block.n_output_features;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Run all DSP blocks of the impulse over the signal
+ *
+ * @param      signal           Raw signal (signal_t or any other signal type)
+ * @param      features_matrix  Output features, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE wide
+ * @param      result           Output classifier results (DSP timing is set)
+ * @param[in]  debug            Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+template<typename SignalT>
+static EI_IMPULSE_ERROR run_dsp_blocks(
+    SignalT *signal,
+    ei::matrix_t *features_matrix,
+    ei_impulse_result_t *result,
+    bool debug)
+{
+    uint64_t dsp_start_ns = ei_read_timer_ns();
+
+    EI_IMPULSE_ERROR res;
+
+#if !EIDSP_SIGNAL_C_FN_POINTER
+    // With several blocks, fetch the window once and let every block read
+    // from memory instead of going back to the signal (up to a size limit,
+    // audio windows are usually too big to copy)
+    bool share_window = ei_dsp_blocks_size > 1 &&
+        signal->total_length <= EI_CLASSIFIER_DSP_SHARED_WINDOW_MAX_SIZE;
+    float no_window;
+    ei::matrix_t shared_window(1, share_window ? signal->total_length : 0,
+        share_window ? NULL : &no_window);
+    if (share_window && shared_window.buffer) {
+        int ret = signal->get_data(0, signal->total_length, shared_window.buffer);
+        if (ret != EIDSP_OK) {
+            ei_printf("ERR: Failed to run DSP process (%d)\n", ret);
+            return EI_IMPULSE_DSP_ERROR;
+        }
+        SignalSpan shared_signal(shared_window.buffer, signal->total_length);
+        res = extract_dsp_blocks(&shared_signal, features_matrix);
+    }
+    else
+#endif
+    {
+        res = extract_dsp_blocks(signal, features_matrix);
+    }
+    if (res != EI_IMPULSE_OK) {
+        return res;
+    }
+
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
         ei_printf("Features (%d ms.): ", result->timing.dsp);
-        for (size_t ix = 0; ix < features_matrix.cols; ix++) {
-            ei_printf_float(features_matrix.buffer[ix]);
+        for (size_t ix = 0; ix < features_matrix->cols; ix++) {
+            ei_printf_float(features_matrix->buffer[ix]);
             ei_printf(" ");
         }
         ei_printf("\n");
     }
 
-#if EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_NONE
-    if (debug) {
-        ei_printf("Running neural network...\n");
-    }
-#endif
-
-    return run_inference(&features_matrix, result, debug);
+    return EI_IMPULSE_OK;
 }
 
 
@@ -659,6 +1207,8 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
     ei_impulse_result_t *result,
     bool debug = false)
 {
+    EI_DSP_ALLOC_STATS_SCOPE(&result->alloc_stats);
+
     EI_IMPULSE_ERROR verify_res = can_run_classifier_image_quantized();
     if (verify_res != EI_IMPULSE_OK) {
         return verify_res;
@@ -679,7 +1229,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
 #elif (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW)
 
     uint64_t ctx_start_us;
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     ei::matrix_i8_t features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
     processed_features = (int8_t *) features_matrix.buffer;
@@ -695,7 +1245,8 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
         return EI_IMPULSE_CANCELED;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
@@ -738,7 +1289,7 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
 #elif (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI)
     static bool first_run = true;
     uint64_t ctx_start_us;
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     if (first_run) {
         // map memory regions to the DRP-AI UDMA. This is required for passing data
@@ -778,7 +1329,8 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
         return EI_IMPULSE_CANCELED;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     //if (debug) {
@@ -837,10 +1389,99 @@ extern "C" EI_IMPULSE_ERROR run_classifier_image_quantized(
 #endif // (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI)
 }
 
+/**
+ * run_classifier_image_quantized() over a signal of any type, the image block
+ * only takes a signal_t so the signal is wrapped in one.
+ */
+template<typename SignalT>
+EI_IMPULSE_ERROR run_classifier_image_quantized(
+    SignalT *signal,
+    ei_impulse_result_t *result,
+    bool debug)
+{
+#if EIDSP_SIGNAL_C_FN_POINTER
+    ei_printf("ERR: EIDSP_SIGNAL_C_FN_POINTER only supports signal_t for image models\n");
+    return EI_IMPULSE_DSP_ERROR;
+#else
+    signal_t wrapped_signal;
+    signal_from(signal, &wrapped_signal);
+    return run_classifier_image_quantized(&wrapped_signal, result, debug);
+#endif
+}
+
 #endif // #if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1 && (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSAIFLOW || EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_DRPAI)
 
 #if EIDSP_SIGNAL_C_FN_POINTER == 0
 
+/**
+ * Run the classifier over raw data in a contiguous buffer. For impulses with
+ * a single raw block on all axes the buffer is scaled and quantized straight
+ * into the model input, other impulses go through run_classifier().
+ * @param raw_features Raw data (EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE values)
+ * @param raw_features_size Number of values in the buffer
+ * @param result Object to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_f32(
+    const float *raw_features,
+    size_t raw_features_size,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    EI_DSP_ALLOC_STATS_SCOPE(&result->alloc_stats);
+
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+    if (can_run_classifier_raw_input() && raw_features_size == EI_CLASSIFIER_NN_INPUT_FRAME_SIZE &&
+            ei_dsp_blocks[0].axes_size == EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+        memset(result, 0, sizeof(ei_impulse_result_t));
+        ei_dsp_config_raw_t *config = (ei_dsp_config_raw_t *)ei_dsp_blocks[0].config;
+        return run_nn_inference_contiguous(&eon_default_session, raw_features, config->scale_axes, result, debug);
+    }
+#endif
+
+    SignalSpan signal(raw_features, raw_features_size);
+    return run_classifier(&signal, result, debug);
+}
+
+/**
+ * Run the classifier over raw int16 data in a contiguous buffer (e.g. straight
+ * from a sensor FIFO). Same as run_classifier_f32(), other impulses than a
+ * single raw block convert the buffer to float first.
+ * @param raw_features Raw data (EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE values)
+ * @param raw_features_size Number of values in the buffer
+ * @param result Object to store the results in
+ * @param debug Whether to show debug messages (default: false)
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR run_classifier_i16(
+    const int16_t *raw_features,
+    size_t raw_features_size,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    EI_DSP_ALLOC_STATS_SCOPE(&result->alloc_stats);
+
+#if EI_CLASSIFIER_HAS_RAW_INPUT_STREAM == 1
+    if (can_run_classifier_raw_input() && raw_features_size == EI_CLASSIFIER_NN_INPUT_FRAME_SIZE &&
+            ei_dsp_blocks[0].axes_size == EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+        memset(result, 0, sizeof(ei_impulse_result_t));
+        ei_dsp_config_raw_t *config = (ei_dsp_config_raw_t *)ei_dsp_blocks[0].config;
+        return run_nn_inference_contiguous(&eon_default_session, raw_features, config->scale_axes, result, debug);
+    }
+#endif
+
+    float *x = (float*)ei_dsp_malloc(raw_features_size * sizeof(float));
+    if (!x) {
+        return EI_IMPULSE_OUT_OF_MEMORY;
+    }
+    for (size_t ix = 0; ix < raw_features_size; ix++) {
+        x[ix] = static_cast<float>(raw_features[ix]);
+    }
+
+    EI_IMPULSE_ERROR r = run_classifier_f32(x, raw_features_size, result, debug);
+    ei_dsp_free(x, raw_features_size * sizeof(float));
+    return r;
+}
+
 /**
  * Run the impulse, if you provide an instance of sampler it will also persist the data for you
  * @param sampler Instance to an **initialized** sampler
@@ -866,6 +1507,8 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_impulse(
     }
 
     uint64_t next_tick = 0;
+    uint64_t prev_us = 0;
+    int64_t sampling_jitter_us = 0;
 
     uint64_t sampling_us_start = ei_read_timer_us();
 
@@ -873,6 +1516,18 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_impulse(
     for (int i = 0; i < EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE; i += EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
         uint64_t curr_us = ei_read_timer_us() - sampling_us_start;
 
+        // deviation of the time between samples from the interval
+        if (i > 0) {
+            int64_t jitter_us = (int64_t)(curr_us - prev_us) - (int64_t)(EI_CLASSIFIER_INTERVAL_MS * 1000);
+            if (jitter_us < 0) {
+                jitter_us = -jitter_us;
+            }
+            if (jitter_us > sampling_jitter_us) {
+                sampling_jitter_us = jitter_us;
+            }
+        }
+        prev_us = curr_us;
+
         next_tick = curr_us + (EI_CLASSIFIER_INTERVAL_MS * 1000);
 
         data_fn(x + i, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
@@ -890,7 +1545,7 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_impulse(
         while (next_tick > ei_read_timer_us() - sampling_us_start);
     }
 
-    result->timing.sampling = (ei_read_timer_us() - sampling_us_start) / 1000;
+    int64_t sampling_us = (int64_t)(ei_read_timer_us() - sampling_us_start);
 
     signal_t signal;
     int err = numpy::signal_from_buffer(x, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal);
@@ -902,6 +1557,12 @@ __attribute__((unused)) EI_IMPULSE_ERROR run_impulse(
 
     EI_IMPULSE_ERROR r = run_classifier(&signal, result, debug);
     free(x);
+
+    // run_classifier() clears the result, fill in the sampling time after
+    result->timing.sampling_us = sampling_us;
+    result->timing.sampling = (int)(sampling_us / 1000);
+    result->timing.sampling_jitter_us = sampling_jitter_us;
+
     return r;
 }
 
@@ -26,7 +26,9 @@
 #include "model-parameters/model_metadata.h"
 #include "edge-impulse-sdk/dsp/spectral/spectral.hpp"
 #include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+#include "edge-impulse-sdk/dsp/numpy_simd.hpp"
 #include "edge-impulse-sdk/classifier/ei_signal_with_range.h"
+#include "edge-impulse-sdk/classifier/ei_signal_span.h"
 
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
 extern "C" {
@@ -51,6 +53,279 @@ static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
 
+// per-slice moments of the flatten block, one entry per slice and axis, kept as a ring
+// over the last EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW slices for continuous classification
+typedef struct {
+    size_t count;
+    double mean;
+    double m2;
+    double m3;
+    double m4;
+    double sum_squares;
+    float min;
+    float max;
+} ei_dsp_flatten_moments_t;
+
+static ei_dsp_flatten_moments_t *ei_dsp_cont_flatten_moments = nullptr;
+static const void *ei_dsp_cont_flatten_config = nullptr;
+static size_t ei_dsp_cont_flatten_ix = 0;
+static size_t ei_dsp_cont_flatten_slices = 0;
+
+// the flatten moments kernel keeps per-lane accumulators on the stack for up to this many
+// axes, signals with more axes take the scalar path
+#define EI_DSP_FLATTEN_SIMD_MAX_AXES    12
+
+// stripes summed in float before they are added to the double sums of the flatten moments
+#define EI_DSP_FLATTEN_FLOAT_BLOCK      8
+
+/**
+ * Moments of every axis of an interleaved signal (rows x axes, the layout the flatten
+ * block gets) in two passes, without transposing it. Values are multiplied by scale
+ * on the way in.
+ *
+ * The buffer is walked in stripes of lcm(axes, 4) values, so lane j of vector k of a
+ * stripe always holds axis (4 * k + j) % axes. The first pass sums the values and
+ * tracks min and max, to get the mean of each axis. The second pass sums the powers of
+ * the values shifted by that (float) mean, which keeps the cancellation small. Sums are
+ * kept in float over blocks of EI_DSP_FLATTEN_FLOAT_BLOCK stripes and then added to
+ * double sums, which are turned into central moments at the end. Rows that don't fill
+ * a stripe take the scalar path.
+ */
+static void ei_dsp_flatten_compute_moments(const float *buffer, size_t rows, size_t axes, float scale,
+    ei_dsp_flatten_moments_t *moments)
+{
+    // while accumulating, sum_squares holds the shift (the mean of the axis), and mean
+    // and m2..m4 hold the sums of the 1st to 4th powers of (value - shift)
+    memset(moments, 0, axes * sizeof(ei_dsp_flatten_moments_t));
+    for (size_t axis = 0; axis < axes; axis++) {
+        moments[axis].min = FLT_MAX;
+        moments[axis].max = -FLT_MAX;
+    }
+
+    if (rows == 0) {
+        return;
+    }
+
+    const double n = (double)rows;
+
+    size_t stripe = 0;
+    size_t vecs = 0;
+    size_t stripe_rows = 0;
+    // rows in whole stripes, the rest take the scalar path
+    size_t simd_rows = 0;
+
+    if (axes <= EI_DSP_FLATTEN_SIMD_MAX_AXES) {
+        stripe = axes;
+        while (stripe % 4 != 0) {
+            stripe += axes;
+        }
+        vecs = stripe / 4;
+        stripe_rows = stripe / axes;
+        simd_rows = (rows / stripe_rows) * stripe_rows;
+    }
+
+    float lanes[EI_DSP_FLATTEN_SIMD_MAX_AXES * 4];
+    float t1[4], t2[4], t3[4], t4[4];
+    ei_dsp_f32x4_t shift[EI_DSP_FLATTEN_SIMD_MAX_AXES];
+    ei_dsp_f32x4_t vmin[EI_DSP_FLATTEN_SIMD_MAX_AXES];
+    ei_dsp_f32x4_t vmax[EI_DSP_FLATTEN_SIMD_MAX_AXES];
+    ei_dsp_f32x4_t s1[EI_DSP_FLATTEN_SIMD_MAX_AXES];
+    ei_dsp_f32x4_t s2[EI_DSP_FLATTEN_SIMD_MAX_AXES];
+    ei_dsp_f32x4_t s3[EI_DSP_FLATTEN_SIMD_MAX_AXES];
+    ei_dsp_f32x4_t s4[EI_DSP_FLATTEN_SIMD_MAX_AXES];
+
+    const ei_dsp_f32x4_t vscale = ei_dsp_f32x4_set1(scale);
+    const ei_dsp_f32x4_t zero = ei_dsp_f32x4_set1(0.0f);
+
+    // first pass: sum, min and max
+    if (simd_rows > 0) {
+        for (size_t k = 0; k < vecs; k++) {
+            vmin[k] = ei_dsp_f32x4_set1(FLT_MAX);
+            vmax[k] = ei_dsp_f32x4_set1(-FLT_MAX);
+        }
+
+        size_t row = 0;
+        while (row < simd_rows) {
+            for (size_t k = 0; k < vecs; k++) {
+                s1[k] = zero;
+            }
+
+            for (size_t block = 0; block < EI_DSP_FLATTEN_FLOAT_BLOCK && row < simd_rows; block++) {
+                const float *p = buffer + (row * axes);
+                for (size_t k = 0; k < vecs; k++) {
+                    ei_dsp_f32x4_t x = ei_dsp_f32x4_mul(ei_dsp_f32x4_load(p + (k * 4)), vscale);
+                    vmin[k] = ei_dsp_f32x4_min(x, vmin[k]);
+                    vmax[k] = ei_dsp_f32x4_max(x, vmax[k]);
+                    s1[k] = ei_dsp_f32x4_add(s1[k], x);
+                }
+                row += stripe_rows;
+            }
+
+            // add the block to the double sums of each lane's axis
+            for (size_t k = 0; k < vecs; k++) {
+                ei_dsp_f32x4_store(t1, s1[k]);
+                for (size_t j = 0; j < 4; j++) {
+                    moments[((k * 4) + j) % axes].sum_squares += t1[j];
+                }
+            }
+        }
+
+        for (size_t k = 0; k < vecs; k++) {
+            ei_dsp_f32x4_store(t1, vmin[k]);
+            ei_dsp_f32x4_store(t2, vmax[k]);
+            for (size_t j = 0; j < 4; j++) {
+                ei_dsp_flatten_moments_t *m = &moments[((k * 4) + j) % axes];
+                if (t1[j] < m->min) m->min = t1[j];
+                if (t2[j] > m->max) m->max = t2[j];
+            }
+        }
+    }
+
+    for (size_t row = simd_rows; row < rows; row++) {
+        for (size_t axis = 0; axis < axes; axis++) {
+            ei_dsp_flatten_moments_t *m = &moments[axis];
+            float x = buffer[(row * axes) + axis] * scale;
+            if (x < m->min) m->min = x;
+            if (x > m->max) m->max = x;
+            m->sum_squares += x;
+        }
+    }
+
+    for (size_t axis = 0; axis < axes; axis++) {
+        moments[axis].sum_squares = (float)(moments[axis].sum_squares / n);
+    }
+
+    // second pass: powers of the shifted values
+    if (simd_rows > 0) {
+        for (size_t ix = 0; ix < stripe; ix++) {
+            lanes[ix] = (float)moments[ix % axes].sum_squares;
+        }
+        for (size_t k = 0; k < vecs; k++) {
+            shift[k] = ei_dsp_f32x4_load(lanes + (k * 4));
+        }
+
+        size_t row = 0;
+        while (row < simd_rows) {
+            for (size_t k = 0; k < vecs; k++) {
+                s1[k] = zero;
+                s2[k] = zero;
+                s3[k] = zero;
+                s4[k] = zero;
+            }
+
+            for (size_t block = 0; block < EI_DSP_FLATTEN_FLOAT_BLOCK && row < simd_rows; block++) {
+                const float *p = buffer + (row * axes);
+                for (size_t k = 0; k < vecs; k++) {
+                    ei_dsp_f32x4_t x = ei_dsp_f32x4_mul(ei_dsp_f32x4_load(p + (k * 4)), vscale);
+                    ei_dsp_f32x4_t d = ei_dsp_f32x4_sub(x, shift[k]);
+                    ei_dsp_f32x4_t d2 = ei_dsp_f32x4_mul(d, d);
+                    s1[k] = ei_dsp_f32x4_add(s1[k], d);
+                    s2[k] = ei_dsp_f32x4_add(s2[k], d2);
+                    s3[k] = ei_dsp_f32x4_add(s3[k], ei_dsp_f32x4_mul(d2, d));
+                    s4[k] = ei_dsp_f32x4_add(s4[k], ei_dsp_f32x4_mul(d2, d2));
+                }
+                row += stripe_rows;
+            }
+
+            for (size_t k = 0; k < vecs; k++) {
+                ei_dsp_f32x4_store(t1, s1[k]);
+                ei_dsp_f32x4_store(t2, s2[k]);
+                ei_dsp_f32x4_store(t3, s3[k]);
+                ei_dsp_f32x4_store(t4, s4[k]);
+                for (size_t j = 0; j < 4; j++) {
+                    ei_dsp_flatten_moments_t *m = &moments[((k * 4) + j) % axes];
+                    m->mean += t1[j];
+                    m->m2 += t2[j];
+                    m->m3 += t3[j];
+                    m->m4 += t4[j];
+                }
+            }
+        }
+    }
+
+    for (size_t row = simd_rows; row < rows; row++) {
+        for (size_t axis = 0; axis < axes; axis++) {
+            ei_dsp_flatten_moments_t *m = &moments[axis];
+            double d = (buffer[(row * axes) + axis] * scale) - (float)m->sum_squares;
+            double d2 = d * d;
+            m->mean += d;
+            m->m2 += d2;
+            m->m3 += d2 * d;
+            m->m4 += d2 * d2;
+        }
+    }
+
+    // shifted power sums to central moments
+    for (size_t axis = 0; axis < axes; axis++) {
+        ei_dsp_flatten_moments_t *m = &moments[axis];
+        const double shift = m->sum_squares;
+        const double sum1 = m->mean;
+        const double sum2 = m->m2;
+        const double sum3 = m->m3;
+        const double sum4 = m->m4;
+        const double c = sum1 / n;
+
+        m->count = rows;
+        m->mean = shift + c;
+        m->m2 = sum2 - (c * sum1);
+        m->m3 = sum3 - (3.0 * c * sum2) + (2.0 * n * c * c * c);
+        m->m4 = sum4 - (4.0 * c * sum3) + (6.0 * c * c * sum2) - (3.0 * n * c * c * c * c);
+        m->sum_squares = sum2 + (2.0 * shift * sum1) + (n * shift * shift);
+
+        // rounding can leave a tiny negative variance for a constant axis
+        if (m->m2 < 0.0) {
+            m->m2 = 0.0;
+        }
+    }
+}
+
+/**
+ * Write the enabled flatten features of one axis from its moments, returns the number
+ * of features written
+ */
+static size_t ei_dsp_flatten_write_features(const ei_dsp_config_flatten_t *config,
+    const ei_dsp_flatten_moments_t *m, float *out)
+{
+    size_t fx = 0;
+
+    double n = m->count > 0 ? (double)m->count : 1.0;
+    double variance = m->m2 / n;
+
+    if (config->average) {
+        out[fx++] = (float)m->mean;
+    }
+
+    if (config->minimum) {
+        out[fx++] = m->min;
+    }
+
+    if (config->maximum) {
+        out[fx++] = m->max;
+    }
+
+    if (config->rms) {
+        out[fx++] = (float)sqrt(m->sum_squares / n);
+    }
+
+    if (config->stdev) {
+        out[fx++] = (float)sqrt(variance);
+    }
+
+    if (config->skewness) {
+        // skew = (m_3) / (m_2)^(3/2)
+        out[fx++] = variance == 0.0 ?
+            0.0f : (float)((m->m3 / n) / sqrt(variance * variance * variance));
+    }
+
+    if (config->kurtosis) {
+        // Fisher kurtosis = (m_4 / variance^2) - 3
+        out[fx++] = variance == 0.0 ?
+            -3.0f : (float)(((m->m4 / n) / (variance * variance)) - 3.0);
+    }
+
+    return fx;
+}
+
 __attribute__((unused)) int extract_spectral_analysis_features(
     signal_t *signal,
     matrix_t *output_matrix,
@@ -85,7 +360,12 @@ __attribute__((unused)) int extract_spectral_analysis_features(
     return EIDSP_NOT_SUPPORTED;
 }
 
-__attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+/**
+ * Raw block for any signal type (see ei_signal_span.h), extract_raw_features()
+ * runs this with a signal_t
+ */
+template<typename SignalT>
+int extract_raw_features_generic(SignalT *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
 
     // input matrix from the raw signal
@@ -115,8 +395,57 @@ __attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *out
     return EIDSP_OK;
 }
 
+__attribute__((unused)) int extract_raw_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    return extract_raw_features_generic(signal, output_matrix, config_ptr, frequency);
+}
+
 
-__attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+/**
+ * Raw block for continuous classification. The output matrix holds the whole window,
+ * it's rolled back by the length of the slice and the scaled slice is written at the end.
+ */
+__attribute__((unused)) int extract_raw_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency, matrix_size_t *matrix_size_out) {
+    ei_dsp_config_raw_t config = *((ei_dsp_config_raw_t*)config_ptr);
+
+    size_t output_size = output_matrix->rows * output_matrix->cols;
+    if (signal->total_length > output_size) {
+        ei_printf("ERR: slice (%d) cannot be larger than the window (%d) for continuous classification\n",
+            (int)signal->total_length, (int)output_size);
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    // we roll the output matrix back so we have room at the end...
+    int ret = numpy::roll(output_matrix->buffer, output_size, -(int)signal->total_length);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    matrix_t slice_matrix(signal->total_length / config.axes, config.axes,
+        output_matrix->buffer + (output_size - signal->total_length));
+
+    ret = signal->get_data(0, signal->total_length, slice_matrix.buffer);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    // scale the signal
+    ret = numpy::scale(&slice_matrix, config.scale_axes);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    matrix_size_out->rows = slice_matrix.rows;
+    matrix_size_out->cols = slice_matrix.cols;
+
+    return EIDSP_OK;
+}
+
+/**
+ * Flatten block for any signal type (see ei_signal_span.h),
+ * extract_flatten_features() runs this with a signal_t
+ */
+template<typename SignalT>
+int extract_flatten_features_generic(SignalT *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
     ei_dsp_config_flatten_t config = *((ei_dsp_config_flatten_t*)config_ptr);
 
     uint32_t expected_matrix_size = 0;
@@ -132,87 +461,156 @@ __attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t
         EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
     }
 
-    int ret;
-
-    // input matrix from the raw signal
+    // input matrix from the raw signal, one row per reading and one column per axis
     matrix_t input_matrix(signal->total_length / config.axes, config.axes);
     if (!input_matrix.buffer) {
         EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
     signal->get_data(0, signal->total_length, input_matrix.buffer);
 
-    // scale the signal
-    ret = numpy::scale(&input_matrix, config.scale_axes);
-    if (ret != EIDSP_OK) {
-        ei_printf("ERR: Failed to scale signal (%d)\n", ret);
-        EIDSP_ERR(ret);
+    // moments of all axes straight from the interleaved signal (scaled on the fly)
+    size_t moments_size = config.axes * sizeof(ei_dsp_flatten_moments_t);
+    ei_dsp_flatten_moments_t *moments = (ei_dsp_flatten_moments_t*)ei_dsp_malloc(moments_size);
+    if (!moments) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
     }
 
-    // transpose the matrix so we have one row per axis (nifty!)
-    ret = numpy::transpose(&input_matrix);
-    if (ret != EIDSP_OK) {
-        ei_printf("ERR: Failed to transpose matrix (%d)\n", ret);
-        EIDSP_ERR(ret);
-    }
+    ei_dsp_flatten_compute_moments(input_matrix.buffer, input_matrix.rows, input_matrix.cols,
+        config.scale_axes, moments);
 
     size_t out_matrix_ix = 0;
+    for (int axis = 0; axis < config.axes; axis++) {
+        out_matrix_ix += ei_dsp_flatten_write_features(&config, &moments[axis],
+            output_matrix->buffer + out_matrix_ix);
+    }
 
-    for (size_t row = 0; row < input_matrix.rows; row++) {
-        matrix_t row_matrix(1, input_matrix.cols, input_matrix.buffer + (row * input_matrix.cols));
+    ei_dsp_free(moments, moments_size);
 
-        if (config.average) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::mean(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
-        }
+    // flatten again
+    output_matrix->cols = output_matrix->rows * output_matrix->cols;
+    output_matrix->rows = 1;
 
-        if (config.minimum) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::min(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
-        }
+    return EIDSP_OK;
+}
 
-        if (config.maximum) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::max(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
-        }
+__attribute__((unused)) int extract_flatten_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency) {
+    return extract_flatten_features_generic(signal, output_matrix, config_ptr, frequency);
+}
 
-        if (config.rms) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::rms(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
-        }
+/**
+ * Merge the moments of b into a (Chan / Pebay pairwise update)
+ */
+static void ei_dsp_flatten_merge_moments(ei_dsp_flatten_moments_t *a, const ei_dsp_flatten_moments_t *b) {
+    if (b->count == 0) {
+        return;
+    }
+    if (a->count == 0) {
+        *a = *b;
+        return;
+    }
+
+    double na = (double)a->count;
+    double nb = (double)b->count;
+    double n = na + nb;
+    double delta = b->mean - a->mean;
+    double delta2 = delta * delta;
+
+    double m2 = a->m2 + b->m2 + delta2 * na * nb / n;
+    double m3 = a->m3 + b->m3 + delta * delta2 * na * nb * (na - nb) / (n * n) +
+        3.0 * delta * (na * b->m2 - nb * a->m2) / n;
+    double m4 = a->m4 + b->m4 + delta2 * delta2 * na * nb * (na * na - na * nb + nb * nb) / (n * n * n) +
+        6.0 * delta2 * (na * na * b->m2 + nb * nb * a->m2) / (n * n) +
+        4.0 * delta * (na * b->m3 - nb * a->m3) / n;
+
+    a->mean += delta * nb / n;
+    a->m2 = m2;
+    a->m3 = m3;
+    a->m4 = m4;
+    a->count += b->count;
+    a->sum_squares += b->sum_squares;
+    a->min = b->min < a->min ? b->min : a->min;
+    a->max = b->max > a->max ? b->max : a->max;
+}
 
-        if (config.stdev) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::stdev(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
-        }
+/**
+ * Flatten block for continuous classification. Only the new slice is visited, its moments
+ * are stored in a ring of EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW slices and merged into the
+ * statistics of the window. Merging slices rounds differently from one pass over the
+ * window, so the features can differ from extract_flatten_features() in the last bits.
+ * matrix_size_out stays empty until a full window has been seen.
+ */
+__attribute__((unused)) int extract_flatten_per_slice_features(signal_t *signal, matrix_t *output_matrix, void *config_ptr, const float frequency, matrix_size_t *matrix_size_out) {
+    ei_dsp_config_flatten_t config = *((ei_dsp_config_flatten_t*)config_ptr);
+
+    uint32_t expected_matrix_size = 0;
+    if (config.average) expected_matrix_size += config.axes;
+    if (config.minimum) expected_matrix_size += config.axes;
+    if (config.maximum) expected_matrix_size += config.axes;
+    if (config.rms) expected_matrix_size += config.axes;
+    if (config.stdev) expected_matrix_size += config.axes;
+    if (config.skewness) expected_matrix_size += config.axes;
+    if (config.kurtosis) expected_matrix_size += config.axes;
+
+    if (output_matrix->rows * output_matrix->cols != expected_matrix_size) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
 
-        if (config.skewness) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::skew(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+    if (ei_dsp_cont_flatten_moments == nullptr) {
+        ei_dsp_cont_flatten_moments = (ei_dsp_flatten_moments_t*)ei_calloc(
+            EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW * config.axes, sizeof(ei_dsp_flatten_moments_t));
+        if (ei_dsp_cont_flatten_moments == nullptr) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
+        ei_dsp_cont_flatten_config = config_ptr;
+        ei_dsp_cont_flatten_ix = 0;
+        ei_dsp_cont_flatten_slices = 0;
+    }
+    else if (ei_dsp_cont_flatten_config != config_ptr) {
+        ei_printf("ERR: Only one flatten block is supported for continuous classification\n");
+        EIDSP_ERR(EIDSP_NOT_SUPPORTED);
+    }
+
+    // input matrix from the slice
+    matrix_t input_matrix(signal->total_length / config.axes, config.axes);
+    if (!input_matrix.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+    signal->get_data(0, signal->total_length, input_matrix.buffer);
+
+    // moments of the new slice (scaled on the fly) replace the oldest slice in the ring
+    ei_dsp_flatten_moments_t *slice_moments = ei_dsp_cont_flatten_moments + (ei_dsp_cont_flatten_ix * config.axes);
+
+    ei_dsp_flatten_compute_moments(input_matrix.buffer, input_matrix.rows, input_matrix.cols,
+        config.scale_axes, slice_moments);
+
+    ei_dsp_cont_flatten_ix = (ei_dsp_cont_flatten_ix + 1) % EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW;
+    if (ei_dsp_cont_flatten_slices < EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW) {
+        ei_dsp_cont_flatten_slices++;
+    }
+
+    matrix_size_out->rows = 0;
+    matrix_size_out->cols = 0;
+
+    if (ei_dsp_cont_flatten_slices < EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW) {
+        return EIDSP_OK;
+    }
+
+    size_t out_matrix_ix = 0;
 
-        if (config.kurtosis) {
-            float fbuffer;
-            matrix_t out_matrix(1, 1, &fbuffer);
-            numpy::kurtosis(&row_matrix, &out_matrix);
-            output_matrix->buffer[out_matrix_ix++] = out_matrix.buffer[0];
+    for (int axis = 0; axis < config.axes; axis++) {
+        // merge the slices from oldest to newest
+        ei_dsp_flatten_moments_t w;
+        memset(&w, 0, sizeof(ei_dsp_flatten_moments_t));
+        for (size_t ix = 0; ix < EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW; ix++) {
+            size_t slice_ix = (ei_dsp_cont_flatten_ix + ix) % EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW;
+            ei_dsp_flatten_merge_moments(&w, &ei_dsp_cont_flatten_moments[(slice_ix * config.axes) + axis]);
         }
+
+        out_matrix_ix += ei_dsp_flatten_write_features(&config, &w, output_matrix->buffer + out_matrix_ix);
     }
 
-    // flatten again
-    output_matrix->cols = output_matrix->rows * output_matrix->cols;
-    output_matrix->rows = 1;
+    matrix_size_out->rows = 1;
+    matrix_size_out->cols = out_matrix_ix;
 
     return EIDSP_OK;
 }
@@ -1345,7 +1743,7 @@ __attribute__((unused)) int extract_image_features_quantized(signal_t *signal, m
 #endif // (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1) && (EI_CLASSIFIER_INFERENCING_ENGINE != EI_CLASSIFIER_DRPAI)
 
 /**
- * Clear all state regarding continuous audio. Invoke this function after continuous audio loop ends.
+ * Clear all state regarding continuous classification (audio frames and flatten moments). Invoke this function after the continuous loop ends.
  */
 __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     if (ei_dsp_cont_current_frame) {
@@ -1356,6 +1754,15 @@ __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     ei_dsp_cont_current_frame_size = 0;
     ei_dsp_cont_current_frame_ix = 0;
 
+    if (ei_dsp_cont_flatten_moments) {
+        ei_free(ei_dsp_cont_flatten_moments);
+    }
+
+    ei_dsp_cont_flatten_moments = nullptr;
+    ei_dsp_cont_flatten_config = nullptr;
+    ei_dsp_cont_flatten_ix = 0;
+    ei_dsp_cont_flatten_slices = 0;
+
     return EIDSP_OK;
 }
 
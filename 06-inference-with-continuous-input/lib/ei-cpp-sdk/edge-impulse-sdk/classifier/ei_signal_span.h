@@ -0,0 +1,135 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EI_CLASSIFIER_SIGNAL_SPAN_H_
+#define _EI_CLASSIFIER_SIGNAL_SPAN_H_
+
+#include "edge-impulse-sdk/dsp/numpy_types.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "edge-impulse-sdk/dsp/returntypes.hpp"
+
+/**
+ * Statically dispatched signals.
+ *
+ * The templated run_classifier() and DSP functions accept any signal type
+ * with the same interface as signal_t:
+ *
+ *     size_t total_length;
+ *     int get_data(size_t offset, size_t length, float *out_ptr);
+ *
+ * For signal_t, get_data is a callback. For the types below it is a member
+ * function that the compiler can inline into the DSP code.
+ */
+
+using namespace ei;
+
+/**
+ * Signal over float data in memory. Value ix of the signal is
+ * data[ix * stride], so a stride picks one axis out of interleaved data.
+ */
+class SignalSpan {
+public:
+    SignalSpan(const float *data, size_t length, size_t stride = 1):
+        total_length(length), _data(data), _stride(stride)
+    {
+
+    }
+
+    int get_data(size_t offset, size_t length, float *out_ptr) const {
+        if (_stride == 1) {
+            memcpy(out_ptr, _data + offset, length * sizeof(float));
+            return 0;
+        }
+
+        const float *in_ptr = _data + offset * _stride;
+        for (size_t ix = 0; ix < length; ix++) {
+            out_ptr[ix] = in_ptr[ix * _stride];
+        }
+        return 0;
+    }
+
+    const float *data() const {
+        return _data;
+    }
+
+    size_t stride() const {
+        return _stride;
+    }
+
+    size_t total_length;
+
+private:
+    const float *_data;
+    size_t _stride;
+};
+
+/**
+ * Subset of the axes of an interleaved signal of any type (the templated
+ * counterpart of SignalWithAxes)
+ */
+template<typename SignalT>
+class SignalAxes {
+public:
+    SignalAxes(SignalT *original_signal, const uint8_t *axes, size_t axes_count):
+        total_length(original_signal->total_length / EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME * axes_count),
+        _original_signal(original_signal), _axes(axes), _axes_count(axes_count)
+    {
+
+    }
+
+    int get_data(size_t offset, size_t length, float *out_ptr) {
+        return numpy::signal_gather_axes(_original_signal, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME,
+            _axes, _axes_count, offset, length, out_ptr);
+    }
+
+    size_t total_length;
+
+private:
+    SignalT *_original_signal;
+    const uint8_t *_axes;
+    size_t _axes_count;
+};
+
+#if !EIDSP_SIGNAL_C_FN_POINTER
+/**
+ * Wrap a signal of any type in a signal_t, for DSP blocks that only take a
+ * signal_t. The signal must outlive the wrapper.
+ * @param signal Signal to wrap
+ * @param out_signal Output signal
+ * @returns EIDSP_OK if ok
+ */
+template<typename SignalT>
+int signal_from(SignalT *signal, signal_t *out_signal)
+{
+    out_signal->total_length = signal->total_length;
+#ifdef __MBED__
+    out_signal->get_data = mbed::callback(signal, &SignalT::get_data);
+#else
+    out_signal->get_data = [signal](size_t offset, size_t length, float *out_ptr) {
+        return signal->get_data(offset, length, out_ptr);
+    };
+#endif
+    return EIDSP_OK;
+}
+#endif // !EIDSP_SIGNAL_C_FN_POINTER
+
+#endif // _EI_CLASSIFIER_SIGNAL_SPAN_H_
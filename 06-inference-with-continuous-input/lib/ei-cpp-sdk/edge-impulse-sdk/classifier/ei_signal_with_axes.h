@@ -24,6 +24,7 @@
 #define _EI_CLASSIFIER_SIGNAL_WITH_AXES_H_
 
 #include "edge-impulse-sdk/dsp/numpy_types.h"
+#include "edge-impulse-sdk/dsp/numpy.hpp"
 #include "edge-impulse-sdk/dsp/returntypes.hpp"
 
 #if !EIDSP_SIGNAL_C_FN_POINTER
@@ -55,21 +56,9 @@ public:
     }
 
     int get_data(size_t offset, size_t length, float *out_ptr) {
-        size_t offset_on_original_signal = offset / _axes_count * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
-        size_t length_on_original_signal = length / _axes_count * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
-
-        size_t out_ptr_ix = 0;
-
-        for (size_t ix = offset_on_original_signal; ix < offset_on_original_signal + length_on_original_signal; ix += EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
-            for (size_t axis_ix = 0; axis_ix < this->_axes_count; axis_ix++) {
-                int r = _original_signal->get_data(ix + _axes[axis_ix], 1, &out_ptr[out_ptr_ix++]);
-                if (r != 0) {
-                    return r;
-                }
-            }
-        }
-
-        return 0;
+        // Fetch whole frames in chunks and pick the selected axes out of them
+        return numpy::signal_gather_axes(_original_signal, EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME,
+            _axes, _axes_count, offset, length, out_ptr);
     }
 
 private:
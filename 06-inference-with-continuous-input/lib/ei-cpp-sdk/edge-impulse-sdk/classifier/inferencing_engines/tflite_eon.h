@@ -60,10 +60,101 @@ static TfLiteRegistration post_process_op = tflite::ops::micro::Register_TFLite_
 
 #endif // defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
 
+/**
+ * Cost accounting for the EON model. Prepare covers trained_model_init()
+ * (arena allocation plus every kernel's Init/Prepare), invoke covers
+ * trained_model_invoke() only. Times are summed in nanoseconds, so short
+ * invokes don't lose their sub-microsecond part; divide by 1000 for us.
+ */
+typedef struct {
+    uint32_t prepare_count;
+    int64_t prepare_ns;
+    uint32_t invoke_count;
+    int64_t invoke_ns;
+} ei_eon_session_stats_t;
+
+/**
+ * Persistent EON session. While a session is open the tensor arena stays
+ * allocated and the kernels stay prepared, so every inference only pays for
+ * trained_model_invoke(). Without an open session the model is initialized
+ * and torn down on every call (the default).
+ *
+ * The default session runs the global model that run_classifier() uses.
+ * Any other session owns its own model instance (arena, tensors and nodes,
+ * weights are shared), so sessions can be used from different threads.
+ * Set batch_size before opening such a session to run up to that many
+ * windows per invoke (see run_nn_inference_batch()).
+ */
+typedef struct {
+    int batch_size;
+    bool is_open;
+    trained_model_instance_t *instance;
+    bool tensors_checked;
+    TfLiteTensor *input;
+    TfLiteTensor *output;
+#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
+    TfLiteTensor *output_labels;
+    TfLiteTensor *output_scores;
+#endif
+    ei_eon_session_stats_t stats;
+#if EI_CLASSIFIER_PROFILE_NODES
+    // Node timings of the last invoke
+    ei_model_profile_t profile;
+#endif
+} ei_eon_session_t;
+
+static ei_eon_session_t eon_default_session = { };
+
+static inline bool eon_session_is_default(ei_eon_session_t *session) {
+    return session == &eon_default_session;
+}
+
+/**
+ * Free the model (instance) that belongs to a session
+ */
+static void inference_tflite_teardown(ei_eon_session_t *session) {
+    if (eon_session_is_default(session)) {
+        trained_model_reset(ei_aligned_free);
+    }
+    else {
+        trained_model_instance_reset(session->instance, ei_aligned_free);
+        session->instance = NULL;
+    }
+}
+
+/**
+ * Initialize the model and record how long that took
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_prepare(ei_eon_session_t *session) {
+    // trained_model_instance_init() always allocates a new instance, free
+    // one that was left behind instead of losing it
+    if (!eon_session_is_default(session) && session->instance) {
+        inference_tflite_teardown(session);
+    }
+
+    uint64_t prepare_start_ns = ei_read_timer_ns();
+
+    TfLiteStatus init_status = eon_session_is_default(session) ?
+        trained_model_init(ei_aligned_calloc) :
+        trained_model_instance_init(&session->instance, session->batch_size > 1 ? session->batch_size : 1, ei_aligned_calloc);
+    if (init_status != kTfLiteOk) {
+        ei_printf("Failed to allocate TFLite arena (error code %d)\n", init_status);
+        inference_tflite_teardown(session);
+        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    }
+
+    session->stats.prepare_ns += (int64_t)(ei_read_timer_ns() - prepare_start_ns);
+    session->stats.prepare_count++;
+
+    return EI_IMPULSE_OK;
+}
 
 /**
  * Setup the TFLite runtime
  *
+ * @param      session            Session that owns the model
  * @param      ctx_start_us       Pointer to the start time
  * @param      input              Pointer to input tensor
  * @param      output             Pointer to output tensor
@@ -71,31 +162,50 @@ static TfLiteRegistration post_process_op = tflite::ops::micro::Register_TFLite_
  *
  * @return  EI_IMPULSE_OK if successful
  */
-static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTensor** input, TfLiteTensor** output,
+static EI_IMPULSE_ERROR inference_tflite_setup(ei_eon_session_t *session, uint64_t *ctx_start_us, TfLiteTensor** input, TfLiteTensor** output,
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
     TfLiteTensor** output_labels,
     TfLiteTensor** output_scores,
 #endif
     ei_unique_ptr_t& p_tensor_arena) {
-    TfLiteStatus init_status = trained_model_init(ei_aligned_calloc);
-    if (init_status != kTfLiteOk) {
-        ei_printf("Failed to allocate TFLite arena (error code %d)\n", init_status);
-        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    // The session already holds a prepared model, only hand out its tensors
+    if (session->is_open) {
+        *ctx_start_us = ei_read_timer_us();
+        *input = session->input;
+        *output = session->output;
+#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
+        *output_labels = session->output_labels;
+        *output_scores = session->output_scores;
+#endif
+        return EI_IMPULSE_OK;
     }
 
-    *ctx_start_us = ei_read_timer_us();
+    EI_IMPULSE_ERROR prepare_res = inference_tflite_prepare(session);
+    if (prepare_res != EI_IMPULSE_OK) {
+        return prepare_res;
+    }
 
-    static bool tflite_first_run = true;
+    *ctx_start_us = ei_read_timer_us();
 
-    *input = trained_model_input(EI_CLASSIFIER_TFLITE_OUTPUT_DATA_TENSOR);
-    *output = trained_model_output(EI_CLASSIFIER_TFLITE_OUTPUT_DATA_TENSOR);
+    if (eon_session_is_default(session)) {
+        *input = trained_model_input(EI_CLASSIFIER_TFLITE_OUTPUT_DATA_TENSOR);
+        *output = trained_model_output(EI_CLASSIFIER_TFLITE_OUTPUT_DATA_TENSOR);
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
-    *output_scores = trained_model_output(EI_CLASSIFIER_TFLITE_OUTPUT_SCORE_TENSOR);
-    *output_labels = trained_model_output(EI_CLASSIFIER_TFLITE_OUTPUT_LABELS_TENSOR);
+        *output_scores = trained_model_output(EI_CLASSIFIER_TFLITE_OUTPUT_SCORE_TENSOR);
+        *output_labels = trained_model_output(EI_CLASSIFIER_TFLITE_OUTPUT_LABELS_TENSOR);
 #endif // EI_CLASSIFIER_OBJECT_DETECTION
+    }
+    else {
+        *input = trained_model_instance_input(session->instance, EI_CLASSIFIER_TFLITE_OUTPUT_DATA_TENSOR);
+        *output = trained_model_instance_output(session->instance, EI_CLASSIFIER_TFLITE_OUTPUT_DATA_TENSOR);
+#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
+        *output_scores = trained_model_instance_output(session->instance, EI_CLASSIFIER_TFLITE_OUTPUT_SCORE_TENSOR);
+        *output_labels = trained_model_instance_output(session->instance, EI_CLASSIFIER_TFLITE_OUTPUT_LABELS_TENSOR);
+#endif // EI_CLASSIFIER_OBJECT_DETECTION
+    }
 
     // Assert that our quantization parameters match the model
-    if (tflite_first_run) {
+    if (!session->tensors_checked) {
         assert((*input)->type == EI_CLASSIFIER_TFLITE_INPUT_DATATYPE);
         assert((*output)->type == EI_CLASSIFIER_TFLITE_OUTPUT_DATATYPE);
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
@@ -112,14 +222,47 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTen
             assert((*output)->params.zero_point == EI_CLASSIFIER_TFLITE_OUTPUT_ZEROPOINT);
         }
 #endif
-        tflite_first_run = false;
+        session->tensors_checked = true;
+    }
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * Invoke the model of a session and record how long that took
+ *
+ * @param   session     Session to invoke
+ * @param   invoke_ns   Output, time the invoke took
+ *
+ * @return  EI_IMPULSE_OK if successful
+ */
+static EI_IMPULSE_ERROR inference_tflite_invoke(ei_eon_session_t *session, int64_t *invoke_ns) {
+    uint64_t invoke_start_ns = ei_read_timer_ns();
+
+    TfLiteStatus invoke_status = eon_session_is_default(session) ?
+        trained_model_invoke() :
+        trained_model_instance_invoke(session->instance);
+    if (invoke_status != kTfLiteOk) {
+        return EI_IMPULSE_TFLITE_ERROR;
     }
+
+    *invoke_ns = (int64_t)(ei_read_timer_ns() - invoke_start_ns);
+    session->stats.invoke_ns += *invoke_ns;
+    session->stats.invoke_count++;
+
+#if EI_CLASSIFIER_PROFILE_NODES
+    // Copied, the model instance may be freed after the inference
+    session->profile = eon_session_is_default(session) ?
+        *trained_model_profile() :
+        *trained_model_instance_profile(session->instance);
+#endif
+
     return EI_IMPULSE_OK;
 }
 
 /**
  * Run TFLite model
  *
+ * @param   session         Session that was passed to the setup function
  * @param   ctx_start_us    Start time of the setup function (see above)
  * @param   output          Output tensor
  * @param   interpreter     TFLite interpreter (non-compiled models)
@@ -129,7 +272,7 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTen
  *
  * @return  EI_IMPULSE_OK if successful
  */
-static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
+static EI_IMPULSE_ERROR inference_tflite_run(ei_eon_session_t *session, uint64_t ctx_start_us,
     TfLiteTensor* output,
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
     TfLiteTensor* labels_tensor,
@@ -138,11 +281,15 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
     uint8_t* tensor_arena,
     ei_impulse_result_t *result,
     bool debug) {
-    if(trained_model_invoke() != kTfLiteOk) {
+    if (inference_tflite_invoke(session, &result->timing.invoke_ns) != EI_IMPULSE_OK) {
+        if (!session->is_open) {
+            inference_tflite_teardown(session);
+        }
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
     uint64_t ctx_end_us = ei_read_timer_us();
+    uint64_t postprocess_start_ns = ei_read_timer_ns();
 
     result->timing.classification_us = ctx_end_us - ctx_start_us;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
@@ -175,7 +322,12 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
     }
 #endif
 
-    trained_model_reset(ei_aligned_free);
+    result->timing.postprocess_ns = ei_read_timer_ns() - postprocess_start_ns;
+
+    // Keep the arena and prepared kernels around if a session is open
+    if (!session->is_open) {
+        inference_tflite_teardown(session);
+    }
 
     if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
@@ -185,16 +337,176 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
 }
 
 
+/**
+ * @brief      Open a persistent EON session: allocate the arena and run every
+ *             kernel's Init/Prepare once. Subsequent inferences on this
+ *             session reuse the prepared model until ei_eon_session_close().
+ *
+ * @param      session  Zero-initialized session, or the default session
+ *
+ * @return     EI_IMPULSE_OK if successful (also when already open)
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR ei_eon_session_open(ei_eon_session_t *session)
+{
+    if (session->is_open) {
+        return EI_IMPULSE_OK;
+    }
+
+    uint64_t ctx_start_us;
+    ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(session, &ctx_start_us, &session->input, &session->output,
+#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
+        &session->output_labels,
+        &session->output_scores,
+#endif
+        p_tensor_arena);
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    session->is_open = true;
+
+    return EI_IMPULSE_OK;
+}
+
+/**
+ * @brief      Close a persistent EON session and free its arena.
+ *             Inference falls back to per-call init and reset afterwards.
+ */
+__attribute__((unused)) void ei_eon_session_close(ei_eon_session_t *session)
+{
+    if (!session->is_open) {
+        return;
+    }
+
+    inference_tflite_teardown(session);
+    session->is_open = false;
+}
+
+/**
+ * @brief      Open the default session, used by run_classifier()
+ */
+__attribute__((unused)) EI_IMPULSE_ERROR ei_eon_session_init()
+{
+    return ei_eon_session_open(&eon_default_session);
+}
+
+/**
+ * @brief      Close the default session
+ */
+__attribute__((unused)) void ei_eon_session_deinit()
+{
+    ei_eon_session_close(&eon_default_session);
+}
+
+/**
+ * @brief      Get the prepare and invoke cost accumulated so far, both with
+ *             and without an open session
+ */
+__attribute__((unused)) const ei_eon_session_stats_t *ei_eon_session_get_stats(ei_eon_session_t *session = &eon_default_session)
+{
+    return &session->stats;
+}
+
+/**
+ * @brief      Clear the accumulated prepare and invoke cost
+ */
+__attribute__((unused)) void ei_eon_session_reset_stats(ei_eon_session_t *session = &eon_default_session)
+{
+    memset(&session->stats, 0, sizeof(session->stats));
+}
+
+#if EI_CLASSIFIER_PROFILE_NODES
+/**
+ * @brief      Get the time and tensor bytes of every node of the model in
+ *             the last inference (see ei_model_profile.h)
+ */
+__attribute__((unused)) const ei_model_profile_t *ei_get_model_profile(ei_eon_session_t *session = &eon_default_session)
+{
+    return &session->profile;
+}
+#endif // EI_CLASSIFIER_PROFILE_NODES
+
+/**
+ * @brief      Scale and quantize features into int8 model input in one pass,
+ *             the quantization of every int8 input path. The feature is
+ *             source * prescale, divided by the input scale, rounded half
+ *             away from zero (as round() does) and saturated to the int8
+ *             range like TFLite's reference Quantize. The rounding is done
+ *             with a truncating conversion rather than a call to round(), so
+ *             the compiler can vectorize the loop.
+ *
+ * @param      dst         Quantized output
+ * @param      src         Contiguous source values (float or int16)
+ * @param[in]  count       Number of values
+ * @param[in]  prescale    Factor applied before quantizing (e.g. scale_axes)
+ * @param[in]  scale       Scale of the input tensor
+ * @param[in]  zero_point  Zero point of the input tensor
+ */
+template<typename T>
+static inline void ei_eon_quantize_input(int8_t *dst, const T *src, size_t count, float prescale,
+    float scale, int32_t zero_point)
+{
+    // Clamped before the conversion, so outliers saturate instead of
+    // wrapping around (or overflowing int32 on the int16 path)
+    const float min_x = static_cast<float>(-128 - zero_point);
+    const float max_x = static_cast<float>(127 - zero_point);
+
+    for (size_t ix = 0; ix < count; ix++) {
+        float x = (static_cast<float>(src[ix]) * prescale) / scale;
+        x = x < min_x ? min_x : x;
+        x = x > max_x ? max_x : x;
+        int32_t q = static_cast<int32_t>(x);
+        float frac = x - static_cast<float>(q); // exact
+        q += (frac >= 0.5f) - (frac <= -0.5f);
+        dst[ix] = static_cast<int8_t>(q + zero_point);
+    }
+}
+
+/**
+ * @brief      Copy the processed features into the model's input tensor,
+ *             quantizing them if the input is int8 (uint8 for object detection)
+ *
+ * @param      input    Input tensor of the model
+ * @param      fmatrix  Processed matrix
+ */
+static void inference_tflite_fill_input(TfLiteTensor *input, ei::matrix_t *fmatrix)
+{
+#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
+    bool uint8_input = input->type == TfLiteType::kTfLiteUInt8;
+    for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
+        if (uint8_input) {
+            float pixel = (float)fmatrix->buffer[ix];
+            input->data.uint8[ix] = static_cast<uint8_t>((pixel / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+        }
+        else {
+            input->data.f[ix] = fmatrix->buffer[ix];
+        }
+    }
+#else
+    // Quantize the input if it is int8
+    if (input->type == TfLiteType::kTfLiteInt8) {
+        ei_eon_quantize_input(input->data.int8, fmatrix->buffer, fmatrix->rows * fmatrix->cols, 1.0f,
+            input->params.scale, input->params.zero_point);
+    } else {
+        memcpy(input->data.f, fmatrix->buffer, fmatrix->rows * fmatrix->cols * sizeof(float));
+    }
+#endif
+}
+
 /**
  * @brief      Do neural network inferencing over the processed feature matrix
  *
+ * @param      session  EON session to run on
  * @param      fmatrix  Processed matrix
  * @param      result   Output classifier results
  * @param[in]  debug    Debug output enable
  *
  * @return     The ei impulse error.
  */
-EI_IMPULSE_ERROR run_nn_inference(
+EI_IMPULSE_ERROR run_nn_inference_session(
+    ei_eon_session_t *session,
     ei::matrix_t *fmatrix,
     ei_impulse_result_t *result,
     bool debug = false)
@@ -208,7 +520,7 @@ EI_IMPULSE_ERROR run_nn_inference(
     uint64_t ctx_start_us = ei_read_timer_us();
     ei_unique_ptr_t p_tensor_arena(nullptr,ei_aligned_free);
 
-    EI_IMPULSE_ERROR init_res = inference_tflite_setup(&ctx_start_us, &input, &output,
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(session, &ctx_start_us, &input, &output,
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
         &output_labels,
         &output_scores,
@@ -221,32 +533,14 @@ EI_IMPULSE_ERROR run_nn_inference(
 
     uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
 
+    uint64_t quantize_start_ns = ei_read_timer_ns();
+
     // Place our calculated x value in the model's input tensor
-#if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
-    bool uint8_input = input->type == TfLiteType::kTfLiteUInt8;
-    for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
-        if (uint8_input) {
-            float pixel = (float)fmatrix->buffer[ix];
-            input->data.uint8[ix] = static_cast<uint8_t>((pixel / EI_CLASSIFIER_TFLITE_INPUT_SCALE) + EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
-        }
-        else {
-            input->data.f[ix] = fmatrix->buffer[ix];
-        }
-    }
-#else
-    bool int8_input = input->type == TfLiteType::kTfLiteInt8;
-    for (size_t ix = 0; ix < fmatrix->rows * fmatrix->cols; ix++) {
-        // Quantize the input if it is int8
-        if (int8_input) {
-            input->data.int8[ix] = static_cast<int8_t>(round(fmatrix->buffer[ix] / input->params.scale) + input->params.zero_point);
-            // printf("float %ld : %d\r\n", ix, input->data.int8[ix]);
-        } else {
-            input->data.f[ix] = fmatrix->buffer[ix];
-        }
-    }
-#endif
+    inference_tflite_fill_input(input, fmatrix);
+
+    result->timing.quantize_ns = ei_read_timer_ns() - quantize_start_ns;
 
-    EI_IMPULSE_ERROR run_res = inference_tflite_run(ctx_start_us, output,
+    EI_IMPULSE_ERROR run_res = inference_tflite_run(session, ctx_start_us, output,
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
         output_labels,
         output_scores,
@@ -262,6 +556,401 @@ EI_IMPULSE_ERROR run_nn_inference(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * @brief      Do neural network inferencing over the processed feature matrix
+ *             on the default session
+ *
+ * @param      fmatrix  Processed matrix
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+EI_IMPULSE_ERROR run_nn_inference(
+    ei::matrix_t *fmatrix,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    return run_nn_inference_session(&eon_default_session, fmatrix, result, debug);
+}
+
+#if (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1) && !EI_CLASSIFIER_OBJECT_DETECTION
+/**
+ * Quantized model input that is kept across calls for continuous inference
+ * on impulses that feed (scaled) raw samples straight into the network.
+ * Each new slice is quantized once when it arrives, the remainder of the
+ * window is reused as is.
+ *
+ * Note that this does not make the first layer incremental: a dense layer
+ * weighs every input by its position in the window, and all older slices
+ * move to a new position whenever a slice is added, so the whole layer has
+ * to run again on every slice.
+ */
+typedef struct {
+    int8_t window[EI_CLASSIFIER_NN_INPUT_FRAME_SIZE];
+    size_t head;    // oldest feature in the window, next one to overwrite
+    size_t written; // features pushed since the last reset
+} ei_eon_input_stream_t;
+
+/**
+ * @brief      Scale and quantize features into int8 model input with the
+ *             model's input scale and zero point (see the overload above)
+ *
+ * @param      dst       Quantized output
+ * @param      src       Contiguous source values (float or int16)
+ * @param[in]  count     Number of values
+ * @param[in]  prescale  Factor applied before quantizing (e.g. scale_axes)
+ */
+template<typename T>
+static inline void ei_eon_quantize_input(int8_t *dst, const T *src, size_t count, float prescale)
+{
+    ei_eon_quantize_input(dst, src, count, prescale,
+        static_cast<float>(EI_CLASSIFIER_TFLITE_INPUT_SCALE), EI_CLASSIFIER_TFLITE_INPUT_ZEROPOINT);
+}
+
+/**
+ * @brief      Clear the window of an input stream
+ */
+__attribute__((unused)) void ei_eon_input_stream_reset(ei_eon_input_stream_t *stream)
+{
+    memset(stream, 0, sizeof(ei_eon_input_stream_t));
+}
+
+/**
+ * @brief      Quantize new features into the window, replacing the oldest
+ *
+ * @param      stream    Input stream
+ * @param      features  Processed features of the newest slice
+ * @param[in]  count     Number of features
+ */
+__attribute__((unused)) void ei_eon_input_stream_push(ei_eon_input_stream_t *stream,
+    const float *features, size_t count)
+{
+    stream->written += count;
+
+    // Only the last window's worth of features can end up in the window
+    if (count > EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
+        features += count - EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+        count = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+    }
+
+    // Quantize up to the end of the ring, then wrap around
+    size_t tail_size = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE - stream->head;
+    if (tail_size > count) {
+        tail_size = count;
+    }
+    ei_eon_quantize_input(stream->window + stream->head, features, tail_size, 1.0f);
+    ei_eon_quantize_input(stream->window, features + tail_size, count - tail_size, 1.0f);
+
+    stream->head = (stream->head + count) % EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+}
+
+/**
+ * @brief      Do neural network inferencing over the window of an input
+ *             stream (oldest feature first)
+ *
+ * @param      session  EON session to run on
+ * @param      stream   Input stream, holding at least a full window
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+EI_IMPULSE_ERROR run_nn_inference_stream(
+    ei_eon_session_t *session,
+    ei_eon_input_stream_t *stream,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    TfLiteTensor* input;
+    TfLiteTensor* output;
+    uint64_t ctx_start_us;
+    ei_unique_ptr_t p_tensor_arena(nullptr,ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(session, &ctx_start_us, &input, &output, p_tensor_arena);
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    if (input->type != TfLiteType::kTfLiteInt8) {
+        if (!session->is_open) {
+            inference_tflite_teardown(session);
+        }
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    // Unroll the ring into the input tensor, which shares the arena with
+    // the activations and so does not survive an invoke
+    uint64_t quantize_start_ns = ei_read_timer_ns();
+    size_t tail_size = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE - stream->head;
+    memcpy(input->data.int8, stream->window + stream->head, tail_size);
+    memcpy(input->data.int8 + tail_size, stream->window, stream->head);
+    result->timing.quantize_ns = ei_read_timer_ns() - quantize_start_ns;
+
+    EI_IMPULSE_ERROR run_res = inference_tflite_run(session, ctx_start_us, output,
+        static_cast<uint8_t*>(p_tensor_arena.get()), result, debug);
+
+    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+
+    return run_res;
+}
+
+// Number of signal values read per get_data() call when binding a signal to
+// the input tensor (kept on the stack)
+#ifndef EI_EON_INPUT_BIND_CHUNK_SIZE
+#define EI_EON_INPUT_BIND_CHUNK_SIZE    64
+#endif
+
+/**
+ * @brief      Do neural network inferencing with the input tensor filled by
+ *             a callback, for inputs that go straight into the network
+ *             without a feature matrix in between. The time spent filling
+ *             the tensor is reported as DSP time.
+ *
+ * @param      session  EON session to run on
+ * @param      fill     Called with the int8 input tensor, returns 0 on
+ *                      success
+ * @param      result   Output classifier results
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+template<typename FillFn>
+static EI_IMPULSE_ERROR inference_tflite_run_bound(
+    ei_eon_session_t *session,
+    FillFn fill,
+    ei_impulse_result_t *result,
+    bool debug)
+{
+    TfLiteTensor* input;
+    TfLiteTensor* output;
+    uint64_t ctx_start_us;
+    ei_unique_ptr_t p_tensor_arena(nullptr,ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(session, &ctx_start_us, &input, &output, p_tensor_arena);
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    if (input->type != TfLiteType::kTfLiteInt8) {
+        if (!session->is_open) {
+            inference_tflite_teardown(session);
+        }
+        return EI_IMPULSE_TFLITE_ERROR;
+    }
+
+    uint64_t fill_start_ns = ei_read_timer_ns();
+    int fill_res = fill(input->data.int8);
+    if (fill_res != 0) {
+        if (!session->is_open) {
+            inference_tflite_teardown(session);
+        }
+        ei_printf("ERR: Failed to run DSP process (%d)\n", fill_res);
+        return EI_IMPULSE_DSP_ERROR;
+    }
+
+    result->timing.dsp_ns = ei_read_timer_ns() - fill_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
+    result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+    ctx_start_us += result->timing.dsp_us;
+
+    if (debug) {
+        ei_printf("Running neural network...\n");
+    }
+
+    EI_IMPULSE_ERROR run_res = inference_tflite_run(session, ctx_start_us, output,
+        static_cast<uint8_t*>(p_tensor_arena.get()), result, debug);
+
+    result->timing.classification_us = ei_read_timer_us() - ctx_start_us;
+
+    return run_res;
+}
+
+/**
+ * @brief      Do neural network inferencing over a signal that is the model
+ *             input as is, up to a scale factor (a single raw block). The
+ *             signal is read in small chunks and every chunk is scaled and
+ *             quantized straight into the input tensor. A short signal is
+ *             padded with zero features, a long one is cut off, as in
+ *             extract_raw_features().
+ *
+ * @param      session   EON session to run on
+ * @param      signal    Signal holding the model input (signal_t or any
+ *                       other signal type, see ei_signal_span.h)
+ * @param[in]  prescale  Factor applied to every value (scale_axes)
+ * @param      result    Output classifier results
+ * @param[in]  debug     Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+template<typename SignalT>
+EI_IMPULSE_ERROR run_nn_inference_signal(
+    ei_eon_session_t *session,
+    SignalT *signal,
+    float prescale,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    auto fill = [signal, prescale](int8_t *input) {
+        float chunk[EI_EON_INPUT_BIND_CHUNK_SIZE];
+
+        size_t length = signal->total_length;
+        if (length > EI_CLASSIFIER_NN_INPUT_FRAME_SIZE) {
+            length = EI_CLASSIFIER_NN_INPUT_FRAME_SIZE;
+        }
+
+        for (size_t offset = 0; offset < length; offset += EI_EON_INPUT_BIND_CHUNK_SIZE) {
+            size_t chunk_size = length - offset;
+            if (chunk_size > EI_EON_INPUT_BIND_CHUNK_SIZE) {
+                chunk_size = EI_EON_INPUT_BIND_CHUNK_SIZE;
+            }
+            int ret = signal->get_data(offset, chunk_size, chunk);
+            if (ret != 0) {
+                return ret;
+            }
+            ei_eon_quantize_input(input + offset, chunk, chunk_size, prescale);
+        }
+
+        const float zero = 0.0f;
+        for (size_t ix = length; ix < EI_CLASSIFIER_NN_INPUT_FRAME_SIZE; ix++) {
+            ei_eon_quantize_input(input + ix, &zero, 1, 1.0f);
+        }
+        return 0;
+    };
+
+    return inference_tflite_run_bound(session, fill, result, debug);
+}
+
+/**
+ * @brief      Do neural network inferencing over a contiguous buffer that is
+ *             the model input as is, up to a scale factor. The buffer is
+ *             scaled and quantized straight into the input tensor.
+ *
+ * @param      session   EON session to run on
+ * @param      features  EI_CLASSIFIER_NN_INPUT_FRAME_SIZE values (float or int16)
+ * @param[in]  prescale  Factor applied to every value
+ * @param      result    Output classifier results
+ * @param[in]  debug     Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+template<typename T>
+EI_IMPULSE_ERROR run_nn_inference_contiguous(
+    ei_eon_session_t *session,
+    const T *features,
+    float prescale,
+    ei_impulse_result_t *result,
+    bool debug = false)
+{
+    auto fill = [features, prescale](int8_t *input) {
+        ei_eon_quantize_input(input, features, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, prescale);
+        return 0;
+    };
+
+    return inference_tflite_run_bound(session, fill, result, debug);
+}
+#endif // EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1
+
+#if !EI_CLASSIFIER_OBJECT_DETECTION
+/**
+ * @brief      Do neural network inferencing over several processed feature
+ *             vectors at once. Every row of the matrix is one window; up to
+ *             the session's batch size rows are stacked into the input tensor
+ *             so each layer runs once per chunk instead of once per window.
+ *
+ * @param      session  EON session, opened with a batch_size for batching
+ * @param      fmatrix  Processed matrix, one window per row
+ * @param      results  Output classifier results, one per row
+ * @param[in]  debug    Debug output enable
+ *
+ * @return     The ei impulse error.
+ */
+EI_IMPULSE_ERROR run_nn_inference_batch(
+    ei_eon_session_t *session,
+    ei::matrix_t *fmatrix,
+    ei_impulse_result_t *results,
+    bool debug = false)
+{
+    TfLiteTensor* input;
+    TfLiteTensor* output;
+    uint64_t ctx_start_us;
+    ei_unique_ptr_t p_tensor_arena(nullptr,ei_aligned_free);
+
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(session, &ctx_start_us, &input, &output, p_tensor_arena);
+    if (init_res != EI_IMPULSE_OK) {
+        return init_res;
+    }
+
+    const size_t batch_capacity = eon_session_is_default(session) ?
+        1 : (size_t)trained_model_instance_batch_size(session->instance);
+    const size_t row_size = fmatrix->cols;
+    EI_IMPULSE_ERROR run_res = EI_IMPULSE_OK;
+
+    for (size_t row_start = 0; row_start < fmatrix->rows; row_start += batch_capacity) {
+        size_t rows = fmatrix->rows - row_start;
+        if (rows > batch_capacity) {
+            rows = batch_capacity;
+        }
+
+        if (!eon_session_is_default(session) &&
+                trained_model_instance_set_batch(session->instance, (int)rows) != kTfLiteOk) {
+            run_res = EI_IMPULSE_TFLITE_ERROR;
+            break;
+        }
+
+        uint64_t chunk_start_us = ei_read_timer_us();
+        uint64_t quantize_start_ns = ei_read_timer_ns();
+
+        ei::matrix_t chunk(rows, row_size, fmatrix->buffer + row_start * row_size);
+        inference_tflite_fill_input(input, &chunk);
+
+        int64_t quantize_ns = (int64_t)(ei_read_timer_ns() - quantize_start_ns);
+
+        int64_t invoke_ns;
+        run_res = inference_tflite_invoke(session, &invoke_ns);
+        if (run_res != EI_IMPULSE_OK) {
+            break;
+        }
+
+        // The chunk ran as one invoke, share its cost over the windows
+        int64_t classification_us = (int64_t)(ei_read_timer_us() - chunk_start_us) / (int64_t)rows;
+        uint64_t postprocess_start_ns = ei_read_timer_ns();
+
+        bool int8_output = output->type == TfLiteType::kTfLiteInt8;
+        for (size_t row = 0; row < rows; row++) {
+            ei_impulse_result_t *result = &results[row_start + row];
+            if (int8_output) {
+                fill_result_struct_i8(result, output->data.int8 + row * EI_CLASSIFIER_LABEL_COUNT,
+                    output->params.zero_point, output->params.scale, debug);
+            }
+            else {
+                fill_result_struct_f32(result, output->data.f + row * EI_CLASSIFIER_LABEL_COUNT, debug);
+            }
+            result->timing.classification_us = classification_us;
+            result->timing.classification = (int)(classification_us / 1000);
+            result->timing.quantize_ns = quantize_ns / (int64_t)rows;
+            result->timing.invoke_ns = invoke_ns / (int64_t)rows;
+        }
+
+        int64_t postprocess_ns = (int64_t)(ei_read_timer_ns() - postprocess_start_ns) / (int64_t)rows;
+        for (size_t row = 0; row < rows; row++) {
+            results[row_start + row].timing.postprocess_ns = postprocess_ns;
+        }
+
+        if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
+            run_res = EI_IMPULSE_CANCELED;
+            break;
+        }
+    }
+
+    if (!session->is_open) {
+        inference_tflite_teardown(session);
+    }
+
+    return run_res;
+}
+#endif // !EI_CLASSIFIER_OBJECT_DETECTION
+
 #if EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1
 /**
  * Special function to run the classifier on images, only works on TFLite models (either interpreter or EON or for tensaiflow)
@@ -284,7 +973,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
 #endif
     ei_unique_ptr_t p_tensor_arena(nullptr,ei_aligned_free);
 
-    EI_IMPULSE_ERROR init_res = inference_tflite_setup(&ctx_start_us, &input, &output,
+    EI_IMPULSE_ERROR init_res = inference_tflite_setup(&eon_default_session, &ctx_start_us, &input, &output,
     #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
         &output_labels,
         &output_scores,
@@ -298,7 +987,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_ONLY_SUPPORTED_FOR_IMAGES;
     }
 
-    uint64_t dsp_start_us = ei_read_timer_us();
+    uint64_t dsp_start_ns = ei_read_timer_ns();
 
     // features matrix maps around the input tensor to not allocate any memory
     ei::matrix_i8_t features_matrix(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, input->data.int8);
@@ -314,7 +1003,8 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         return EI_IMPULSE_CANCELED;
     }
 
-    result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
+    result->timing.dsp_ns = ei_read_timer_ns() - dsp_start_ns;
+    result->timing.dsp_us = result->timing.dsp_ns / 1000;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
 
     if (debug) {
@@ -328,7 +1018,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
 
     ctx_start_us = ei_read_timer_us();
 
-    EI_IMPULSE_ERROR run_res = inference_tflite_run(ctx_start_us, output,
+    EI_IMPULSE_ERROR run_res = inference_tflite_run(&eon_default_session, ctx_start_us, output,
     #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
         output_labels,
         output_scores,
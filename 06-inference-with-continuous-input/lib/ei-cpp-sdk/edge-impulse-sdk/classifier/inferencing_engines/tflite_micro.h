@@ -37,6 +37,7 @@
 #include "edge-impulse-sdk/tensorflow/lite/schema/schema_generated.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 #include "edge-impulse-sdk/classifier/ei_fill_result_struct.h"
+#include "edge-impulse-sdk/classifier/ei_model_profile.h"
 
 // old models don't have this, add this here
 #ifndef EI_CLASSIFIER_TFLITE_OUTPUT_DATA_TENSOR
@@ -51,6 +52,19 @@
 static tflite::MicroErrorReporter micro_error_reporter;
 static tflite::ErrorReporter* error_reporter = &micro_error_reporter;
 
+#if EI_CLASSIFIER_PROFILE_NODES
+static EiMicroProfiler micro_profiler;
+
+/**
+ * @brief      Get the time and tensor bytes of every node of the model in
+ *             the last inference (see ei_model_profile.h)
+ */
+__attribute__((unused)) static const ei_model_profile_t *ei_get_model_profile()
+{
+    return micro_profiler.profile();
+}
+#endif // EI_CLASSIFIER_PROFILE_NODES
+
 #if defined(EI_CLASSIFIER_ENABLE_DETECTION_POSTPROCESS_OP)
 namespace tflite {
 namespace ops {
@@ -138,8 +152,14 @@ static EI_IMPULSE_ERROR inference_tflite_setup(uint64_t *ctx_start_us, TfLiteTen
 #endif
 
     // Build an interpreter to run the model with.
+#if EI_CLASSIFIER_PROFILE_NODES
+    micro_profiler.Clear();
+    tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
+        model, resolver, tensor_arena, EI_CLASSIFIER_TFLITE_ARENA_SIZE, error_reporter, &micro_profiler);
+#else
     tflite::MicroInterpreter *interpreter = new tflite::MicroInterpreter(
         model, resolver, tensor_arena, EI_CLASSIFIER_TFLITE_ARENA_SIZE, error_reporter);
+#endif
 
     *micro_interpreter = interpreter;
 
@@ -204,14 +224,17 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
     ei_impulse_result_t *result,
     bool debug) {
     // Run inference, and report any error
+    uint64_t invoke_start_ns = ei_read_timer_ns();
     TfLiteStatus invoke_status = interpreter->Invoke();
     if (invoke_status != kTfLiteOk) {
         error_reporter->Report("Invoke failed (%d)\n", invoke_status);
         return EI_IMPULSE_TFLITE_ERROR;
     }
+    result->timing.invoke_ns = ei_read_timer_ns() - invoke_start_ns;
     delete interpreter;
 
     uint64_t ctx_end_us = ei_read_timer_us();
+    uint64_t postprocess_start_ns = ei_read_timer_ns();
 
     result->timing.classification_us = ctx_end_us - ctx_start_us;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
@@ -244,6 +267,8 @@ static EI_IMPULSE_ERROR inference_tflite_run(uint64_t ctx_start_us,
     }
 #endif
 
+    result->timing.postprocess_ns = ei_read_timer_ns() - postprocess_start_ns;
+
     if (ei_run_impulse_check_canceled() == EI_IMPULSE_CANCELED) {
         return EI_IMPULSE_CANCELED;
     }
@@ -288,6 +313,8 @@ EI_IMPULSE_ERROR run_nn_inference(
 
     uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
 
+    uint64_t quantize_start_ns = ei_read_timer_ns();
+
     // Place our calculated x value in the model's input tensor
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
     bool uint8_input = input->type == TfLiteType::kTfLiteUInt8;
@@ -313,6 +340,8 @@ EI_IMPULSE_ERROR run_nn_inference(
     }
 #endif
 
+    result->timing.quantize_ns = ei_read_timer_ns() - quantize_start_ns;
+
     EI_IMPULSE_ERROR run_res = inference_tflite_run(ctx_start_us, output,
 #if EI_CLASSIFIER_OBJDET_HAS_SCORE_TENSOR
         output_labels,
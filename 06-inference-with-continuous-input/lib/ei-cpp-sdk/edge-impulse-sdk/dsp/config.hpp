@@ -72,6 +72,12 @@
 #define EIDSP_ERR(err_code) return(err_code)
 #endif
 
+// Number of floats fetched per get_data() call when gathering axes from an
+// interleaved signal (kept on the stack), should hold at least one frame
+#ifndef EIDSP_SIGNAL_GATHER_CHUNK_SIZE
+#define EIDSP_SIGNAL_GATHER_CHUNK_SIZE    96
+#endif // EIDSP_SIGNAL_GATHER_CHUNK_SIZE
+
 // To save memory you can quantize the filterbanks,
 // this has an effect on runtime speed as CMSIS-DSP does not have optimized instructions
 // for q7 matrix multiplication and matrix transformation...
@@ -79,20 +85,69 @@
 #define EIDSP_QUANTIZE_FILTERBANK    1
 #endif // EIDSP_QUANTIZE_FILTERBANK
 
-// prints buffer allocations to stdout, useful when debugging
+// tracks the DSP allocations of sampled run_classifier() calls per thread,
+// the stats end up in the alloc_stats of the result
 #ifndef EIDSP_TRACK_ALLOCATIONS
 #define EIDSP_TRACK_ALLOCATIONS      0
 #endif // EIDSP_TRACK_ALLOCATIONS
 
-// set EIDSP_TRACK_ALLOCATIONS=1 and EIDSP_PRINT_ALLOCATIONS=0
-// to track but not print allocations
+// set EIDSP_TRACK_ALLOCATIONS=1 and EIDSP_PRINT_ALLOCATIONS=1
+// to also print every allocation to stdout, useful when debugging
 #ifndef EIDSP_PRINT_ALLOCATIONS
-#define EIDSP_PRINT_ALLOCATIONS      1
+#define EIDSP_PRINT_ALLOCATIONS      0
 #endif
 
+// track one in this many calls per thread (1% of the inferences by default,
+// cheap enough for production telemetry), set it to 1 to track every call in
+// benchmarks and tests
+#ifndef EIDSP_ALLOC_STATS_SAMPLE_EVERY
+#define EIDSP_ALLOC_STATS_SAMPLE_EVERY    100
+#endif // EIDSP_ALLOC_STATS_SAMPLE_EVERY
+
+// number of call sites that the allocation stats of a call keep apart
+#ifndef EIDSP_ALLOC_STATS_MAX_SITES
+#define EIDSP_ALLOC_STATS_MAX_SITES  32
+#endif // EIDSP_ALLOC_STATS_MAX_SITES
+
 #ifndef EIDSP_SIGNAL_C_FN_POINTER
 #define EIDSP_SIGNAL_C_FN_POINTER    0
 #endif // EIDSP_SIGNAL_C_FN_POINTER
 
+// Use SSE2/AVX2 (x86) or NEON (Arm application processors) for the numpy ops on
+// targets without CMSIS-DSP, picked from the compiler flags (see numpy_simd.hpp)
+#ifndef EIDSP_USE_SIMD
+#define EIDSP_USE_SIMD               1
+#endif // EIDSP_USE_SIMD
+
+// Let a thread carve its DSP scratch allocations from a caller-provided
+// arena instead of the heap (see ei_dsp_arena_bind() in memory.hpp)
+#ifndef EIDSP_SCRATCH_ARENA
+#define EIDSP_SCRATCH_ARENA          1
+#endif // EIDSP_SCRATCH_ARENA
+
+// Number of real FFT plans (one per FFT length) that numpy::rfft() keeps
+// per thread, so the FFT config and scratch buffers are not rebuilt per call
+#ifndef EIDSP_RFFT_PLAN_CACHE_SIZE
+#define EIDSP_RFFT_PLAN_CACHE_SIZE   2
+#endif // EIDSP_RFFT_PLAN_CACHE_SIZE
+
+// Alignment (bytes) of the FFT scratch buffers
+#ifndef EIDSP_SCRATCH_ALIGNMENT
+#define EIDSP_SCRATCH_ALIGNMENT      32
+#endif // EIDSP_SCRATCH_ALIGNMENT
+
+// Storage class of per-thread DSP state (the FFT plan cache, the scratch
+// arena and the allocation stats). thread_local on hosted targets only, bare
+// metal toolchains often lack TLS support (or pay for it on every access) and
+// run DSP on one thread anyway. Define it as thread_local to run DSP from
+// several RTOS threads at once.
+#ifndef EIDSP_THREAD_LOCAL
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+#define EIDSP_THREAD_LOCAL           thread_local
+#else
+#define EIDSP_THREAD_LOCAL
+#endif
+#endif // EIDSP_THREAD_LOCAL
+
 // clang-format on
 #endif // _EIDSP_CPP_CONFIG_H_
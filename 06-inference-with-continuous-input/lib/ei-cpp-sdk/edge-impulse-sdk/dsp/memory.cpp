@@ -21,6 +21,3 @@
  */
 
 #include "memory.hpp"
-
-size_t ei_memory_in_use = 0;
-size_t ei_memory_peak_use = 0;
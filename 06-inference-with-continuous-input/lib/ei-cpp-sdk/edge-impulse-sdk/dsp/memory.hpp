@@ -26,19 +26,50 @@
 // clang-format off
 #include <stdio.h>
 #include <memory>
+#include <stdint.h>
+#include <string.h>
+#include "config.hpp"
 #include "../porting/ei_classifier_porting.h"
 #include "edge-impulse-sdk/classifier/ei_aligned_malloc.h"
 
-extern size_t ei_memory_in_use;
-extern size_t ei_memory_peak_use;
-
 #if EIDSP_PRINT_ALLOCATIONS == 1
 #define ei_dsp_printf           printf
 #else
-#define ei_dsp_printf           (void)
+#define ei_dsp_printf(...)      (void)0
 #endif
 
 typedef std::unique_ptr<void, void(*)(void*)> ei_unique_ptr_t;
+
+#if EIDSP_TRACK_ALLOCATIONS
+/**
+ * Allocations made from one place in the SDK
+ */
+typedef struct {
+    const char *fn;         // Function that allocated
+    const char *file;
+    int line;
+    uint32_t count;         // Number of allocations
+    size_t bytes;           // Bytes allocated in total
+} ei_dsp_alloc_site_t;
+
+/**
+ * DSP allocations made during one call into the SDK (see
+ * ei_dsp_alloc_stats_scope). All fields but `sampled` are only set if the
+ * call was sampled.
+ */
+typedef struct {
+    uint32_t sampled;       // Whether this call was tracked
+    uint32_t count;         // Number of allocations
+    uint32_t frees;         // Number of frees
+    size_t bytes;           // Bytes allocated in total
+    size_t in_use;          // Bytes still allocated at the end of the call
+    size_t peak;            // Most bytes allocated at once
+    uint32_t sites_count;   // Number of valid entries in sites
+    uint32_t sites_dropped; // Allocations from sites that did not fit in sites
+    ei_dsp_alloc_site_t sites[EIDSP_ALLOC_STATS_MAX_SITES];
+} ei_dsp_alloc_stats_t;
+#endif // EIDSP_TRACK_ALLOCATIONS
+
 #define EI_ALLOCATE_AUTO_POINTER(ptr, size) \
     ptr = static_cast<decltype(ptr)>(ei_calloc(size,sizeof(*ptr))); \
     ei_unique_ptr_t __ptr__(ptr,ei_free);
@@ -51,24 +82,322 @@ typedef std::unique_ptr<void, void(*)(void*)> ei_unique_ptr_t;
 
 namespace ei {
 
+#if EIDSP_SCRATCH_ARENA
+// Alignment of the blocks carved from a scratch arena
+#define EI_DSP_ARENA_ALIGNMENT      16
+
+#define EI_DSP_ARENA_NONE           ((size_t)-1)
+
+/**
+ * Header in front of every block of a scratch arena
+ */
+typedef struct {
+    size_t prev;        // Offset of the block allocated before this one, EI_DSP_ARENA_NONE if none
+    size_t freed;
+} ei_dsp_arena_block_t;
+
+#define EI_DSP_ARENA_HEADER_SIZE \
+    ((sizeof(ei_dsp_arena_block_t) + EI_DSP_ARENA_ALIGNMENT - 1) & ~(size_t)(EI_DSP_ARENA_ALIGNMENT - 1))
+
+// Most arena space a block needs on top of its size (header and padding)
+#define EI_DSP_ARENA_BLOCK_OVERHEAD (EI_DSP_ARENA_HEADER_SIZE + EI_DSP_ARENA_ALIGNMENT)
+
+/**
+ * Scratch arena for the DSP allocations of one thread. While an arena is
+ * bound to a thread (ei_dsp_arena_bind()), ei_dsp_malloc(), ei_dsp_calloc()
+ * and the buffers of heap matrices are carved from it instead of the heap.
+ * An allocation that does not fit fails (the DSP block returns
+ * EIDSP_OUT_OF_MEM) and is counted in `failed`, there is no fallback to the
+ * heap.
+ *
+ * The arena works as a stack: freeing the most recent block gives its space
+ * back right away, any other block once every block after it is freed. DSP
+ * allocations are scoped to one call, so the arena is empty again after
+ * every run_classifier() call, and `peak` tells how much of it was needed.
+ */
+typedef struct {
+    uint8_t *buffer;
+    size_t size;
+    size_t used;        // Bytes in use, including the block headers
+    size_t peak;        // Highest `used` since ei_dsp_arena_init()
+    size_t top;         // Offset of the most recent block, EI_DSP_ARENA_NONE if empty
+    size_t failed;      // Allocations that did not fit
+} ei_dsp_arena_t;
+
+/**
+ * Arena bound to the current thread (NULL if DSP allocates on the heap)
+ */
+inline ei_dsp_arena_t *&ei_dsp_arena_current()
+{
+    static EIDSP_THREAD_LOCAL ei_dsp_arena_t *arena = NULL;
+    return arena;
+}
+
+/**
+ * Set up an arena over a buffer
+ * @param arena Arena to set up
+ * @param buffer Memory of the arena, owned by the caller
+ * @param size Size of the buffer in bytes
+ */
+static inline void ei_dsp_arena_init(ei_dsp_arena_t *arena, void *buffer, size_t size)
+{
+    uintptr_t start = ((uintptr_t)buffer + EI_DSP_ARENA_ALIGNMENT - 1) & ~(uintptr_t)(EI_DSP_ARENA_ALIGNMENT - 1);
+    size_t skipped = start - (uintptr_t)buffer;
+
+    arena->buffer = (uint8_t *)start;
+    arena->size = size > skipped ? size - skipped : 0;
+    arena->used = 0;
+    arena->peak = 0;
+    arena->top = EI_DSP_ARENA_NONE;
+    arena->failed = 0;
+}
+
+/**
+ * Carve the DSP allocations of the current thread from an arena (NULL to go
+ * back to the heap). Only (un)bind between calls into the SDK, when no DSP
+ * allocation is alive.
+ */
+static inline void ei_dsp_arena_bind(ei_dsp_arena_t *arena)
+{
+    ei_dsp_arena_current() = arena;
+}
+
+/**
+ * Allocate a block from an arena, NULL if it does not fit
+ */
+static inline void *ei_dsp_arena_alloc(ei_dsp_arena_t *arena, size_t size)
+{
+    if (size > arena->size) {
+        arena->failed++;
+        return NULL;
+    }
+
+    size_t block_size = EI_DSP_ARENA_HEADER_SIZE +
+        ((size + EI_DSP_ARENA_ALIGNMENT - 1) & ~(size_t)(EI_DSP_ARENA_ALIGNMENT - 1));
+    if (block_size > arena->size - arena->used) {
+        arena->failed++;
+        return NULL;
+    }
+
+    ei_dsp_arena_block_t *block = (ei_dsp_arena_block_t *)(arena->buffer + arena->used);
+    block->prev = arena->top;
+    block->freed = 0;
+
+    arena->top = arena->used;
+    arena->used += block_size;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+
+    return (uint8_t *)block + EI_DSP_ARENA_HEADER_SIZE;
+}
+
+/**
+ * Whether a pointer was carved from an arena
+ */
+static inline bool ei_dsp_arena_owns(const ei_dsp_arena_t *arena, const void *ptr)
+{
+    return arena && (const uint8_t *)ptr >= arena->buffer && (const uint8_t *)ptr < arena->buffer + arena->size;
+}
+
+/**
+ * Free a block of an arena, and give back the space of all freed blocks at
+ * the top of the arena
+ */
+static inline void ei_dsp_arena_free(ei_dsp_arena_t *arena, void *ptr)
+{
+    ((ei_dsp_arena_block_t *)((uint8_t *)ptr - EI_DSP_ARENA_HEADER_SIZE))->freed = 1;
+
+    while (arena->top != EI_DSP_ARENA_NONE) {
+        ei_dsp_arena_block_t *block = (ei_dsp_arena_block_t *)(arena->buffer + arena->top);
+        if (!block->freed) {
+            break;
+        }
+        arena->used = arena->top;
+        arena->top = block->prev;
+    }
+}
+#endif // EIDSP_SCRATCH_ARENA
+
+/**
+ * Allocate DSP scratch memory: from the arena bound to this thread if there
+ * is one, otherwise from the heap. Memory that has to outlive the call into
+ * the SDK (caches, state of continuous inference) is allocated with
+ * ei_malloc() / ei_calloc() instead.
+ */
+static inline void *ei_dsp_scratch_malloc(size_t size)
+{
+#if EIDSP_SCRATCH_ARENA
+    ei_dsp_arena_t *arena = ei_dsp_arena_current();
+    if (arena) {
+        return ei_dsp_arena_alloc(arena, size);
+    }
+#endif
+    return ei_malloc(size);
+}
+
+/**
+ * Allocate zeroed DSP scratch memory (see ei_dsp_scratch_malloc())
+ */
+static inline void *ei_dsp_scratch_calloc(size_t num, size_t size)
+{
+#if EIDSP_SCRATCH_ARENA
+    ei_dsp_arena_t *arena = ei_dsp_arena_current();
+    if (arena) {
+        void *ptr = ei_dsp_arena_alloc(arena, num * size);
+        if (ptr) {
+            memset(ptr, 0, num * size);
+        }
+        return ptr;
+    }
+#endif
+    return ei_calloc(num, size);
+}
+
+/**
+ * Free DSP scratch memory (see ei_dsp_scratch_malloc())
+ */
+static inline void ei_dsp_scratch_free(void *ptr)
+{
+#if EIDSP_SCRATCH_ARENA
+    ei_dsp_arena_t *arena = ei_dsp_arena_current();
+    if (ei_dsp_arena_owns(arena, ptr)) {
+        ei_dsp_arena_free(arena, ptr);
+        return;
+    }
+#endif
+    ei_free(ptr);
+}
+
 /**
  * These are macros used to track allocations when running DSP processes.
  * Enable memory tracking through the EIDSP_TRACK_ALLOCATIONS macro.
  */
 
 #if EIDSP_TRACK_ALLOCATIONS
+/**
+ * Stats of the call being tracked on the current thread (NULL if none)
+ */
+inline ei_dsp_alloc_stats_t *&ei_dsp_alloc_stats_current()
+{
+    static EIDSP_THREAD_LOCAL ei_dsp_alloc_stats_t *stats = NULL;
+    return stats;
+}
+
+/**
+ * Count an allocation in the stats of the current thread, by call site
+ */
+static inline void ei_dsp_alloc_stats_alloc(const char *fn, const char *file, int line, size_t bytes, void *ptr)
+{
+    ei_dsp_printf("alloc %lu bytes (%s@%s:%d) %p\n", (unsigned long)bytes, fn, file, line, ptr);
+
+    ei_dsp_alloc_stats_t *stats = ei_dsp_alloc_stats_current();
+    if (!stats || !ptr) {
+        return;
+    }
+
+    stats->count++;
+    stats->bytes += bytes;
+    stats->in_use += bytes;
+    if (stats->in_use > stats->peak) {
+        stats->peak = stats->in_use;
+    }
+
+    // __FILE__ is a string literal, so sites compare by pointer (a header can
+    // show up once per translation unit)
+    for (uint32_t ix = 0; ix < stats->sites_count; ix++) {
+        ei_dsp_alloc_site_t *site = &stats->sites[ix];
+        if (site->line == line && site->file == file) {
+            site->count++;
+            site->bytes += bytes;
+            return;
+        }
+    }
+    if (stats->sites_count == EIDSP_ALLOC_STATS_MAX_SITES) {
+        stats->sites_dropped++;
+        return;
+    }
+    ei_dsp_alloc_site_t *site = &stats->sites[stats->sites_count++];
+    site->fn = fn;
+    site->file = file;
+    site->line = line;
+    site->count = 1;
+    site->bytes = bytes;
+}
+
+/**
+ * Count a free in the stats of the current thread. Memory allocated before
+ * the tracked call (e.g. an evicted FFT plan) does not count as in use.
+ */
+static inline void ei_dsp_alloc_stats_free(const char *fn, const char *file, int line, size_t bytes, void *ptr)
+{
+    ei_dsp_printf("free %lu bytes (%s@%s:%d) %p\n", (unsigned long)bytes, fn, file, line, ptr);
+
+    ei_dsp_alloc_stats_t *stats = ei_dsp_alloc_stats_current();
+    if (!stats) {
+        return;
+    }
+
+    stats->frees++;
+    stats->in_use = bytes < stats->in_use ? stats->in_use - bytes : 0;
+}
+
+/**
+ * Tracks the DSP allocations of the current thread for as long as it lives,
+ * for one in EIDSP_ALLOC_STATS_SAMPLE_EVERY scopes (counted per thread), and
+ * copies the stats out when it goes. A scope opened while another one is
+ * tracking on the same thread (an entry point calling another one) leaves
+ * the stats to the outer scope.
+ */
+class ei_dsp_alloc_stats_scope {
+public:
+    ei_dsp_alloc_stats_scope(ei_dsp_alloc_stats_t *out) : _out(NULL)
+    {
+        static EIDSP_THREAD_LOCAL uint32_t calls = 0;
+        // Recorded apart from `out`, entry points clear their result
+        static EIDSP_THREAD_LOCAL ei_dsp_alloc_stats_t recorded;
+
+        if (ei_dsp_alloc_stats_current()) {
+            return;
+        }
+
+        out->sampled = 0;
+        if (++calls < EIDSP_ALLOC_STATS_SAMPLE_EVERY) {
+            return;
+        }
+        calls = 0;
+
+        memset(&recorded, 0, sizeof(ei_dsp_alloc_stats_t));
+        recorded.sampled = 1;
+        _out = out;
+        ei_dsp_alloc_stats_current() = &recorded;
+    }
+
+    ~ei_dsp_alloc_stats_scope()
+    {
+        if (_out) {
+            *_out = *ei_dsp_alloc_stats_current();
+            ei_dsp_alloc_stats_current() = NULL;
+        }
+    }
+
+private:
+    ei_dsp_alloc_stats_t *_out;
+};
+
+/**
+ * Track the DSP allocations until the end of the enclosing block into the
+ * alloc_stats of a result (no-op without EIDSP_TRACK_ALLOCATIONS)
+ */
+#define EI_DSP_ALLOC_STATS_SCOPE(stats) ei::ei_dsp_alloc_stats_scope __ei_alloc_stats_scope__(stats)
+
     /**
      * Register a manual allocation (malloc or calloc).
      * Typically you want to use ei::matrix_t types, as they keep track automatically.
      * @param bytes Number of bytes allocated
      */
     #define ei_dsp_register_alloc_internal(fn, file, line, bytes, ptr) \
-        ei_memory_in_use += bytes; \
-        if (ei_memory_in_use > ei_memory_peak_use) { \
-            ei_memory_peak_use = ei_memory_in_use; \
-        } \
-        ei_dsp_printf("alloc %lu bytes (in_use=%lu, peak=%lu) (%s@%s:%d) %p\n", \
-            (unsigned long)bytes, (unsigned long)ei_memory_in_use, (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
+        ei::ei_dsp_alloc_stats_alloc(fn, file, line, bytes, ptr)
 
     /**
      * Register a matrix allocation. Don't call this function yourself,
@@ -78,22 +407,14 @@ namespace ei {
      * @param type_size Size of the data type
      */
     #define ei_dsp_register_matrix_alloc_internal(fn, file, line, rows, cols, type_size, ptr) \
-        ei_memory_in_use += (rows * cols * type_size); \
-        if (ei_memory_in_use > ei_memory_peak_use) { \
-            ei_memory_peak_use = ei_memory_in_use; \
-        } \
-        ei_dsp_printf("alloc matrix %lu x %lu = %lu bytes (in_use=%lu, peak=%lu) (%s@%s:%d) %p\n", \
-            (unsigned long)rows, (unsigned long)cols, (unsigned long)(rows * cols * type_size), (unsigned long)ei_memory_in_use, \
-                (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
+        ei::ei_dsp_alloc_stats_alloc(fn, file, line, (rows) * (cols) * (type_size), ptr)
 
     /**
      * Register free'ing manually allocated memory (allocated through malloc/calloc)
      * @param bytes Number of bytes free'd
      */
     #define ei_dsp_register_free_internal(fn, file, line, bytes, ptr) \
-        ei_memory_in_use -= bytes; \
-        ei_dsp_printf("free %lu bytes (in_use=%lu, peak=%lu) (%s@%s:%d) %p\n", \
-            (unsigned long)bytes, (unsigned long)ei_memory_in_use, (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
+        ei::ei_dsp_alloc_stats_free(fn, file, line, bytes, ptr)
 
     /**
      * Register a matrix free. Don't call this function yourself,
@@ -103,10 +424,7 @@ namespace ei {
      * @param type_size Size of the data type
      */
     #define ei_dsp_register_matrix_free_internal(fn, file, line, rows, cols, type_size, ptr) \
-        ei_memory_in_use -= (rows * cols * type_size); \
-        ei_dsp_printf("free matrix %lu x %lu = %lu bytes (in_use=%lu, peak=%lu) (%s@%s:%d) %p\n", \
-            (unsigned long)rows, (unsigned long)cols, (unsigned long)(rows * cols * type_size), \
-                (unsigned long)ei_memory_in_use, (unsigned long)ei_memory_peak_use, fn, file, line, ptr);
+        ei::ei_dsp_alloc_stats_free(fn, file, line, (rows) * (cols) * (type_size), ptr)
 
     #define ei_dsp_register_alloc(...) ei_dsp_register_alloc_internal(__func__, __FILE__, __LINE__, __VA_ARGS__)
     #define ei_dsp_register_matrix_alloc(...) ei_dsp_register_matrix_alloc_internal(__func__, __FILE__, __LINE__, __VA_ARGS__)
@@ -120,13 +438,14 @@ namespace ei {
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__, NULL, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX_B(name, ...) quantized_matrix_t name(__VA_ARGS__, __func__, __FILE__, __LINE__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
 #else
+    #define EI_DSP_ALLOC_STATS_SCOPE(stats) (void)0
     #define ei_dsp_register_alloc(...) (void)0
     #define ei_dsp_register_matrix_alloc(...) (void)0
     #define ei_dsp_register_free(...) (void)0
     #define ei_dsp_register_matrix_free(...) (void)0
-    #define ei_dsp_malloc ei_malloc
-    #define ei_dsp_calloc ei_calloc
-    #define ei_dsp_free(ptr, size) ei_free(ptr)
+    #define ei_dsp_malloc ei::ei_dsp_scratch_malloc
+    #define ei_dsp_calloc ei::ei_dsp_scratch_calloc
+    #define ei_dsp_free(ptr, size) ei::ei_dsp_scratch_free(ptr)
     #define EI_DSP_MATRIX(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_MATRIX_B(name, ...) matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
     #define EI_DSP_QUANTIZED_MATRIX(name, ...) quantized_matrix_t name(__VA_ARGS__); if (!name.buffer) { EIDSP_ERR(EIDSP_OUT_OF_MEM); }
@@ -143,7 +462,7 @@ public:
      * @param size The size of the memory block, in bytes.
      */
     static void *ei_wrapped_malloc(const char *fn, const char *file, int line, size_t size) {
-        void *ptr = ei_malloc(size);
+        void *ptr = ei_dsp_scratch_malloc(size);
         if (ptr) {
             ei_dsp_register_alloc_internal(fn, file, line, size, ptr);
         }
@@ -157,7 +476,7 @@ public:
      * @param size Size of each element
      */
     static void *ei_wrapped_calloc(const char *fn, const char *file, int line, size_t num, size_t size) {
-        void *ptr = ei_calloc(num, size);
+        void *ptr = ei_dsp_scratch_calloc(num, size);
         if (ptr) {
             ei_dsp_register_alloc_internal(fn, file, line, num * size, ptr);
         }
@@ -170,7 +489,7 @@ public:
      * @param size Size of the block of memory previously allocated.
      */
     static void ei_wrapped_free(const char *fn, const char *file, int line, void *ptr, size_t size) {
-        ei_free(ptr);
+        ei_dsp_scratch_free(ptr);
         ei_dsp_register_free_internal(fn, file, line, size, ptr);
     }
 };
@@ -39,6 +39,7 @@
 #include <algorithm>
 #include "numpy_types.h"
 #include "config.hpp"
+#include "numpy_simd.hpp"
 #include "returntypes.hpp"
 #include "memory.hpp"
 #include "ei_utils.h"
@@ -71,6 +72,63 @@ static constexpr float quantized_values_one_zero[] = { (0.0f / 1.0f), (1.0f / 10
     1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
 // clang-format on
 
+#if EIDSP_RFFT_PLAN_CACHE_SIZE < 1
+#error "EIDSP_RFFT_PLAN_CACHE_SIZE must be at least 1"
+#endif
+
+/**
+ * Real FFT plan for one FFT length, kept between calls to numpy::rfft():
+ * the CMSIS-DSP instance (power-of-two lengths on CMSIS-DSP targets) or the
+ * kissfft config, and aligned scratch for the FFT input and output.
+ */
+typedef struct {
+    size_t n_fft;                   // FFT length, 0 if the plan is unused
+    float *input;                   // n_fft values
+    float *output;                  // n_fft + 2 values (n_fft / 2 + 1 complex)
+    void *scratch;                  // Allocation behind input and output
+    size_t scratch_size;
+    kiss_fftr_cfg kiss_cfg;         // NULL if CMSIS-DSP runs the FFT
+    size_t kiss_cfg_size;
+#if EIDSP_USE_CMSIS_DSP
+    arm_rfft_fast_instance_f32 cmsis_instance;
+#endif
+} ei_rfft_plan_t;
+
+/**
+ * Free the kissfft config and scratch of a plan
+ */
+static inline void ei_rfft_plan_free(ei_rfft_plan_t *plan)
+{
+    if (plan->kiss_cfg) {
+        ei_free(plan->kiss_cfg);
+        ei_dsp_register_free(plan->kiss_cfg_size, plan->kiss_cfg);
+    }
+    if (plan->scratch) {
+        ei_free(plan->scratch);
+        ei_dsp_register_free(plan->scratch_size, plan->scratch);
+    }
+    memset(plan, 0, sizeof(ei_rfft_plan_t));
+}
+
+/**
+ * Plans of the current thread, most recently created last. The plans are
+ * freed when the thread exits (or with numpy::rfft_free_plans()).
+ */
+struct ei_rfft_plan_cache_t {
+    ei_rfft_plan_t plans[EIDSP_RFFT_PLAN_CACHE_SIZE];
+    size_t next_evict;
+
+    ei_rfft_plan_cache_t() : next_evict(0) {
+        memset(plans, 0, sizeof(plans));
+    }
+
+    ~ei_rfft_plan_cache_t() {
+        for (size_t ix = 0; ix < EIDSP_RFFT_PLAN_CACHE_SIZE; ix++) {
+            ei_rfft_plan_free(&plans[ix]);
+        }
+    }
+};
+
 class numpy {
 public:
     
@@ -293,6 +351,9 @@ public:
         if (status != ARM_MATH_SUCCESS) {
             EIDSP_ERR(status);
         }
+#elif EIDSP_SIMD
+        numpy_simd::dot_row(row, matrix1_cols, matrix2->buffer, matrix2->cols,
+            out_matrix->buffer + (i * matrix2->cols));
 #else
         for (size_t j = 0; j < matrix2->cols; j++) {
             float tmp = 0.0f;
@@ -682,6 +743,8 @@ public:
         if (status != ARM_MATH_SUCCESS) {
             return status;
         }
+#elif EIDSP_SIMD
+        numpy_simd::scale(matrix->buffer, matrix->rows * matrix->cols, scale);
 #else
         for (size_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] *= scale;
@@ -724,9 +787,13 @@ public:
      * @returns 0 if OK
      */
     static int add(matrix_t *matrix, float addition) {
+#if EIDSP_SIMD
+        numpy_simd::add(matrix->buffer, matrix->rows * matrix->cols, addition);
+#else
         for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] += addition;
         }
+#endif
         return EIDSP_OK;
     }
 
@@ -763,9 +830,13 @@ public:
      * @returns 0 if OK
      */
     static int subtract(matrix_t *matrix, float subtraction) {
+#if EIDSP_SIMD
+        numpy_simd::subtract(matrix->buffer, matrix->rows * matrix->cols, subtraction);
+#else
         for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] -= subtraction;
         }
+#endif
         return EIDSP_OK;
     }
 
@@ -815,6 +886,9 @@ public:
             float rms_result;
             arm_rms_f32(matrix->buffer + (row * matrix->cols), matrix->cols, &rms_result);
             output_matrix->buffer[row] = rms_result;
+#elif EIDSP_SIMD
+            float sum = numpy_simd::sum_squares(matrix->buffer + (row * matrix->cols), matrix->cols);
+            output_matrix->buffer[row] = sqrt(sum / static_cast<float>(matrix->cols));
 #else
             float sum = 0.0;
             for(size_t ix = 0; ix < matrix->cols; ix++) {
@@ -875,6 +949,10 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
+#if EIDSP_SIMD
+        numpy_simd::mean_axis0(input_matrix->buffer, input_matrix->rows, input_matrix->cols,
+            output_matrix->buffer);
+#else
         for (size_t col = 0; col < input_matrix->cols; col++) {
             // Note - not using CMSIS-DSP here
             // gathering up the current columnand moving it into sequential memory to use
@@ -890,6 +968,7 @@ public:
 
             output_matrix->buffer[col] = sum / input_matrix->rows;
         }
+#endif
 
         return EIDSP_OK;
     }
@@ -913,6 +992,10 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
+#if EIDSP_SIMD
+        numpy_simd::std_axis0(input_matrix->buffer, input_matrix->rows, input_matrix->cols,
+            output_matrix->buffer);
+#else
         for (size_t col = 0; col < input_matrix->cols; col++) {
             float sum = 0.0f;
 
@@ -931,6 +1014,7 @@ public:
 
             output_matrix->buffer[col] = sqrt(std / input_matrix->rows);
         }
+#endif
 
         return EIDSP_OK;
 #endif
@@ -955,6 +1039,9 @@ public:
             uint32_t ix;
             arm_min_f32(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols, &min, &ix);
             output_matrix->buffer[row] = min;
+#elif EIDSP_SIMD
+            output_matrix->buffer[row] = numpy_simd::min(input_matrix->buffer + (row * input_matrix->cols),
+                input_matrix->cols);
 #else
             float min = FLT_MAX;
 
@@ -991,6 +1078,9 @@ public:
             uint32_t ix;
             arm_max_f32(input_matrix->buffer + (row * input_matrix->cols), input_matrix->cols, &max, &ix);
             output_matrix->buffer[row] = max;
+#elif EIDSP_SIMD
+            output_matrix->buffer[row] = numpy_simd::max(input_matrix->buffer + (row * input_matrix->cols),
+                input_matrix->cols);
 #else
             float max = -FLT_MAX;
 
@@ -1213,65 +1303,12 @@ public:
             EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
         }
 
-        // truncate if needed
-        if (src_size > n_fft) {
-            src_size = n_fft;
-        }
-
-        // declare input and output arrays
-        EI_DSP_MATRIX(fft_input, 1, n_fft);
-        if (!fft_input.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        // copy from src to fft_input
-        memcpy(fft_input.buffer, src, src_size * sizeof(float));
-        // pad to the rigth with zeros
-        memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(kiss_fft_scalar));
-
-#if EIDSP_USE_CMSIS_DSP
-        if (n_fft != 32 && n_fft != 64 && n_fft != 128 && n_fft != 256 &&
-            n_fft != 512 && n_fft != 1024 && n_fft != 2048 && n_fft != 4096) {
-            int ret = software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(ret);
-            }
-        }
-        else {
-            // hardware acceleration only works for the powers above...
-            arm_rfft_fast_instance_f32 rfft_instance;
-            int status = cmsis_rfft_init_f32(&rfft_instance, n_fft);
-            if (status != ARM_MATH_SUCCESS) {
-                return status;
-            }
-
-            EI_DSP_MATRIX(fft_output, 1, n_fft);
-            if (!fft_output.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
-            }
-
-            arm_rfft_fast_f32(&rfft_instance, fft_input.buffer, fft_output.buffer, 0);
-
-            output[0] = fft_output.buffer[0];
-            output[n_fft_out_features - 1] = fft_output.buffer[1];
-
-            size_t fft_output_buffer_ix = 2;
-            for (size_t ix = 1; ix < n_fft_out_features - 1; ix += 1) {
-                float rms_result;
-                arm_rms_f32(fft_output.buffer + fft_output_buffer_ix, 2, &rms_result);
-                output[ix] = rms_result * sqrt(2);
+        ei_rfft_plan_t *plan;
+        EI_TRY(rfft_get_plan(n_fft, &plan));
 
-                fft_output_buffer_ix += 2;
-            }
-        }
-#else
-        int ret = software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
-        }
-#endif
+        rfft_load_input(plan, src, src_size);
 
-        return EIDSP_OK;
+        return rfft_magnitude(plan, output);
     }
 
 
@@ -1291,75 +1328,76 @@ public:
             EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
         }
 
-        // truncate if needed
-        if (src_size > n_fft) {
-            src_size = n_fft;
-        }
+        ei_rfft_plan_t *plan;
+        EI_TRY(rfft_get_plan(n_fft, &plan));
 
-        // declare input and output arrays
-        float *fft_input_buffer = NULL;
-        if (src_size == n_fft) {
-            fft_input_buffer = (float*)src;
-        }
-
-        EI_DSP_MATRIX_B(fft_input, 1, n_fft, fft_input_buffer);
-        if (!fft_input.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        if (!fft_input_buffer) {
-            // copy from src to fft_input
-            memcpy(fft_input.buffer, src, src_size * sizeof(float));
-            // pad to the rigth with zeros
-            memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(float));
-        }
+        rfft_load_input(plan, src, src_size);
 
 #if EIDSP_USE_CMSIS_DSP
-        if (n_fft != 32 && n_fft != 64 && n_fft != 128 && n_fft != 256 &&
-            n_fft != 512 && n_fft != 1024 && n_fft != 2048 && n_fft != 4096) {
-            int ret = software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(ret);
-            }
-        }
-        else {
-            // hardware acceleration only works for the powers above...
-            arm_rfft_fast_instance_f32 rfft_instance;
-            int status = cmsis_rfft_init_f32(&rfft_instance, n_fft);
-            if (status != ARM_MATH_SUCCESS) {
-                return status;
-            }
-
-            EI_DSP_MATRIX(fft_output, 1, n_fft);
-            if (!fft_output.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
-            }
-
-            arm_rfft_fast_f32(&rfft_instance, fft_input.buffer, fft_output.buffer, 0);
+        if (!plan->kiss_cfg) {
+            arm_rfft_fast_f32(&plan->cmsis_instance, plan->input, plan->output, 0);
 
-            output[0].r = fft_output.buffer[0];
+            output[0].r = plan->output[0];
             output[0].i = 0.0f;
-            output[n_fft_out_features - 1].r = fft_output.buffer[1];
+            output[n_fft_out_features - 1].r = plan->output[1];
             output[n_fft_out_features - 1].i = 0.0f;
 
             size_t fft_output_buffer_ix = 2;
             for (size_t ix = 1; ix < n_fft_out_features - 1; ix += 1) {
-                output[ix].r = fft_output.buffer[fft_output_buffer_ix];
-                output[ix].i = fft_output.buffer[fft_output_buffer_ix + 1];
+                output[ix].r = plan->output[fft_output_buffer_ix];
+                output[ix].i = plan->output[fft_output_buffer_ix + 1];
 
                 fft_output_buffer_ix += 2;
             }
-        }
-#else
-        int ret = software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
+
+            return EIDSP_OK;
         }
 #endif
 
+        kiss_fftr(plan->kiss_cfg, plan->input, (kiss_fft_cpx*)output);
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Magnitude rfft() of every row of a matrix, e.g. one row per axis. The
+     * plan is looked up once for all rows.
+     * @param input_matrix Input, one signal per row (zero-padded or truncated to n_fft)
+     * @param output_matrix Output, as many rows as the input and n_fft / 2 + 1 columns
+     * @param n_fft Number of FFT points
+     * @returns 0 if OK
+     */
+    static int rfft_batch(matrix_t *input_matrix, matrix_t *output_matrix, size_t n_fft) {
+        if (output_matrix->rows != input_matrix->rows) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+        if (output_matrix->cols != (n_fft / 2) + 1) {
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        }
+
+        ei_rfft_plan_t *plan;
+        EI_TRY(rfft_get_plan(n_fft, &plan));
+
+        for (size_t row = 0; row < input_matrix->rows; row++) {
+            rfft_load_input(plan, input_matrix->get_row_ptr(row), input_matrix->cols);
+            EI_TRY(rfft_magnitude(plan, output_matrix->get_row_ptr(row)));
+        }
+
         return EIDSP_OK;
     }
 
+    /**
+     * Free the FFT plans of the current thread. They are rebuilt on the
+     * next rfft() call.
+     */
+    static void rfft_free_plans() {
+        ei_rfft_plan_cache_t &cache = rfft_plan_cache();
+        for (size_t ix = 0; ix < EIDSP_RFFT_PLAN_CACHE_SIZE; ix++) {
+            ei_rfft_plan_free(&cache.plans[ix]);
+        }
+        cache.next_evict = 0;
+    }
+
 
     /**
      * Return evenly spaced numbers over a specified interval.
@@ -1633,7 +1671,11 @@ public:
      */
     static int log(matrix_t *matrix)
     {
-        for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
+        uint32_t ix = 0;
+#if EIDSP_SIMD_LOG
+        ix = numpy_simd::log(matrix->buffer, matrix->rows * matrix->cols);
+#endif
+        for (; ix < matrix->rows * matrix->cols; ix++) {
             matrix->buffer[ix] = numpy::log(matrix->buffer[ix]);
         }
 
@@ -1737,6 +1779,13 @@ public:
             EIDSP_ERR(EIDSP_PARAMETER_INVALID);
         }
 
+#if EIDSP_SIMD
+        if (min != DBL_MIN && max != DBL_MAX) {
+            numpy_simd::clip(matrix->buffer, matrix->rows * matrix->cols, min, max);
+            return EIDSP_OK;
+        }
+#endif
+
         for (size_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
             if (min != DBL_MIN && matrix->buffer[ix] < min) {
                 matrix->buffer[ix] = min;
@@ -1762,53 +1811,143 @@ public:
         return EIDSP_OK;
     }
 
-    static int software_rfft(float *fft_input, float *output, size_t n_fft, size_t n_fft_out_features) {
-        kiss_fft_cpx *fft_output = (kiss_fft_cpx*)ei_dsp_malloc(n_fft_out_features * sizeof(kiss_fft_cpx));
-        if (!fft_output) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    /**
+     * Plan cache of the current thread
+     */
+    static ei_rfft_plan_cache_t &rfft_plan_cache() {
+        static EIDSP_THREAD_LOCAL ei_rfft_plan_cache_t cache;
+        return cache;
+    }
+
+    /**
+     * Get the FFT plan for n_fft points from the plan cache of this thread,
+     * or build it (evicting the oldest plan if the cache is full)
+     * @param n_fft Number of FFT points
+     * @param plan Out pointer to the plan
+     * @returns 0 if OK
+     */
+    static int rfft_get_plan(size_t n_fft, ei_rfft_plan_t **plan) {
+        ei_rfft_plan_cache_t &cache = rfft_plan_cache();
+
+        for (size_t ix = 0; ix < EIDSP_RFFT_PLAN_CACHE_SIZE; ix++) {
+            if (cache.plans[ix].n_fft == n_fft) {
+                *plan = &cache.plans[ix];
+                return EIDSP_OK;
+            }
+        }
+
+        ei_rfft_plan_t *new_plan = &cache.plans[cache.next_evict];
+        cache.next_evict = (cache.next_evict + 1) % EIDSP_RFFT_PLAN_CACHE_SIZE;
+
+        ei_rfft_plan_free(new_plan);
+        int ret = rfft_plan_init(new_plan, n_fft);
+        if (ret != EIDSP_OK) {
+            ei_rfft_plan_free(new_plan);
+            return ret;
         }
 
-        size_t kiss_fftr_mem_length;
+        *plan = new_plan;
+        return EIDSP_OK;
+    }
 
-        // create fftr context
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
-        if (!cfg) {
-            ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
+    /**
+     * Build an FFT plan: the CMSIS-DSP instance for the power-of-two lengths
+     * it supports, the kissfft config otherwise, and the scratch buffers
+     * @param plan Empty plan
+     * @param n_fft Number of FFT points
+     * @returns 0 if OK
+     */
+    static int rfft_plan_init(ei_rfft_plan_t *plan, size_t n_fft) {
+        const size_t align = EIDSP_SCRATCH_ALIGNMENT;
+        size_t input_size = ((n_fft * sizeof(float)) + align - 1) & ~(align - 1);
+        size_t output_size = (n_fft + 2) * sizeof(float);
+
+        plan->scratch_size = input_size + output_size + align;
+        // plans outlive the call, so they are never carved from a scratch arena
+        plan->scratch = ei_malloc(plan->scratch_size);
+        if (!plan->scratch) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
+        ei_dsp_register_alloc(plan->scratch_size, plan->scratch);
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
+        uintptr_t aligned = ((uintptr_t)plan->scratch + align - 1) & ~(uintptr_t)(align - 1);
+        plan->input = (float *)aligned;
+        plan->output = (float *)(aligned + input_size);
 
-        // execute the rfft operation
-        kiss_fftr(cfg, fft_input, fft_output);
+#if EIDSP_USE_CMSIS_DSP
+        // hardware acceleration only works for the powers below...
+        if (n_fft == 32 || n_fft == 64 || n_fft == 128 || n_fft == 256 ||
+            n_fft == 512 || n_fft == 1024 || n_fft == 2048 || n_fft == 4096) {
+            int status = cmsis_rfft_init_f32(&plan->cmsis_instance, n_fft);
+            if (status != ARM_MATH_SUCCESS) {
+                return status;
+            }
+            plan->n_fft = n_fft;
+            return EIDSP_OK;
+        }
+#endif
 
-        // and write back to the output
-        for (size_t ix = 0; ix < n_fft_out_features; ix++) {
-            output[ix] = sqrt(pow(fft_output[ix].r, 2) + pow(fft_output[ix].i, 2));
+        plan->kiss_cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &plan->kiss_cfg_size);
+        if (!plan->kiss_cfg) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
-        ei_dsp_free(fft_output, n_fft_out_features * sizeof(kiss_fft_cpx));
+        ei_dsp_register_alloc(plan->kiss_cfg_size, plan->kiss_cfg);
 
+        plan->n_fft = n_fft;
         return EIDSP_OK;
     }
 
-    static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
-    {
-        // create fftr context
-        size_t kiss_fftr_mem_length;
+    /**
+     * Copy a signal into the FFT input of a plan, truncated or zero-padded
+     * to n_fft points
+     */
+    static void rfft_load_input(ei_rfft_plan_t *plan, const float *src, size_t src_size) {
+        if (src_size > plan->n_fft) {
+            src_size = plan->n_fft;
+        }
 
-        kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
-        if (!cfg) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        memcpy(plan->input, src, src_size * sizeof(float));
+        // pad to the right with zeros
+        memset(plan->input + src_size, 0, (plan->n_fft - src_size) * sizeof(float));
+    }
+
+    /**
+     * Run the FFT on the input of a plan and write the magnitude of the
+     * n_fft / 2 + 1 frequency bins
+     */
+    static int rfft_magnitude(ei_rfft_plan_t *plan, float *output) {
+        size_t n_fft_out_features = (plan->n_fft / 2) + 1;
+
+#if EIDSP_USE_CMSIS_DSP
+        if (!plan->kiss_cfg) {
+            arm_rfft_fast_f32(&plan->cmsis_instance, plan->input, plan->output, 0);
+
+            output[0] = plan->output[0];
+            output[n_fft_out_features - 1] = plan->output[1];
+
+            size_t fft_output_buffer_ix = 2;
+            for (size_t ix = 1; ix < n_fft_out_features - 1; ix += 1) {
+                float rms_result;
+                arm_rms_f32(plan->output + fft_output_buffer_ix, 2, &rms_result);
+                output[ix] = rms_result * sqrt(2);
+
+                fft_output_buffer_ix += 2;
+            }
+
+            return EIDSP_OK;
         }
+#endif
 
-        ei_dsp_register_alloc(kiss_fftr_mem_length, cfg);
+        kiss_fft_cpx *fft_output = (kiss_fft_cpx *)plan->output;
 
         // execute the rfft operation
-        kiss_fftr(cfg, fft_input, (kiss_fft_cpx*)output);
+        kiss_fftr(plan->kiss_cfg, plan->input, fft_output);
 
-        ei_dsp_free(cfg, kiss_fftr_mem_length);
+        // and write back to the output
+        for (size_t ix = 0; ix < n_fft_out_features; ix++) {
+            output[ix] = sqrt(pow(fft_output[ix].r, 2) + pow(fft_output[ix].i, 2));
+        }
 
         return EIDSP_OK;
     }
@@ -1825,6 +1964,60 @@ public:
         return 0;
     }
 
+    /**
+     * Read a subset of the axes of an interleaved signal (signal_t or any
+     * other signal type, see ei_signal_span.h). Whole frames are
+     * fetched with one get_data() call per chunk (instead of one call per
+     * value) and the selected axes are copied out of each frame.
+     * @param signal Interleaved signal, frame_size values per frame
+     * @param frame_size Number of axes in a frame of the signal
+     * @param axes Indices of the selected axes within a frame
+     * @param axes_count Number of selected axes
+     * @param offset Offset in the gathered signal (axes_count values per frame)
+     * @param length Number of gathered values to read
+     * @param out_ptr Output buffer
+     * @returns 0 if OK, or the error returned by get_data()
+     */
+    template<typename SignalT>
+    static int signal_gather_axes(SignalT *signal, size_t frame_size, const uint8_t *axes,
+        size_t axes_count, size_t offset, size_t length, float *out_ptr)
+    {
+        float chunk[EIDSP_SIGNAL_GATHER_CHUNK_SIZE];
+        size_t frames_per_chunk = EIDSP_SIGNAL_GATHER_CHUNK_SIZE / frame_size;
+        if (frames_per_chunk == 0 || axes_count == 0) {
+            return EIDSP_PARAMETER_INVALID;
+        }
+
+        size_t frame = offset / axes_count;
+        size_t axis_ix = offset % axes_count;
+        size_t out_ix = 0;
+
+        while (out_ix < length) {
+            // Frames still needed, from the frame of the next value on
+            size_t frames = (axis_ix + (length - out_ix) + axes_count - 1) / axes_count;
+            if (frames > frames_per_chunk) {
+                frames = frames_per_chunk;
+            }
+
+            int r = signal->get_data(frame * frame_size, frames * frame_size, chunk);
+            if (r != 0) {
+                return r;
+            }
+
+            const float *frame_ptr = chunk;
+            for (size_t fx = 0; fx < frames && out_ix < length; fx++) {
+                for (; axis_ix < axes_count && out_ix < length; axis_ix++) {
+                    out_ptr[out_ix++] = frame_ptr[axes[axis_ix]];
+                }
+                axis_ix = 0;
+                frame_ptr += frame_size;
+            }
+            frame += frames;
+        }
+
+        return 0;
+    }
+
 #if EIDSP_USE_CMSIS_DSP
     /**
      * @brief      The CMSIS std variance function with the same behaviour as the NumPy
@@ -1923,7 +2116,8 @@ public:
         /* Create transposed matrix */
         arm_transposed_matrix.numRows = input_matrix->cols;
         arm_transposed_matrix.numCols = input_matrix->rows;
-        arm_transposed_matrix.pData = (float *)ei_calloc(input_matrix->cols * input_matrix->rows * sizeof(float), 1);
+        size_t transposed_size = input_matrix->cols * input_matrix->rows * sizeof(float);
+        arm_transposed_matrix.pData = (float *)ei_dsp_calloc(transposed_size, 1);
 
         if (arm_transposed_matrix.pData == NULL) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
@@ -1931,6 +2125,7 @@ public:
 
         int ret = arm_mat_trans_f32(&arm_in_matrix, &arm_transposed_matrix);
         if (ret != EIDSP_OK) {
+            ei_dsp_free(arm_transposed_matrix.pData, transposed_size);
             EIDSP_ERR(ret);
         }
 
@@ -1945,7 +2140,7 @@ public:
             output_matrix->buffer[row] = std;
         }
 
-        ei_free(arm_transposed_matrix.pData);
+        ei_dsp_free(arm_transposed_matrix.pData, transposed_size);
 
         return EIDSP_OK;
     }
@@ -2354,9 +2549,9 @@ public:
         bool do_saved_point = false;
         size_t fft_out_size = fft_points / 2 + 1;
         float *fft_out;
-        ei_unique_ptr_t p_fft_out(nullptr, ei_free);
+        ei_unique_ptr_t p_fft_out(nullptr, ei_dsp_scratch_free);
         if (input_size < fft_points) {
-            fft_out = (float *)ei_calloc(fft_out_size, sizeof(float));
+            fft_out = (float *)ei_dsp_scratch_calloc(fft_out_size, sizeof(float));
             p_fft_out.reset(fft_out);
         }
         else {
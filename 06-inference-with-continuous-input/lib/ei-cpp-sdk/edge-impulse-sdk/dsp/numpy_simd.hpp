@@ -0,0 +1,518 @@
+/* Edge Impulse inferencing library
+ * Copyright (c) 2022 EdgeImpulse Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EIDSP_NUMPY_SIMD_H_
+#define _EIDSP_NUMPY_SIMD_H_
+
+/**
+ * SIMD kernels for the numpy ops on application processors (x86 and aarch64 hosts),
+ * the counterpart of the CMSIS-DSP paths on Cortex-M.
+ *
+ * The instruction set is picked at build time from the compiler flags:
+ *
+ *   AVX2        8 lanes, with -mavx2 (log() also needs -mfma)
+ *   SSE2        4 lanes, the x86-64 baseline, no flags needed
+ *   NEON        4 lanes, aarch64 (and armv7 with -mfpu=neon)
+ *
+ * Elementwise ops and the reductions that run over columns (mean_axis0, std_axis0,
+ * dot) keep the order of the scalar loops and give the same results. sum_squares()
+ * sums in lanes, so rms() can differ from the scalar loop in the last bits, like the
+ * CMSIS-DSP path does. NaN inputs are handled like the scalar loops on x86, NEON
+ * min/max propagate NaN. Set EIDSP_USE_SIMD to 0 to get the scalar loops.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include <float.h>
+#include "config.hpp"
+
+#if EIDSP_USE_SIMD && defined(__AVX2__)
+    #include <immintrin.h>
+    #define EIDSP_SIMD_AVX2              1
+    #define EIDSP_SIMD_WIDTH             8
+#elif EIDSP_USE_SIMD && defined(__SSE2__)
+    #if defined(__FMA__)
+        #include <immintrin.h>
+    #else
+        #include <emmintrin.h>
+    #endif
+    #define EIDSP_SIMD_SSE2              1
+    #define EIDSP_SIMD_WIDTH             4
+#elif EIDSP_USE_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+    #include <arm_neon.h>
+    #define EIDSP_SIMD_NEON              1
+    #define EIDSP_SIMD_WIDTH             4
+#else
+    #define EIDSP_SIMD_WIDTH             0
+#endif
+
+// numpy.hpp takes the SIMD paths if an instruction set was found
+#define EIDSP_SIMD                       (EIDSP_SIMD_WIDTH > 0)
+
+// numpy::log() uses fused multiply-adds, the vector version only matches it with FMA
+#if (EIDSP_SIMD_AVX2 || EIDSP_SIMD_SSE2) && defined(__FMA__)
+    #define EIDSP_SIMD_LOG               1
+#elif EIDSP_SIMD_NEON && defined(__aarch64__)
+    #define EIDSP_SIMD_LOG               1
+#else
+    #define EIDSP_SIMD_LOG               0
+#endif
+
+namespace ei {
+
+// Four float lanes, for kernels that map lanes to axes (e.g. the flatten moments).
+// NEON or SSE2 when available, a plain array (left to the auto-vectorizer) otherwise.
+#if EIDSP_SIMD_NEON
+typedef float32x4_t ei_dsp_f32x4_t;
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_load(const float *p) { return vld1q_f32(p); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_set1(float v) { return vdupq_n_f32(v); }
+static inline void ei_dsp_f32x4_store(float *p, ei_dsp_f32x4_t a) { vst1q_f32(p, a); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_add(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return vaddq_f32(a, b); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_sub(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return vsubq_f32(a, b); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_mul(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return vmulq_f32(a, b); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_min(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return vminq_f32(a, b); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_max(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return vmaxq_f32(a, b); }
+#elif EIDSP_SIMD_SSE2 || EIDSP_SIMD_AVX2
+typedef __m128 ei_dsp_f32x4_t;
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_load(const float *p) { return _mm_loadu_ps(p); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_set1(float v) { return _mm_set1_ps(v); }
+static inline void ei_dsp_f32x4_store(float *p, ei_dsp_f32x4_t a) { _mm_storeu_ps(p, a); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_add(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return _mm_add_ps(a, b); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_sub(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return _mm_sub_ps(a, b); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_mul(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return _mm_mul_ps(a, b); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_min(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return _mm_min_ps(a, b); }
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_max(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) { return _mm_max_ps(a, b); }
+#else
+typedef struct { float v[4]; } ei_dsp_f32x4_t;
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_load(const float *p) {
+    ei_dsp_f32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = p[i];
+    }
+    return r;
+}
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_set1(float v) {
+    ei_dsp_f32x4_t r;
+    for (int i = 0; i < 4; i++) {
+        r.v[i] = v;
+    }
+    return r;
+}
+static inline void ei_dsp_f32x4_store(float *p, ei_dsp_f32x4_t a) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = a.v[i];
+    }
+}
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_add(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) {
+    for (int i = 0; i < 4; i++) {
+        a.v[i] += b.v[i];
+    }
+    return a;
+}
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_sub(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) {
+    for (int i = 0; i < 4; i++) {
+        a.v[i] -= b.v[i];
+    }
+    return a;
+}
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_mul(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) {
+    for (int i = 0; i < 4; i++) {
+        a.v[i] *= b.v[i];
+    }
+    return a;
+}
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_min(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) {
+    for (int i = 0; i < 4; i++) {
+        a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i];
+    }
+    return a;
+}
+static inline ei_dsp_f32x4_t ei_dsp_f32x4_max(ei_dsp_f32x4_t a, ei_dsp_f32x4_t b) {
+    for (int i = 0; i < 4; i++) {
+        a.v[i] = b.v[i] > a.v[i] ? b.v[i] : a.v[i];
+    }
+    return a;
+}
+#endif
+
+#if EIDSP_SIMD
+
+// Native vector of EIDSP_SIMD_WIDTH float lanes
+#if EIDSP_SIMD_AVX2
+typedef __m256 ei_dsp_vf32_t;
+static inline ei_dsp_vf32_t ei_dsp_vf32_load(const float *p) { return _mm256_loadu_ps(p); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_set1(float v) { return _mm256_set1_ps(v); }
+static inline void ei_dsp_vf32_store(float *p, ei_dsp_vf32_t a) { _mm256_storeu_ps(p, a); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_add(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm256_add_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_sub(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm256_sub_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_mul(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm256_mul_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_div(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm256_div_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_min(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm256_min_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_max(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm256_max_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_sqrt(ei_dsp_vf32_t a) { return _mm256_sqrt_ps(a); }
+#elif EIDSP_SIMD_SSE2
+typedef __m128 ei_dsp_vf32_t;
+static inline ei_dsp_vf32_t ei_dsp_vf32_load(const float *p) { return _mm_loadu_ps(p); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_set1(float v) { return _mm_set1_ps(v); }
+static inline void ei_dsp_vf32_store(float *p, ei_dsp_vf32_t a) { _mm_storeu_ps(p, a); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_add(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm_add_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_sub(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm_sub_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_mul(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm_mul_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_div(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm_div_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_min(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm_min_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_max(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return _mm_max_ps(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_sqrt(ei_dsp_vf32_t a) { return _mm_sqrt_ps(a); }
+#elif EIDSP_SIMD_NEON
+typedef float32x4_t ei_dsp_vf32_t;
+static inline ei_dsp_vf32_t ei_dsp_vf32_load(const float *p) { return vld1q_f32(p); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_set1(float v) { return vdupq_n_f32(v); }
+static inline void ei_dsp_vf32_store(float *p, ei_dsp_vf32_t a) { vst1q_f32(p, a); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_add(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return vaddq_f32(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_sub(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return vsubq_f32(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_mul(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return vmulq_f32(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_min(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return vminq_f32(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_max(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return vmaxq_f32(a, b); }
+#if defined(__aarch64__)
+static inline ei_dsp_vf32_t ei_dsp_vf32_div(ei_dsp_vf32_t a, ei_dsp_vf32_t b) { return vdivq_f32(a, b); }
+static inline ei_dsp_vf32_t ei_dsp_vf32_sqrt(ei_dsp_vf32_t a) { return vsqrtq_f32(a); }
+#else
+// armv7 NEON has no exact divide or square root, go through the lanes
+static inline ei_dsp_vf32_t ei_dsp_vf32_div(ei_dsp_vf32_t a, ei_dsp_vf32_t b) {
+    float ta[4], tb[4];
+    vst1q_f32(ta, a);
+    vst1q_f32(tb, b);
+    for (int i = 0; i < 4; i++) {
+        ta[i] = ta[i] / tb[i];
+    }
+    return vld1q_f32(ta);
+}
+static inline ei_dsp_vf32_t ei_dsp_vf32_sqrt(ei_dsp_vf32_t a) {
+    float ta[4];
+    vst1q_f32(ta, a);
+    for (int i = 0; i < 4; i++) {
+        ta[i] = sqrtf(ta[i]);
+    }
+    return vld1q_f32(ta);
+}
+#endif
+#endif
+
+#if EIDSP_SIMD_LOG
+/**
+ * Lane-wise numpy::log(), the same steps with vector fused multiply-adds
+ */
+#if EIDSP_SIMD_AVX2
+static inline ei_dsp_vf32_t ei_dsp_vf32_log(ei_dsp_vf32_t a) {
+    __m256i g = _mm256_castps_si256(a);
+    __m256i e = _mm256_and_si256(_mm256_sub_epi32(g, _mm256_set1_epi32(0x3f2aaaab)),
+        _mm256_set1_epi32((int32_t)0xff800000));
+    __m256 m = _mm256_castsi256_ps(_mm256_sub_epi32(g, e));
+    __m256 i = _mm256_mul_ps(_mm256_cvtepi32_ps(e), _mm256_set1_ps(1.19209290e-7f));
+    __m256 f = _mm256_sub_ps(m, _mm256_set1_ps(1.0f));
+    __m256 s = _mm256_mul_ps(f, f);
+    __m256 r = _mm256_fmadd_ps(_mm256_set1_ps(0.230836749f), f, _mm256_set1_ps(-0.279208571f));
+    __m256 t = _mm256_fmadd_ps(_mm256_set1_ps(0.331826031f), f, _mm256_set1_ps(-0.498910338f));
+    r = _mm256_fmadd_ps(r, s, t);
+    r = _mm256_fmadd_ps(r, s, f);
+    return _mm256_fmadd_ps(i, _mm256_set1_ps(0.693147182f), r);
+}
+#elif EIDSP_SIMD_SSE2
+static inline ei_dsp_vf32_t ei_dsp_vf32_log(ei_dsp_vf32_t a) {
+    __m128i g = _mm_castps_si128(a);
+    __m128i e = _mm_and_si128(_mm_sub_epi32(g, _mm_set1_epi32(0x3f2aaaab)),
+        _mm_set1_epi32((int32_t)0xff800000));
+    __m128 m = _mm_castsi128_ps(_mm_sub_epi32(g, e));
+    __m128 i = _mm_mul_ps(_mm_cvtepi32_ps(e), _mm_set1_ps(1.19209290e-7f));
+    __m128 f = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+    __m128 s = _mm_mul_ps(f, f);
+    __m128 r = _mm_fmadd_ps(_mm_set1_ps(0.230836749f), f, _mm_set1_ps(-0.279208571f));
+    __m128 t = _mm_fmadd_ps(_mm_set1_ps(0.331826031f), f, _mm_set1_ps(-0.498910338f));
+    r = _mm_fmadd_ps(r, s, t);
+    r = _mm_fmadd_ps(r, s, f);
+    return _mm_fmadd_ps(i, _mm_set1_ps(0.693147182f), r);
+}
+#elif EIDSP_SIMD_NEON
+static inline ei_dsp_vf32_t ei_dsp_vf32_log(ei_dsp_vf32_t a) {
+    int32x4_t g = vreinterpretq_s32_f32(a);
+    int32x4_t e = vandq_s32(vsubq_s32(g, vdupq_n_s32(0x3f2aaaab)), vdupq_n_s32((int32_t)0xff800000));
+    float32x4_t m = vreinterpretq_f32_s32(vsubq_s32(g, e));
+    float32x4_t i = vmulq_f32(vcvtq_f32_s32(e), vdupq_n_f32(1.19209290e-7f));
+    float32x4_t f = vsubq_f32(m, vdupq_n_f32(1.0f));
+    float32x4_t s = vmulq_f32(f, f);
+    float32x4_t r = vfmaq_f32(vdupq_n_f32(-0.279208571f), vdupq_n_f32(0.230836749f), f);
+    float32x4_t t = vfmaq_f32(vdupq_n_f32(-0.498910338f), vdupq_n_f32(0.331826031f), f);
+    r = vfmaq_f32(t, r, s);
+    r = vfmaq_f32(f, r, s);
+    return vfmaq_f32(r, i, vdupq_n_f32(0.693147182f));
+}
+#endif
+#endif // EIDSP_SIMD_LOG
+
+class numpy_simd {
+public:
+    /**
+     * Multiply every value by scale
+     */
+    static void scale(float *buffer, size_t size, float scale) {
+        const ei_dsp_vf32_t vscale = ei_dsp_vf32_set1(scale);
+        size_t ix = 0;
+        for (; ix + EIDSP_SIMD_WIDTH <= size; ix += EIDSP_SIMD_WIDTH) {
+            ei_dsp_vf32_store(buffer + ix, ei_dsp_vf32_mul(ei_dsp_vf32_load(buffer + ix), vscale));
+        }
+        for (; ix < size; ix++) {
+            buffer[ix] *= scale;
+        }
+    }
+
+    /**
+     * Add addition to every value
+     */
+    static void add(float *buffer, size_t size, float addition) {
+        const ei_dsp_vf32_t vaddition = ei_dsp_vf32_set1(addition);
+        size_t ix = 0;
+        for (; ix + EIDSP_SIMD_WIDTH <= size; ix += EIDSP_SIMD_WIDTH) {
+            ei_dsp_vf32_store(buffer + ix, ei_dsp_vf32_add(ei_dsp_vf32_load(buffer + ix), vaddition));
+        }
+        for (; ix < size; ix++) {
+            buffer[ix] += addition;
+        }
+    }
+
+    /**
+     * Subtract subtraction from every value
+     */
+    static void subtract(float *buffer, size_t size, float subtraction) {
+        const ei_dsp_vf32_t vsubtraction = ei_dsp_vf32_set1(subtraction);
+        size_t ix = 0;
+        for (; ix + EIDSP_SIMD_WIDTH <= size; ix += EIDSP_SIMD_WIDTH) {
+            ei_dsp_vf32_store(buffer + ix, ei_dsp_vf32_sub(ei_dsp_vf32_load(buffer + ix), vsubtraction));
+        }
+        for (; ix < size; ix++) {
+            buffer[ix] -= subtraction;
+        }
+    }
+
+    /**
+     * Limit every value to [min, max]. NaN stays NaN.
+     */
+    static void clip(float *buffer, size_t size, float min, float max) {
+        const ei_dsp_vf32_t vmin = ei_dsp_vf32_set1(min);
+        const ei_dsp_vf32_t vmax = ei_dsp_vf32_set1(max);
+        size_t ix = 0;
+        for (; ix + EIDSP_SIMD_WIDTH <= size; ix += EIDSP_SIMD_WIDTH) {
+            // SSE min/max return the second operand if either is NaN, so NaN passes through
+            ei_dsp_vf32_t v = ei_dsp_vf32_max(vmin, ei_dsp_vf32_load(buffer + ix));
+            ei_dsp_vf32_store(buffer + ix, ei_dsp_vf32_min(vmax, v));
+        }
+        for (; ix < size; ix++) {
+            if (buffer[ix] < min) {
+                buffer[ix] = min;
+            }
+            else if (buffer[ix] > max) {
+                buffer[ix] = max;
+            }
+        }
+    }
+
+    /**
+     * Smallest value (FLT_MAX if size is 0)
+     */
+    static float min(const float *buffer, size_t size) {
+        float min = FLT_MAX;
+        size_t ix = 0;
+        if (size >= EIDSP_SIMD_WIDTH) {
+            // the accumulator goes second, SSE then skips NaN like the scalar loop
+            ei_dsp_vf32_t vmin = ei_dsp_vf32_set1(FLT_MAX);
+            for (; ix + EIDSP_SIMD_WIDTH <= size; ix += EIDSP_SIMD_WIDTH) {
+                vmin = ei_dsp_vf32_min(ei_dsp_vf32_load(buffer + ix), vmin);
+            }
+            float lanes[EIDSP_SIMD_WIDTH];
+            ei_dsp_vf32_store(lanes, vmin);
+            for (size_t lane = 0; lane < EIDSP_SIMD_WIDTH; lane++) {
+                if (lanes[lane] < min) {
+                    min = lanes[lane];
+                }
+            }
+        }
+        for (; ix < size; ix++) {
+            if (buffer[ix] < min) {
+                min = buffer[ix];
+            }
+        }
+        return min;
+    }
+
+    /**
+     * Largest value (-FLT_MAX if size is 0)
+     */
+    static float max(const float *buffer, size_t size) {
+        float max = -FLT_MAX;
+        size_t ix = 0;
+        if (size >= EIDSP_SIMD_WIDTH) {
+            // the accumulator goes second, SSE then skips NaN like the scalar loop
+            ei_dsp_vf32_t vmax = ei_dsp_vf32_set1(-FLT_MAX);
+            for (; ix + EIDSP_SIMD_WIDTH <= size; ix += EIDSP_SIMD_WIDTH) {
+                vmax = ei_dsp_vf32_max(ei_dsp_vf32_load(buffer + ix), vmax);
+            }
+            float lanes[EIDSP_SIMD_WIDTH];
+            ei_dsp_vf32_store(lanes, vmax);
+            for (size_t lane = 0; lane < EIDSP_SIMD_WIDTH; lane++) {
+                if (lanes[lane] > max) {
+                    max = lanes[lane];
+                }
+            }
+        }
+        for (; ix < size; ix++) {
+            if (buffer[ix] > max) {
+                max = buffer[ix];
+            }
+        }
+        return max;
+    }
+
+    /**
+     * Sum of the squared values. Summed per lane, then the lanes in order.
+     */
+    static float sum_squares(const float *buffer, size_t size) {
+        ei_dsp_vf32_t vsum = ei_dsp_vf32_set1(0.0f);
+        size_t ix = 0;
+        for (; ix + EIDSP_SIMD_WIDTH <= size; ix += EIDSP_SIMD_WIDTH) {
+            ei_dsp_vf32_t v = ei_dsp_vf32_load(buffer + ix);
+            vsum = ei_dsp_vf32_add(vsum, ei_dsp_vf32_mul(v, v));
+        }
+
+        float lanes[EIDSP_SIMD_WIDTH];
+        ei_dsp_vf32_store(lanes, vsum);
+        float sum = 0.0f;
+        for (size_t lane = 0; lane < EIDSP_SIMD_WIDTH; lane++) {
+            sum += lanes[lane];
+        }
+        for (; ix < size; ix++) {
+            sum += buffer[ix] * buffer[ix];
+        }
+        return sum;
+    }
+
+    /**
+     * Mean of every column of a (rows x cols) matrix. The lanes run over columns, so
+     * every column is summed in row order, like the scalar loop.
+     */
+    static void mean_axis0(const float *buffer, size_t rows, size_t cols, float *output) {
+        const ei_dsp_vf32_t vrows = ei_dsp_vf32_set1((float)rows);
+        size_t col = 0;
+        for (; col + EIDSP_SIMD_WIDTH <= cols; col += EIDSP_SIMD_WIDTH) {
+            ei_dsp_vf32_t vsum = ei_dsp_vf32_set1(0.0f);
+            for (size_t row = 0; row < rows; row++) {
+                vsum = ei_dsp_vf32_add(vsum, ei_dsp_vf32_load(buffer + (row * cols) + col));
+            }
+            ei_dsp_vf32_store(output + col, ei_dsp_vf32_div(vsum, vrows));
+        }
+        for (; col < cols; col++) {
+            float sum = 0.0f;
+            for (size_t row = 0; row < rows; row++) {
+                sum += buffer[(row * cols) + col];
+            }
+            output[col] = sum / rows;
+        }
+    }
+
+    /**
+     * Population standard deviation of every column of a (rows x cols) matrix, in the
+     * same order as the scalar loop (see mean_axis0)
+     */
+    static void std_axis0(const float *buffer, size_t rows, size_t cols, float *output) {
+        const ei_dsp_vf32_t vrows = ei_dsp_vf32_set1((float)rows);
+        size_t col = 0;
+        for (; col + EIDSP_SIMD_WIDTH <= cols; col += EIDSP_SIMD_WIDTH) {
+            ei_dsp_vf32_t vsum = ei_dsp_vf32_set1(0.0f);
+            for (size_t row = 0; row < rows; row++) {
+                vsum = ei_dsp_vf32_add(vsum, ei_dsp_vf32_load(buffer + (row * cols) + col));
+            }
+            ei_dsp_vf32_t vmean = ei_dsp_vf32_div(vsum, vrows);
+
+            ei_dsp_vf32_t vstd = ei_dsp_vf32_set1(0.0f);
+            for (size_t row = 0; row < rows; row++) {
+                ei_dsp_vf32_t diff = ei_dsp_vf32_sub(ei_dsp_vf32_load(buffer + (row * cols) + col), vmean);
+                vstd = ei_dsp_vf32_add(vstd, ei_dsp_vf32_mul(diff, diff));
+            }
+            ei_dsp_vf32_store(output + col, ei_dsp_vf32_sqrt(ei_dsp_vf32_div(vstd, vrows)));
+        }
+        for (; col < cols; col++) {
+            float sum = 0.0f;
+            for (size_t row = 0; row < rows; row++) {
+                sum += buffer[(row * cols) + col];
+            }
+            float mean = sum / rows;
+
+            float std = 0.0f;
+            for (size_t row = 0; row < rows; row++) {
+                float diff = buffer[(row * cols) + col] - mean;
+                std += diff * diff;
+            }
+            output[col] = sqrtf(std / rows);
+        }
+    }
+
+    /**
+     * Add row (1 x inner) times matrix (inner x cols) to output (1 x cols). The lanes
+     * run over the output columns, every column is summed in the scalar loop's order.
+     */
+    static void dot_row(const float *row, size_t inner, const float *matrix, size_t cols, float *output) {
+        size_t col = 0;
+        for (; col + EIDSP_SIMD_WIDTH <= cols; col += EIDSP_SIMD_WIDTH) {
+            ei_dsp_vf32_t vsum = ei_dsp_vf32_set1(0.0f);
+            for (size_t k = 0; k < inner; k++) {
+                vsum = ei_dsp_vf32_add(vsum,
+                    ei_dsp_vf32_mul(ei_dsp_vf32_set1(row[k]), ei_dsp_vf32_load(matrix + (k * cols) + col)));
+            }
+            ei_dsp_vf32_store(output + col, ei_dsp_vf32_add(ei_dsp_vf32_load(output + col), vsum));
+        }
+        for (; col < cols; col++) {
+            float sum = 0.0f;
+            for (size_t k = 0; k < inner; k++) {
+                sum += row[k] * matrix[(k * cols) + col];
+            }
+            output[col] += sum;
+        }
+    }
+
+#if EIDSP_SIMD_LOG
+    /**
+     * numpy::log() in place over the whole vectors at the start of the buffer
+     * @returns Number of values done, numpy::log() does the rest
+     */
+    static size_t log(float *buffer, size_t size) {
+        size_t ix = 0;
+        for (; ix + EIDSP_SIMD_WIDTH <= size; ix += EIDSP_SIMD_WIDTH) {
+            ei_dsp_vf32_store(buffer + ix, ei_dsp_vf32_log(ei_dsp_vf32_load(buffer + ix)));
+        }
+        return ix;
+    }
+#endif // EIDSP_SIMD_LOG
+};
+
+#endif // EIDSP_SIMD
+
+} // namespace ei
+
+#endif // _EIDSP_NUMPY_SIMD_H_
@@ -37,9 +37,9 @@
 
 #include "../porting/ei_classifier_porting.h"
 
-#if EIDSP_TRACK_ALLOCATIONS
+#ifdef __cplusplus
 #include "memory.hpp"
-#endif
+#endif // __cplusplus
 
 #ifdef __cplusplus
 namespace ei {
@@ -96,7 +96,7 @@ typedef struct ei_matrix {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (float*)ei_calloc(n_rows * n_cols * sizeof(float), 1);
+            buffer = (float*)ei_dsp_scratch_calloc(n_rows * n_cols * sizeof(float), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -121,7 +121,7 @@ typedef struct ei_matrix {
 
     ~ei_matrix() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei_dsp_scratch_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -193,7 +193,7 @@ typedef struct ei_matrix_i8 {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (int8_t*)ei_calloc(n_rows * n_cols * sizeof(int8_t), 1);
+            buffer = (int8_t*)ei_dsp_scratch_calloc(n_rows * n_cols * sizeof(int8_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -218,7 +218,7 @@ typedef struct ei_matrix_i8 {
 
     ~ei_matrix_i8() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei_dsp_scratch_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
@@ -300,7 +300,7 @@ typedef struct ei_quantized_matrix {
             buffer_managed_by_me = false;
         }
         else {
-            buffer = (uint8_t*)ei_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
+            buffer = (uint8_t*)ei_dsp_scratch_calloc(n_rows * n_cols * sizeof(uint8_t), 1);
             buffer_managed_by_me = true;
         }
         rows = n_rows;
@@ -325,7 +325,7 @@ typedef struct ei_quantized_matrix {
 
     ~ei_quantized_matrix() {
         if (buffer && buffer_managed_by_me) {
-            ei_free(buffer);
+            ei_dsp_scratch_free(buffer);
 
 #if EIDSP_TRACK_ALLOCATIONS
             if (_fn) {
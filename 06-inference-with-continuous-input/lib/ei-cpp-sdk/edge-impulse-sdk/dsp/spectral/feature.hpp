@@ -126,8 +126,34 @@ public:
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        // find peaks in FFT
-        EI_DSP_MATRIX(peaks_matrix, axes, fft_peaks * 2);
+        // calculate the FFT of all axes at once
+        EI_DSP_MATRIX(fft_axes_matrix, axes, fft_length / 2 + 1);
+        ret = numpy::rfft_batch(input_matrix, &fft_axes_matrix, fft_length);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        // multiply by 2/N
+        numpy::scale(&fft_axes_matrix, (2.0f / static_cast<float>(fft_length)));
+
+        // per axis buffers, every axis overwrites them completely
+        EI_DSP_MATRIX(peaks_matrix, fft_peaks, 2);
+        EI_DSP_MATRIX(period_fft_matrix, 1, fft_length / 2 + 1);
+        EI_DSP_MATRIX(period_freq_matrix, 1, fft_length / 2 + 1);
+        EI_DSP_MATRIX(edges_matrix_out, edges_matrix_in->rows - 1, 1);
+
+        // and the scratch of the peak, periodogram and power edge helpers
+        EI_DSP_MATRIX(freq_space, 1, fft_length / 2 + 1);
+        ret = spectral::processing::fft_peaks_freq_space(&freq_space, sampling_freq, fft_length);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+        EI_DSP_MATRIX(peak_indexes, fft_peaks * 10, 1);
+        std::vector<spectral::processing::freq_peak_t> peaks;
+        peaks.reserve(fft_peaks * 10);
+        EI_DSP_MATRIX(period_fft_output, 1, (fft_length / 2 + 1) * 2);
+        EI_DSP_MATRIX(edges_buckets, 1, edges_matrix_in->rows - 1);
+        EI_DSP_MATRIX(edges_bucket_count, 1, edges_matrix_in->rows - 1);
 
         for (size_t row = 0; row < input_matrix->rows; row++) {
             // per axis code
@@ -135,40 +161,32 @@ public:
             // get a slice of the current axis
             EI_DSP_MATRIX_B(axis_matrix, 1, input_matrix->cols, input_matrix->buffer + (row * input_matrix->cols));
 
-            // calculate FFT
-            EI_DSP_MATRIX(fft_matrix, 1, fft_length / 2 + 1);
-            ret = numpy::rfft(axis_matrix.buffer, axis_matrix.cols, fft_matrix.buffer, fft_matrix.cols, fft_length);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
-            }
-
-            // multiply by 2/N
-            numpy::scale(&fft_matrix, (2.0f / static_cast<float>(fft_length)));
+            // and of its FFT
+            EI_DSP_MATRIX_B(fft_matrix, 1, fft_axes_matrix.cols, fft_axes_matrix.buffer + (row * fft_axes_matrix.cols));
 
             // we're now using the FFT matrix to calculate peaks etc.
-            EI_DSP_MATRIX(peaks_matrix, fft_peaks, 2);
             ret = spectral::processing::find_fft_peaks(&fft_matrix, &peaks_matrix,
-                sampling_freq, fft_peaks_threshold, fft_length);
+                fft_peaks_threshold, &freq_space, &peak_indexes, &peaks);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
             }
 
             // calculate periodogram for spectral power buckets
-            EI_DSP_MATRIX(period_fft_matrix, 1, fft_length / 2 + 1);
-            EI_DSP_MATRIX(period_freq_matrix, 1, fft_length / 2 + 1);
             ret = spectral::processing::periodogram(&axis_matrix,
-                &period_fft_matrix, &period_freq_matrix, sampling_freq, fft_length);
+                &period_fft_matrix, &period_freq_matrix, sampling_freq, fft_length,
+                reinterpret_cast<fft_complex_t *>(period_fft_output.buffer));
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(ret);
             }
 
-            EI_DSP_MATRIX(edges_matrix_out, edges_matrix_in->rows - 1, 1);
             ret = spectral::processing::spectral_power_edges(
                 &period_fft_matrix,
                 &period_freq_matrix,
                 edges_matrix_in,
                 &edges_matrix_out,
-                sampling_freq);
+                sampling_freq,
+                &edges_buckets,
+                &edges_bucket_count);
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(ret);
             }
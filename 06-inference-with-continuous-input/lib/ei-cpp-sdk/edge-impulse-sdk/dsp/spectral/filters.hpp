@@ -33,6 +33,17 @@
 namespace ei {
 namespace spectral {
 namespace filters {
+    /**
+     * Number of floats of scratch that butterworth_lowpass() and
+     * butterworth_highpass() need (filter coefficients and state)
+     * @param filter_order Even filter order (between 2..8)
+     */
+    static size_t butterworth_scratch_size(int filter_order)
+    {
+        size_t n_steps = filter_order > 1 ? filter_order / 2 : 0;
+        return n_steps * 6 > 0 ? n_steps * 6 : 1;
+    }
+
     /**
      * The Butterworth filter has maximally flat frequency response in the passband.
      * @param filter_order Even filter order (between 2..8)
@@ -41,6 +52,8 @@ namespace filters {
      * @param src Source array
      * @param dest Destination array
      * @param size Size of both source and destination arrays
+     * @param scratch butterworth_scratch_size() floats, so filtering several
+     *      rows does not allocate per row
      */
     static void butterworth_lowpass(
         int filter_order,
@@ -48,17 +61,19 @@ namespace filters {
         float cutoff_freq,
         const float *src,
         float *dest,
-        size_t size)
+        size_t size,
+        float *scratch)
     {
         int n_steps = filter_order / 2;
         float a = tan(M_PI * cutoff_freq / sampling_freq);
         float a2 = pow(a, 2);
-        float *A = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d2 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w0 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w2 = (float*)ei_calloc(n_steps, sizeof(float));
+        memset(scratch, 0, butterworth_scratch_size(filter_order) * sizeof(float));
+        float *A = scratch;
+        float *d1 = A + n_steps;
+        float *d2 = d1 + n_steps;
+        float *w0 = d2 + n_steps;
+        float *w1 = w0 + n_steps;
+        float *w2 = w1 + n_steps;
 
         // Calculate the filter parameters
         for(int ix = 0; ix < n_steps; ix++) {
@@ -80,13 +95,29 @@ namespace filters {
                 w1[i] = w0[i];
             }
         }
+    }
 
-        ei_free(A);
-        ei_free(d1);
-        ei_free(d2);
-        ei_free(w0);
-        ei_free(w1);
-        ei_free(w2);
+    /**
+     * The Butterworth filter has maximally flat frequency response in the passband.
+     * @param filter_order Even filter order (between 2..8)
+     * @param sampling_freq Sample frequency of the signal
+     * @param cutoff_freq Cut-off frequency of the signal
+     * @param src Source array
+     * @param dest Destination array
+     * @param size Size of both source and destination arrays
+     */
+    __attribute__((unused)) static void butterworth_lowpass(
+        int filter_order,
+        float sampling_freq,
+        float cutoff_freq,
+        const float *src,
+        float *dest,
+        size_t size)
+    {
+        size_t scratch_size = butterworth_scratch_size(filter_order);
+        float *scratch = (float*)ei_dsp_calloc(scratch_size, sizeof(float));
+        butterworth_lowpass(filter_order, sampling_freq, cutoff_freq, src, dest, size, scratch);
+        ei_dsp_free(scratch, scratch_size * sizeof(float));
     }
 
     /**
@@ -97,6 +128,8 @@ namespace filters {
      * @param src Source array
      * @param dest Destination array
      * @param size Size of both source and destination arrays
+     * @param scratch butterworth_scratch_size() floats, so filtering several
+     *      rows does not allocate per row
      */
     static void butterworth_highpass(
         int filter_order,
@@ -104,17 +137,19 @@ namespace filters {
         float cutoff_freq,
         const float *src,
         float *dest,
-        size_t size)
+        size_t size,
+        float *scratch)
     {
         int n_steps = filter_order / 2;
         float a = tan(M_PI * cutoff_freq / sampling_freq);
         float a2 = pow(a, 2);
-        float *A = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *d2 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w0 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w1 = (float*)ei_calloc(n_steps, sizeof(float));
-        float *w2 = (float*)ei_calloc(n_steps, sizeof(float));
+        memset(scratch, 0, butterworth_scratch_size(filter_order) * sizeof(float));
+        float *A = scratch;
+        float *d1 = A + n_steps;
+        float *d2 = d1 + n_steps;
+        float *w0 = d2 + n_steps;
+        float *w1 = w0 + n_steps;
+        float *w2 = w1 + n_steps;
 
         // Calculate the filter parameters
         for (int ix = 0; ix < n_steps; ix++) {
@@ -136,13 +171,29 @@ namespace filters {
                 w1[i] = w0[i];
             }
         }
+    }
 
-        ei_free(A);
-        ei_free(d1);
-        ei_free(d2);
-        ei_free(w0);
-        ei_free(w1);
-        ei_free(w2);
+    /**
+     * The Butterworth filter has maximally flat frequency response in the passband.
+     * @param filter_order Even filter order (between 2..8)
+     * @param sampling_freq Sample frequency of the signal
+     * @param cutoff_freq Cut-off frequency of the signal
+     * @param src Source array
+     * @param dest Destination array
+     * @param size Size of both source and destination arrays
+     */
+    __attribute__((unused)) static void butterworth_highpass(
+        int filter_order,
+        float sampling_freq,
+        float cutoff_freq,
+        const float *src,
+        float *dest,
+        size_t size)
+    {
+        size_t scratch_size = butterworth_scratch_size(filter_order);
+        float *scratch = (float*)ei_dsp_calloc(scratch_size, sizeof(float));
+        butterworth_highpass(filter_order, sampling_freq, cutoff_freq, src, dest, size, scratch);
+        ei_dsp_free(scratch, scratch_size * sizeof(float));
     }
 
 } // namespace filters
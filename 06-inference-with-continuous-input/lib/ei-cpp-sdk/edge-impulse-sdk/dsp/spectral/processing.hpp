@@ -113,6 +113,9 @@ namespace processing {
         float filter_cutoff,
         uint8_t filter_order)
     {
+        // coefficients and state, reset for every row
+        EI_DSP_MATRIX(filter_scratch, 1, filters::butterworth_scratch_size(filter_order));
+
         for (size_t row = 0; row < matrix->rows; row++) {
             filters::butterworth_lowpass(
                 filter_order,
@@ -120,7 +123,8 @@ namespace processing {
                 filter_cutoff,
                 matrix->buffer + (row * matrix->cols),
                 matrix->buffer + (row * matrix->cols),
-                matrix->cols);
+                matrix->cols,
+                filter_scratch.buffer);
         }
 
         return EIDSP_OK;
@@ -142,6 +146,9 @@ namespace processing {
         float filter_cutoff,
         uint8_t filter_order)
     {
+        // coefficients and state, reset for every row
+        EI_DSP_MATRIX(filter_scratch, 1, filters::butterworth_scratch_size(filter_order));
+
         for (size_t row = 0; row < matrix->rows; row++) {
             filters::butterworth_highpass(
                 filter_order,
@@ -149,7 +156,8 @@ namespace processing {
                 filter_cutoff,
                 matrix->buffer + (row * matrix->cols),
                 matrix->buffer + (row * matrix->cols),
-                matrix->cols);
+                matrix->cols,
+                filter_scratch.buffer);
         }
 
         return EIDSP_OK;
@@ -222,19 +230,41 @@ namespace processing {
     }
 
     /**
-     * Find peaks in FFT
+     * Frequency of every FFT bin, as find_fft_peaks() reports them
+     * @param freq_space Output matrix (1xM), M is the number of FFT bins
+     * @param sampling_freq How often we sample (in Hz)
+     * @param fft_length Length of the FFT
+     * @returns 0 if OK
+     */
+    static int fft_peaks_freq_space(
+        matrix_t *freq_space,
+        float sampling_freq,
+        uint16_t fft_length)
+    {
+        int N = static_cast<int>(fft_length);
+        float T = 1.0f / sampling_freq;
+
+        return numpy::linspace(0.0f, 1.0f / (2.0f * T), floor(N / 2), freq_space->buffer);
+    }
+
+    /**
+     * Find peaks in FFT, with the buffers passed in so that calling this for
+     * several axes does not allocate per axis
      * @param fft_matrix Matrix of FFT numbers (1xN)
      * @param output_matrix Matrix for the output (Mx2), one row per output you want and two colums per row
-     * @param sampling_freq How often we sample (in Hz)
      * @param threshold Minimum threshold (default: 0.1)
+     * @param freq_space Bin frequencies (1xN, see fft_peaks_freq_space())
+     * @param peak_indexes Scratch matrix of (M*10)x1
+     * @param peaks Scratch vector, keeps its capacity between calls
      * @returns
      */
     static int find_fft_peaks(
         matrix_t *fft_matrix,
         matrix_t *output_matrix,
-        float sampling_freq,
         float threshold,
-        uint16_t fft_length)
+        matrix_t *freq_space,
+        matrix_t *peak_indexes,
+        std::vector<freq_peak_t> *peaks)
     {
         if (fft_matrix->rows != 1) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -248,79 +278,114 @@ namespace processing {
             return EIDSP_OK;
         }
 
-        int ret;
-
-        int N = static_cast<int>(fft_length);
-        float T = 1.0f / sampling_freq;
-
-        EI_DSP_MATRIX(freq_space, 1, fft_matrix->cols);
-        ret = numpy::linspace(0.0f, 1.0f / (2.0f * T), floor(N / 2), freq_space.buffer);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
+        if (freq_space->cols != fft_matrix->cols || peak_indexes->rows != output_matrix->rows * 10) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        EI_DSP_MATRIX(peaks_matrix, output_matrix->rows * 10, 1);
-
         uint16_t peak_count;
-        ret = find_peak_indexes(fft_matrix, &peaks_matrix, 0.0f, &peak_count);
+        int ret = find_peak_indexes(fft_matrix, peak_indexes, 0.0f, &peak_count);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
 
-        // turn this into C++ vector and sort it based on amplitude
-        std::vector<freq_peak_t> peaks;
+        // sort the peaks based on amplitude
+        peaks->clear();
         for (uint8_t ix = 0; ix < peak_count; ix++) {
             freq_peak_t d;
 
-            d.freq = freq_space.buffer[static_cast<uint32_t>(peaks_matrix.buffer[ix])];
-            d.amplitude = fft_matrix->buffer[static_cast<uint32_t>(peaks_matrix.buffer[ix])];
-            // printf("freq %f : %f amp: %f\r\n", peaks_matrix.buffer[ix], d.freq, d.amplitude);
+            d.freq = freq_space->buffer[static_cast<uint32_t>(peak_indexes->buffer[ix])];
+            d.amplitude = fft_matrix->buffer[static_cast<uint32_t>(peak_indexes->buffer[ix])];
+            // printf("freq %f : %f amp: %f\r\n", peak_indexes->buffer[ix], d.freq, d.amplitude);
             if (d.amplitude < threshold) {
                 d.freq = 0.0f;
                 d.amplitude = 0.0f;
             }
-            peaks.push_back(d);
+            peaks->push_back(d);
         }
-        sort(peaks.begin(), peaks.end(),
+        sort(peaks->begin(), peaks->end(),
             [](const freq_peak_t & a, const freq_peak_t & b) -> bool
         {
             return a.amplitude > b.amplitude;
         });
 
         // fill with zeros at the end (if needed)
-        for (size_t ix = peaks.size(); ix < output_matrix->rows; ix++) {
+        for (size_t ix = peaks->size(); ix < output_matrix->rows; ix++) {
             freq_peak_t d;
             d.freq = 0;
             d.amplitude = 0;
-            peaks.push_back(d);
+            peaks->push_back(d);
         }
 
         for (size_t row = 0; row < output_matrix->rows; row++) {
             // col 0 is freq, col 1 is ampl
-            output_matrix->buffer[row * output_matrix->cols + 0] = peaks[row].freq;
-            output_matrix->buffer[row * output_matrix->cols + 1] = peaks[row].amplitude;
+            output_matrix->buffer[row * output_matrix->cols + 0] = (*peaks)[row].freq;
+            output_matrix->buffer[row * output_matrix->cols + 1] = (*peaks)[row].amplitude;
         }
 
         return EIDSP_OK;
     }
 
+    /**
+     * Find peaks in FFT
+     * @param fft_matrix Matrix of FFT numbers (1xN)
+     * @param output_matrix Matrix for the output (Mx2), one row per output you want and two colums per row
+     * @param sampling_freq How often we sample (in Hz)
+     * @param threshold Minimum threshold (default: 0.1)
+     * @returns
+     */
+    __attribute__((unused)) static int find_fft_peaks(
+        matrix_t *fft_matrix,
+        matrix_t *output_matrix,
+        float sampling_freq,
+        float threshold,
+        uint16_t fft_length)
+    {
+        if (fft_matrix->rows != 1) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (output_matrix->cols != 2) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        if (output_matrix->rows == 0) {
+            return EIDSP_OK;
+        }
+
+        EI_DSP_MATRIX(freq_space, 1, fft_matrix->cols);
+        int ret = fft_peaks_freq_space(&freq_space, sampling_freq, fft_length);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        EI_DSP_MATRIX(peak_indexes, output_matrix->rows * 10, 1);
+        std::vector<freq_peak_t> peaks;
+
+        return find_fft_peaks(fft_matrix, output_matrix, threshold, &freq_space, &peak_indexes, &peaks);
+    }
+
 
     /**
-     * Calculate spectral power edges in a singal
+     * Calculate spectral power edges in a singal, with the buffers passed in
+     * so that calling this for several axes does not allocate per axis
      * @param fft_matrix FFT matrix (1xM)
      * @param input_matrix_cols Number of columns in the input matrix
      * @param edges_matrix The power edges (Nx1) where N=is number of edges
      *      (e.g. [0.1, 0.5, 1.0, 2.0, 5.0])
      * @param output_matrix Output matrix of size (N-1 x 1)
      * @param sampling_freq Sampling frequency
+     * @param buckets Scratch matrix of N-1 values
+     * @param bucket_count Scratch matrix of N-1 values
      * @returns 0 if OK
      */
-    int spectral_power_edges(
+    static int spectral_power_edges(
         matrix_t *fft_matrix,
         matrix_t *freq_matrix,
         matrix_t *edges_matrix,
         matrix_t *output_matrix,
-        float sampling_freq
+        float sampling_freq,
+        matrix_t *buckets,
+        matrix_t *bucket_count
     ) {
         if (fft_matrix->rows != 1 || freq_matrix->rows != 1) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -338,8 +403,13 @@ namespace processing {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        EI_DSP_MATRIX(buckets, 1, edges_matrix->rows - 1);
-        EI_DSP_MATRIX(bucket_count, 1, edges_matrix->rows - 1);
+        if (buckets->rows * buckets->cols != edges_matrix->rows - 1 ||
+                bucket_count->rows * bucket_count->cols != edges_matrix->rows - 1) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+
+        memset(buckets->buffer, 0, (edges_matrix->rows - 1) * sizeof(float));
+        memset(bucket_count->buffer, 0, (edges_matrix->rows - 1) * sizeof(float));
 
         for (uint16_t ix = 0; ix < freq_matrix->cols; ix++) {
             float t = freq_matrix->buffer[ix];
@@ -348,8 +418,8 @@ namespace processing {
             // does this fit between any edges?
             for (uint16_t ex = 0; ex < edges_matrix->rows - 1; ex++) {
                 if (t >= edges_matrix->buffer[ex] && t < edges_matrix->buffer[ex + 1]) {
-                    buckets.buffer[ex] += v;
-                    bucket_count.buffer[ex]++;
+                    buckets->buffer[ex] += v;
+                    bucket_count->buffer[ex]++;
                     break;
                 }
             }
@@ -357,17 +427,41 @@ namespace processing {
 
         // average out and push to vector
         for (uint16_t ex = 0; ex < edges_matrix->rows - 1; ex++) {
-            if (bucket_count.buffer[ex] == 0.0f) {
+            if (bucket_count->buffer[ex] == 0.0f) {
                 output_matrix->buffer[ex] = 0.0f;
             }
             else {
-                output_matrix->buffer[ex] = buckets.buffer[ex] / bucket_count.buffer[ex];
+                output_matrix->buffer[ex] = buckets->buffer[ex] / bucket_count->buffer[ex];
             }
         }
 
         return EIDSP_OK;
     }
 
+    /**
+     * Calculate spectral power edges in a singal
+     * @param fft_matrix FFT matrix (1xM)
+     * @param input_matrix_cols Number of columns in the input matrix
+     * @param edges_matrix The power edges (Nx1) where N=is number of edges
+     *      (e.g. [0.1, 0.5, 1.0, 2.0, 5.0])
+     * @param output_matrix Output matrix of size (N-1 x 1)
+     * @param sampling_freq Sampling frequency
+     * @returns 0 if OK
+     */
+    int spectral_power_edges(
+        matrix_t *fft_matrix,
+        matrix_t *freq_matrix,
+        matrix_t *edges_matrix,
+        matrix_t *output_matrix,
+        float sampling_freq
+    ) {
+        EI_DSP_MATRIX(buckets, 1, edges_matrix->rows - 1);
+        EI_DSP_MATRIX(bucket_count, 1, edges_matrix->rows - 1);
+
+        return spectral_power_edges(fft_matrix, freq_matrix, edges_matrix, output_matrix, sampling_freq,
+            &buckets, &bucket_count);
+    }
+
 
     /**
      * Estimate power spectral density using a periodogram using Welch's method.
@@ -376,9 +470,12 @@ namespace processing {
      * @param out_freq_matrix Output matrix of size 1x(n_fft/2+1) with frequency data
      * @param sampling_freq The sampling frequency
      * @param n_fft Number of FFT buckets
+     * @param fft_output Scratch of n_fft/2+1 complex values, so that calling
+     *      this for several axes does not allocate per axis
      * @returns 0 if OK
      */
-    int periodogram(matrix_t *input_matrix, matrix_t *out_fft_matrix, matrix_t *out_freq_matrix, float sampling_freq, uint16_t n_fft)
+    static int periodogram(matrix_t *input_matrix, matrix_t *out_fft_matrix, matrix_t *out_freq_matrix, float sampling_freq, uint16_t n_fft,
+        fft_complex_t *fft_output)
     {
         if (input_matrix->rows != 1) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
@@ -417,11 +514,6 @@ namespace processing {
             welch_matrix.cols = n_fft;
         }
 
-        EI_DSP_MATRIX(triage_segments, 1, nperseg);
-        for (uint16_t ix = 0; ix < nperseg; ix++) {
-            triage_segments.buffer[ix] = 1.0f;
-        }
-
         float scale = 1.0f / (sampling_freq * nperseg);
 
         for (uint16_t ix = 0; ix < n_fft / 2 + 1; ix++) {
@@ -431,7 +523,8 @@ namespace processing {
         int ret;
 
         // now we need to detrend... which is done constant so just subtract the mean
-        EI_DSP_MATRIX(mean_matrix, 1, 1);
+        float mean;
+        EI_DSP_MATRIX_B(mean_matrix, 1, 1, &mean);
         ret = numpy::mean(&welch_matrix, &mean_matrix);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
@@ -442,10 +535,8 @@ namespace processing {
             EIDSP_ERR(ret);
         }
 
-        fft_complex_t *fft_output = (fft_complex_t*)ei_dsp_calloc((n_fft / 2 + 1) * sizeof(fft_complex_t), 1);
         ret = numpy::rfft(welch_matrix.buffer, welch_matrix.cols, fft_output, n_fft / 2 + 1, n_fft);
         if (ret != EIDSP_OK) {
-            ei_dsp_free(fft_output, (n_fft / 2 + 1) * sizeof(fft_complex_t));
             EIDSP_ERR(ret);
         }
 
@@ -465,10 +556,29 @@ namespace processing {
             out_fft_matrix->buffer[ix] = fft_output[ix].r;
         }
 
-        ei_dsp_free(fft_output, (n_fft / 2 + 1) * sizeof(fft_complex_t));
-
         return EIDSP_OK;
     }
+
+    /**
+     * Estimate power spectral density using a periodogram using Welch's method.
+     * @param input_matrix Of size 1xN
+     * @param out_fft_matrix Output matrix of size 1x(n_fft/2+1) with frequency data
+     * @param out_freq_matrix Output matrix of size 1x(n_fft/2+1) with frequency data
+     * @param sampling_freq The sampling frequency
+     * @param n_fft Number of FFT buckets
+     * @returns 0 if OK
+     */
+    int periodogram(matrix_t *input_matrix, matrix_t *out_fft_matrix, matrix_t *out_freq_matrix, float sampling_freq, uint16_t n_fft)
+    {
+        fft_complex_t *fft_output = (fft_complex_t*)ei_dsp_calloc((n_fft / 2 + 1) * sizeof(fft_complex_t), 1);
+        if (!fft_output) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        int ret = periodogram(input_matrix, out_fft_matrix, out_freq_matrix, sampling_freq, n_fft, fft_output);
+        ei_dsp_free(fft_output, (n_fft / 2 + 1) * sizeof(fft_complex_t));
+        return ret;
+    }
 } // namespace processing
 } // namespace spectral
 } // namespace ei
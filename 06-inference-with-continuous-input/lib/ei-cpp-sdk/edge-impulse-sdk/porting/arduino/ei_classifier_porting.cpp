@@ -46,6 +46,10 @@ uint64_t ei_read_timer_us() {
     return micros();
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 void ei_serial_set_baudrate(int baudrate)
 {
 
@@ -73,6 +73,12 @@ uint64_t ei_read_timer_ms();
  */
 uint64_t ei_read_timer_us();
 
+/**
+ * Read the nanosecond timer (monotonic, targets without a finer clock return
+ * the microsecond timer in nanoseconds)
+ */
+uint64_t ei_read_timer_ns();
+
 /**
  * Set Serial baudrate
  */
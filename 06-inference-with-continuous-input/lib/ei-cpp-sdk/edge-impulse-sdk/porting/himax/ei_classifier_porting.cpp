@@ -90,6 +90,11 @@ uint64_t ei_read_timer_us()
     return ei_read_timer_ms() * 1000;
 }
 
+uint64_t ei_read_timer_ns()
+{
+    return ei_read_timer_us() * 1000;
+}
+
 void ei_serial_set_baudrate(int baudrate)
 {
     hx_drv_uart_initial((HX_DRV_UART_BAUDRATE_E)baudrate);
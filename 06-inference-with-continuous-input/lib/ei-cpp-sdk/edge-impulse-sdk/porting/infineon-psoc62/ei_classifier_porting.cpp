@@ -77,6 +77,10 @@ uint64_t ei_read_timer_us() {
     return ei_read_timer_ms() * 1000;
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 void ei_putchar(char c)
 {
     putchar(c);
@@ -43,38 +43,28 @@ __attribute__((weak)) EI_IMPULSE_ERROR ei_sleep(int32_t time_ms) {
     return EI_IMPULSE_OK;
 }
 
-uint64_t ei_read_timer_ms() {
-    uint64_t ms; // Milliseconds
-    uint64_t s;  // Seconds
+// Timers read CLOCK_MONOTONIC_RAW, which (unlike CLOCK_REALTIME) never jumps
+// when NTP or the user sets the time
+#ifdef CLOCK_MONOTONIC_RAW
+#define EI_POSIX_TIMER_CLOCK    CLOCK_MONOTONIC_RAW
+#else
+#define EI_POSIX_TIMER_CLOCK    CLOCK_MONOTONIC
+#endif
+
+uint64_t ei_read_timer_ns() {
     struct timespec spec;
 
-    clock_gettime(CLOCK_REALTIME, &spec);
+    clock_gettime(EI_POSIX_TIMER_CLOCK, &spec);
 
-    s  = spec.tv_sec;
-    ms = round(spec.tv_nsec / 1.0e6); // Convert nanoseconds to milliseconds
-    if (ms > 999) {
-        s++;
-        ms = 0;
-    }
+    return ((uint64_t)spec.tv_sec * 1000000000ULL) + (uint64_t)spec.tv_nsec;
+}
 
-    return (s * 1000) + ms;
+uint64_t ei_read_timer_ms() {
+    return ei_read_timer_ns() / 1000000;
 }
 
 uint64_t ei_read_timer_us() {
-    uint64_t us; // Milliseconds
-    uint64_t s;  // Seconds
-    struct timespec spec;
-
-    clock_gettime(CLOCK_REALTIME, &spec);
-
-    s  = spec.tv_sec;
-    us = round(spec.tv_nsec / 1.0e3); // Convert nanoseconds to nanoseconds
-    if (us > 999999) {
-        s++;
-        us = 0;
-    }
-
-    return (s * 1000000) + us;
+    return ei_read_timer_ns() / 1000;
 }
 
 __attribute__((weak)) void ei_printf(const char *format, ...) {
@@ -52,6 +52,10 @@ uint64_t ei_read_timer_us() {
     return to_us_since_boot(get_absolute_time());
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 void ei_putchar(char c)
 {
     /* Send char to serial output */
@@ -63,6 +63,10 @@ uint64_t ei_read_timer_us() {
     return 0;
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 __attribute__((weak)) void ei_printf(const char *format, ...) {
 
     char buffer[256] = {0};
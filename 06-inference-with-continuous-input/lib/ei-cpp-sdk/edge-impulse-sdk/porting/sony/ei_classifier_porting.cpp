@@ -67,6 +67,10 @@ uint64_t ei_read_timer_us() {
     return time_us;
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 __attribute__((weak)) void ei_printf(const char *format, ...) {
 
     va_list myargs;
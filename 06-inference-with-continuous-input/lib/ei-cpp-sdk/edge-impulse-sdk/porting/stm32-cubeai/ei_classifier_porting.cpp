@@ -47,6 +47,10 @@ uint64_t ei_read_timer_us() {
     return HAL_GetTick() * 1000;
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 __attribute__((weak)) void ei_printf(const char *format, ...) {
     va_list myargs;
     va_start(myargs, format);
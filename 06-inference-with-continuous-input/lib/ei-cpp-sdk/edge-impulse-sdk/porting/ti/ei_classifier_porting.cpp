@@ -58,6 +58,10 @@ uint64_t ei_read_timer_us() {
     return Timer_getMs() * 1000;
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 __attribute__((weak)) void ei_printf(const char *format, ...) {
 
     char buffer[256];
@@ -46,6 +46,10 @@ uint64_t ei_read_timer_us() {
     return k_uptime_get() * 1000;
 }
 
+uint64_t ei_read_timer_ns() {
+    return ei_read_timer_us() * 1000;
+}
+
 /**
  *  Printf function uses vsnprintf and output using Arduino Serial
  */
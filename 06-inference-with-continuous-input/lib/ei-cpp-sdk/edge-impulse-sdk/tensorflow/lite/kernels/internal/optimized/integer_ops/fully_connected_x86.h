@@ -0,0 +1,264 @@
+/* Copyright 2022 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_X86_H_
+#define TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_X86_H_
+
+// int8 fully connected kernels for x86 hosts (AVX2 and AVX-512 VNNI).
+//
+// Only the dot products are vectorized. The int32 accumulators are exactly
+// the ones the reference kernel computes, and requantization uses the same
+// scalar MultiplyByQuantizedMultiplier(), so the output is bit-exact with
+// reference_integer_ops::FullyConnected().
+//
+// The code is compiled with per-function target attributes and picked at
+// runtime based on CPUID, so the rest of the build does not need -mavx2.
+
+#include <immintrin.h>
+
+#include "edge-impulse-sdk/tensorflow/lite/kernels/internal/common.h"
+
+namespace tflite {
+namespace optimized_integer_ops {
+
+enum class X86SimdLevel { kNone, kAvx2, kAvx512Vnni };
+
+// Output channels that share one pass over the input
+constexpr int kFullyConnectedX86Rows = 4;
+
+inline X86SimdLevel DetectX86SimdLevel() {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512vnni") &&
+      __builtin_cpu_supports("avx512bw")) {
+    return X86SimdLevel::kAvx512Vnni;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return X86SimdLevel::kAvx2;
+  }
+  return X86SimdLevel::kNone;
+}
+
+inline X86SimdLevel GetX86SimdLevel() {
+  static const X86SimdLevel level = DetectX86SimdLevel();
+  return level;
+}
+
+// Bias, requantization and activation, identical to the reference kernel
+inline int8_t FullyConnectedX86Output(const FullyConnectedParams& params,
+                                      int32_t acc, const int32_t* bias_data,
+                                      int out_c) {
+  if (bias_data) {
+    acc += bias_data[out_c];
+  }
+  acc = MultiplyByQuantizedMultiplier(acc, params.output_multiplier,
+                                      params.output_shift);
+  acc += params.output_offset;
+  acc = std::max(acc, params.quantized_activation_min);
+  acc = std::min(acc, params.quantized_activation_max);
+  return static_cast<int8_t>(acc);
+}
+
+__attribute__((target("avx2"))) inline int32_t HorizontalSumAvx2(__m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+
+// Adds the two 256-bit halves and reuses the AVX2 sum. The halves come out
+// of zero-masked extracts: _mm512_reduce_add_epi32, _mm512_castsi512_si256
+// and the unmasked extract start from an undefined vector in the GCC
+// headers, which raises -Wmaybe-uninitialized.
+__attribute__((target("avx512f"))) inline int32_t HorizontalSumAvx512(
+    __m512i v) {
+  return HorizontalSumAvx2(
+      _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xff, v, 0),
+                       _mm512_maskz_extracti64x4_epi64(0xff, v, 1)));
+}
+
+// Sign-extends 16 int8 values to int16 and adds the zero point offset. With
+// both offsets folded in, (filter + offset) * (input + offset) fits int16
+// operands and vpmaddwd accumulates pairs of them in int32 without
+// saturating (unlike pmaddubsw, which saturates to int16).
+__attribute__((target("avx2"))) inline __m256i LoadWidenAvx2(
+    const int8_t* ptr, __m256i offset) {
+  return _mm256_add_epi16(
+      _mm256_cvtepi8_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr))),
+      offset);
+}
+
+__attribute__((target("avx2"))) inline void FullyConnectedAvx2(
+    const FullyConnectedParams& params, const int8_t* input_data,
+    const int8_t* filter_data, const int32_t* bias_data, int8_t* output_data,
+    int batches, int output_depth, int accum_depth) {
+  const int32_t input_offset = params.input_offset;
+  const int32_t filter_offset = params.weights_offset;
+  const __m256i input_offset_vec = _mm256_set1_epi16(input_offset);
+  const __m256i filter_offset_vec = _mm256_set1_epi16(filter_offset);
+
+  // Output channels outside, batches inside: a group of filter rows is
+  // streamed from memory once and reused (from L1) for every batch.
+  for (int out_c = 0; out_c < output_depth; out_c += kFullyConnectedX86Rows) {
+    const int rows = std::min(kFullyConnectedX86Rows, output_depth - out_c);
+    const int8_t* filter[kFullyConnectedX86Rows];
+    for (int r = 0; r < kFullyConnectedX86Rows; ++r) {
+      // Surplus rows of the last group repeat the final row, results unused
+      filter[r] = filter_data + (out_c + std::min(r, rows - 1)) * accum_depth;
+    }
+
+    for (int b = 0; b < batches; ++b) {
+      const int8_t* input = input_data + b * accum_depth;
+      __m256i sum[kFullyConnectedX86Rows];
+      for (int r = 0; r < kFullyConnectedX86Rows; ++r) {
+        sum[r] = _mm256_setzero_si256();
+      }
+
+      int d = 0;
+      for (; d + 16 <= accum_depth; d += 16) {
+        const __m256i x = LoadWidenAvx2(input + d, input_offset_vec);
+        for (int r = 0; r < kFullyConnectedX86Rows; ++r) {
+          const __m256i w = LoadWidenAvx2(filter[r] + d, filter_offset_vec);
+          sum[r] = _mm256_add_epi32(sum[r], _mm256_madd_epi16(w, x));
+        }
+      }
+
+      for (int r = 0; r < rows; ++r) {
+        int32_t acc = HorizontalSumAvx2(sum[r]);
+        for (int t = d; t < accum_depth; ++t) {
+          acc += (filter[r][t] + filter_offset) * (input[t] + input_offset);
+        }
+        output_data[out_c + r + output_depth * b] =
+            FullyConnectedX86Output(params, acc, bias_data, out_c + r);
+      }
+    }
+  }
+}
+
+// vpdpbusd multiplies unsigned by signed bytes. The input is shifted into
+// uint8 (x + 128) and the surplus 128 * sum(filter) is removed afterwards;
+// the filter row sums come out of the same loop with a second vpdpbusd.
+// Then acc = sum(x * f) + input_offset * sum(f) + filter_offset * sum(x)
+//          + depth * input_offset * filter_offset, as in the reference.
+__attribute__((target("avx512f,avx512bw,avx512vnni"))) inline void
+FullyConnectedAvx512Vnni(const FullyConnectedParams& params,
+                         const int8_t* input_data, const int8_t* filter_data,
+                         const int32_t* bias_data, int8_t* output_data,
+                         int batches, int output_depth, int accum_depth) {
+  const int32_t input_offset = params.input_offset;
+  const int32_t filter_offset = params.weights_offset;
+  const __m512i sign_flip = _mm512_set1_epi8(static_cast<char>(0x80));
+  const __m512i ones_u8 = _mm512_set1_epi8(1);
+  const int tail = accum_depth % 64;
+  const __mmask64 tail_mask =
+      tail ? (static_cast<__mmask64>(1) << tail) - 1 : 0;
+  const int full_depth = accum_depth - tail;
+
+  for (int out_c = 0; out_c < output_depth; out_c += kFullyConnectedX86Rows) {
+    const int rows = std::min(kFullyConnectedX86Rows, output_depth - out_c);
+    const int8_t* filter[kFullyConnectedX86Rows];
+    for (int r = 0; r < kFullyConnectedX86Rows; ++r) {
+      filter[r] = filter_data + (out_c + std::min(r, rows - 1)) * accum_depth;
+    }
+
+    for (int b = 0; b < batches; ++b) {
+      const int8_t* input = input_data + b * accum_depth;
+      __m512i dot[kFullyConnectedX86Rows];
+      __m512i filter_sum[kFullyConnectedX86Rows];
+      __m512i input_sum = _mm512_setzero_si512();
+      for (int r = 0; r < kFullyConnectedX86Rows; ++r) {
+        dot[r] = _mm512_setzero_si512();
+        filter_sum[r] = _mm512_setzero_si512();
+      }
+
+      for (int d = 0; d <= full_depth; d += 64) {
+        __m512i x;
+        __m512i w[kFullyConnectedX86Rows];
+        if (d < full_depth) {
+          x = _mm512_loadu_si512(input + d);
+          for (int r = 0; r < kFullyConnectedX86Rows; ++r) {
+            w[r] = _mm512_loadu_si512(filter[r] + d);
+          }
+        } else if (tail) {
+          // Masked-off lanes load as 0; their filter bytes are 0 as well so
+          // they add nothing to the products or the filter sums
+          x = _mm512_maskz_loadu_epi8(tail_mask, input + d);
+          for (int r = 0; r < kFullyConnectedX86Rows; ++r) {
+            w[r] = _mm512_maskz_loadu_epi8(tail_mask, filter[r] + d);
+          }
+        } else {
+          break;
+        }
+        const __m512i x_u8 = _mm512_xor_si512(x, sign_flip);
+        input_sum = _mm512_dpbusd_epi32(input_sum, ones_u8, x);
+        for (int r = 0; r < kFullyConnectedX86Rows; ++r) {
+          dot[r] = _mm512_dpbusd_epi32(dot[r], x_u8, w[r]);
+          filter_sum[r] = _mm512_dpbusd_epi32(filter_sum[r], ones_u8, w[r]);
+        }
+      }
+
+      const int32_t sum_x = HorizontalSumAvx512(input_sum);
+      for (int r = 0; r < rows; ++r) {
+        const int32_t sum_f = HorizontalSumAvx512(filter_sum[r]);
+        const int32_t sum_xf = HorizontalSumAvx512(dot[r]) - 128 * sum_f;
+        const int32_t acc = sum_xf + input_offset * sum_f +
+                            filter_offset * sum_x +
+                            accum_depth * input_offset * filter_offset;
+        output_data[out_c + r + output_depth * b] =
+            FullyConnectedX86Output(params, acc, bias_data, out_c + r);
+      }
+    }
+  }
+}
+
+// Same arguments as reference_integer_ops::FullyConnected(). Returns false
+// if the CPU has neither AVX2 nor AVX-512 VNNI, in which case nothing was
+// written and the caller should run the reference kernel.
+inline bool FullyConnectedX86(
+    const FullyConnectedParams& params, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data) {
+  TFLITE_DCHECK_GE(filter_shape.DimensionsCount(), 2);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 2);
+  TFLITE_DCHECK_LE(params.quantized_activation_min,
+                   params.quantized_activation_max);
+
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int batches = output_shape.Dims(0);
+  const int output_depth = output_shape.Dims(1);
+  TFLITE_DCHECK_LE(output_depth, filter_shape.Dims(filter_dim_count - 2));
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+
+  switch (GetX86SimdLevel()) {
+    case X86SimdLevel::kAvx512Vnni:
+      FullyConnectedAvx512Vnni(params, input_data, filter_data, bias_data,
+                               output_data, batches, output_depth,
+                               accum_depth);
+      return true;
+    case X86SimdLevel::kAvx2:
+      FullyConnectedAvx2(params, input_data, filter_data, bias_data,
+                         output_data, batches, output_depth, accum_depth);
+      return true;
+    default:
+      return false;
+  }
+}
+
+}  // namespace optimized_integer_ops
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_INTERNAL_OPTIMIZED_INTEGER_OPS_FULLY_CONNECTED_X86_H_
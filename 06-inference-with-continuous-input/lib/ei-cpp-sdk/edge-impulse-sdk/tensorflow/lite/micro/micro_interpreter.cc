@@ -42,6 +42,27 @@ const char* OpNameFromRegistration(const TfLiteRegistration* registration) {
 }
 #endif  // !defined(TF_LITE_STRIP_ERROR_STRINGS)
 
+#if defined(EI_CLASSIFIER_PROFILE_NODES) && EI_CLASSIFIER_PROFILE_NODES
+// Size of the input (incl. weights) and output tensors of a node, reported to
+// the profiler with the node's event
+size_t NodeTensorBytes(const TfLiteNode* node,
+                       const TfLiteEvalTensor* eval_tensors) {
+  size_t bytes = 0;
+  const TfLiteIntArray* arrays[] = {node->inputs, node->outputs};
+  for (const TfLiteIntArray* array : arrays) {
+    for (int i = 0; i < array->size; ++i) {
+      size_t tensor_bytes;
+      if (array->data[i] >= 0 &&
+          TfLiteEvalTensorByteLength(&eval_tensors[array->data[i]],
+                                     &tensor_bytes) == kTfLiteOk) {
+        bytes += tensor_bytes;
+      }
+    }
+  }
+  return bytes;
+}
+#endif  // EI_CLASSIFIER_PROFILE_NODES
+
 }  // namespace
 
 namespace internal {
@@ -333,6 +354,13 @@ TfLiteStatus MicroInterpreter::Invoke() {
     TFLITE_DCHECK(registration->invoke);
     TfLiteStatus invoke_status = registration->invoke(&context_, node);
 
+#if !defined(TF_LITE_STRIP_ERROR_STRINGS) && \
+    defined(EI_CLASSIFIER_PROFILE_NODES) && EI_CLASSIFIER_PROFILE_NODES
+    if (context_.profiler != nullptr) {
+      scoped_profiler.SetBytes(NodeTensorBytes(node, eval_tensors_));
+    }
+#endif
+
     // All TfLiteTensor structs used in the kernel are allocated from temp
     // memory in the allocator. This creates a chain of allocations in the
     // temp section. The call below resets the chain of allocations to
@@ -16,6 +16,7 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MICRO_MICRO_PROFILER_H_
 #define TENSORFLOW_LITE_MICRO_MICRO_PROFILER_H_
 
+#include <cstddef>
 #include <cstdint>
 
 #include "edge-impulse-sdk/tensorflow/lite/micro/compatibility.h"
@@ -45,6 +46,11 @@ class MicroProfiler {
   // for a particular event_handle, the duration of that event will be 0 ticks.
   virtual void EndEvent(uint32_t event_handle);
 
+  // Reports the size of the tensors read and written by the operator of the
+  // event. Only called by the interpreter for Edge Impulse node profiles
+  // (EI_CLASSIFIER_PROFILE_NODES), ignored by default.
+  virtual void SetEventBytes(uint32_t /*event_handle*/, size_t /*bytes*/) {}
+
   // Clears all the events that have been currently profiled.
   void ClearEvents() { num_events_ = 0; }
 
@@ -70,14 +76,17 @@ class MicroProfiler {
   TF_LITE_REMOVE_VIRTUAL_DELETE;
 };
 
-#if defined(NDEBUG)
-// For release builds, the ScopedMicroProfiler is a noop.
+#if defined(NDEBUG) && \
+    !(defined(EI_CLASSIFIER_PROFILE_NODES) && EI_CLASSIFIER_PROFILE_NODES)
+// For release builds, the ScopedMicroProfiler is a noop (unless Edge Impulse
+// node profiles are enabled).
 //
 // This is done because the ScipedProfiler is used as part of the
 // MicroInterpreter and we want to ensure zero overhead for the release builds.
 class ScopedMicroProfiler {
  public:
   explicit ScopedMicroProfiler(const char* tag, MicroProfiler* profiler) {}
+  void SetBytes(size_t /*bytes*/) {}
 };
 
 #else
@@ -107,6 +116,12 @@ class ScopedMicroProfiler {
     }
   }
 
+  void SetBytes(size_t bytes) {
+    if (profiler_ != nullptr) {
+      profiler_->SetEventBytes(event_handle_, bytes);
+    }
+  }
+
  private:
   uint32_t event_handle_ = 0;
   MicroProfiler* profiler_ = nullptr;
@@ -22,11 +22,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <new>
 #include <vector>
 #include "edge-impulse-sdk/tensorflow/lite/c/builtin_op_data.h"
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
 #include "edge-impulse-sdk/tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+#include "tflite-model/trained_model_compiled.h"
+#include "edge-impulse-sdk/classifier/ei_model_profile.h"
+#if EI_CLASSIFIER_PROFILE_NODES
+#include "edge-impulse-sdk/tensorflow/lite/micro/memory_helpers.h"
+#endif
 
 #if EI_CLASSIFIER_PRINT_STATE
 #if defined(__cplusplus) && EI_C_LINKAGE == 1
@@ -67,15 +73,18 @@ uint8_t tensor_arena[kTensorArenaSize] ALIGN(16) __attribute__((section(".tensor
 uint8_t* tensor_arena = NULL;
 #endif
 
-static uint8_t* tensor_boundary;
-static uint8_t* current_location;
-
 template <int SZ, class T> struct TfArray {
   int sz; T elem[SZ];
 };
 enum used_operators_e {
   OP_FULLY_CONNECTED, OP_SOFTMAX,  OP_LAST
 };
+#if EI_CLASSIFIER_PROFILE_NODES
+// Operator names as in the TFLite schema, for node profiles
+const char* const used_operator_names[OP_LAST] = {
+  "FULLY_CONNECTED", "SOFTMAX",
+};
+#endif
 struct TensorInfo_t { // subset of TfLiteTensor used for initialization from constant memory
   TfLiteAllocationType allocation_type;
   TfLiteType type;
@@ -91,11 +100,7 @@ struct NodeInfo_t { // subset of TfLiteNode used for initialization from constan
   used_operators_e used_op_index;
 };
 
-TfLiteContext ctx{};
-TfLiteTensor tflTensors[11];
-TfLiteEvalTensor tflEvalTensors[11];
 TfLiteRegistration registrations[OP_LAST];
-TfLiteNode tflNodes[4];
 
 const TfArray<2, int> tensor_dimension0 = { 2, { 1,600 } };
 const TfArray<1, float> quant0_scale = { 1, { 0.081111200153827667, } };
@@ -304,11 +309,49 @@ const TensorInfo_t tensorData[] = {
   { (TfLiteIntArray*)&inputs2, (TfLiteIntArray*)&outputs2, const_cast<void*>(static_cast<const void*>(&opdata2)), OP_FULLY_CONNECTED, },
   { (TfLiteIntArray*)&inputs3, (TfLiteIntArray*)&outputs3, const_cast<void*>(static_cast<const void*>(&opdata3)), OP_SOFTMAX, },
 };
-static std::vector<void*> overflow_buffers;
+} // namespace
+
+// Everything that is written to while the model runs. The weights, tensor
+// descriptions and node descriptions above are read-only and shared.
+struct trained_model_instance {
+  typedef struct {
+    size_t bytes;
+    void *ptr;
+  } scratch_buffer_t;
+
+  uint8_t* tensor_arena;
+  size_t arena_size;
+  int batch_size;
+  uint8_t* tensor_boundary;
+  uint8_t* current_location;
+  TfLiteContext ctx;
+  TfLiteTensor tflTensors[11];
+  TfLiteEvalTensor tflEvalTensors[11];
+  TfLiteNode tflNodes[4];
+  // Shapes of the activation tensors with the batch dimension applied
+  int batchDims[11][3];
+  std::vector<void*> overflow_buffers;
+  std::vector<scratch_buffer_t> scratch_buffers;
+#if EI_CLASSIFIER_PROFILE_NODES
+  // Node timings of the last invoke
+  ei_model_profile_t profile;
+#endif
+};
+
+namespace {
+
+// Used by the non-instance API
+trained_model_instance default_instance;
+
+static trained_model_instance* GetInstance(const struct TfLiteContext* ctx) {
+  return static_cast<trained_model_instance*>(ctx->impl_);
+}
+
 static void * AllocatePersistentBuffer(struct TfLiteContext* ctx,
                                        size_t bytes) {
+  trained_model_instance* inst = GetInstance(ctx);
   void *ptr;
-  if (current_location - bytes < tensor_boundary) {
+  if (inst->current_location - bytes < inst->tensor_boundary) {
     // OK, this will look super weird, but.... we have CMSIS-NN buffers which
     // we cannot calculate beforehand easily.
     ptr = ei_calloc(bytes, 1);
@@ -316,26 +359,22 @@ static void * AllocatePersistentBuffer(struct TfLiteContext* ctx,
       printf("ERR: Failed to allocate persistent buffer of size %d\n", (int)bytes);
       return NULL;
     }
-    overflow_buffers.push_back(ptr);
+    inst->overflow_buffers.push_back(ptr);
     return ptr;
   }
 
-  current_location -= bytes;
+  inst->current_location -= bytes;
 
-  ptr = current_location;
+  ptr = inst->current_location;
   memset(ptr, 0, bytes);
 
   return ptr;
 }
-typedef struct {
-  size_t bytes;
-  void *ptr;
-} scratch_buffer_t;
-static std::vector<scratch_buffer_t> scratch_buffers;
 
 static TfLiteStatus RequestScratchBufferInArena(struct TfLiteContext* ctx, size_t bytes,
                                                 int* buffer_idx) {
-  scratch_buffer_t b;
+  trained_model_instance* inst = GetInstance(ctx);
+  trained_model_instance::scratch_buffer_t b;
   b.bytes = bytes;
 
   b.ptr = AllocatePersistentBuffer(ctx, b.bytes);
@@ -343,51 +382,51 @@ static TfLiteStatus RequestScratchBufferInArena(struct TfLiteContext* ctx, size_
     return kTfLiteError;
   }
 
-  scratch_buffers.push_back(b);
+  inst->scratch_buffers.push_back(b);
 
-  *buffer_idx = scratch_buffers.size() - 1;
+  *buffer_idx = inst->scratch_buffers.size() - 1;
 
   return kTfLiteOk;
 }
 
 static void* GetScratchBuffer(struct TfLiteContext* ctx, int buffer_idx) {
-  if (buffer_idx > static_cast<int>(scratch_buffers.size()) - 1) {
+  trained_model_instance* inst = GetInstance(ctx);
+  if (buffer_idx > static_cast<int>(inst->scratch_buffers.size()) - 1) {
     return NULL;
   }
-  return scratch_buffers[buffer_idx].ptr;
+  return inst->scratch_buffers[buffer_idx].ptr;
 }
 
 static TfLiteTensor* GetTensor(const struct TfLiteContext* context,
                                int tensor_idx) {
-  return &tflTensors[tensor_idx];
+  return &GetInstance(context)->tflTensors[tensor_idx];
 }
 
 static TfLiteEvalTensor* GetEvalTensor(const struct TfLiteContext* context,
                                        int tensor_idx) {
-  return &tflEvalTensors[tensor_idx];
+  return &GetInstance(context)->tflEvalTensors[tensor_idx];
 }
 
-} // namespace
+static bool RegisterOps() {
+  registrations[OP_FULLY_CONNECTED] = Register_FULLY_CONNECTED();
+  registrations[OP_SOFTMAX] = Register_SOFTMAX();
+  return true;
+}
 
-TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
-#ifdef EI_CLASSIFIER_ALLOCATION_HEAP
-  tensor_arena = (uint8_t*) alloc_fnc(16, kTensorArenaSize);
-  if (!tensor_arena) {
-    printf("ERR: failed to allocate tensor arena\n");
-    return kTfLiteError;
-  }
-#else
-  memset(tensor_arena, 0, kTensorArenaSize);
-#endif
-  tensor_boundary = tensor_arena;
-  current_location = tensor_arena + kTensorArenaSize;
-  ctx.AllocatePersistentBuffer = &AllocatePersistentBuffer;
-  ctx.RequestScratchBufferInArena = &RequestScratchBufferInArena;
-  ctx.GetScratchBuffer = &GetScratchBuffer;
-  ctx.GetTensor = &GetTensor;
-  ctx.GetEvalTensor = &GetEvalTensor;
-  ctx.tensors = tflTensors;
-  ctx.tensors_size = 11;
+static TfLiteStatus InitInstance(trained_model_instance* inst) {
+  inst->tensor_boundary = inst->tensor_arena;
+  inst->current_location = inst->tensor_arena + inst->arena_size;
+  inst->ctx = TfLiteContext{};
+  inst->ctx.impl_ = inst;
+  inst->ctx.AllocatePersistentBuffer = &AllocatePersistentBuffer;
+  inst->ctx.RequestScratchBufferInArena = &RequestScratchBufferInArena;
+  inst->ctx.GetScratchBuffer = &GetScratchBuffer;
+  inst->ctx.GetTensor = &GetTensor;
+  inst->ctx.GetEvalTensor = &GetEvalTensor;
+  inst->ctx.tensors = inst->tflTensors;
+  inst->ctx.tensors_size = 11;
+  TfLiteTensor* tflTensors = inst->tflTensors;
+  TfLiteEvalTensor* tflEvalTensors = inst->tflEvalTensors;
   for(size_t i = 0; i < 11; ++i) {
     tflTensors[i].type = tensorData[i].type;
     tflEvalTensors[i].type = tensorData[i].type;
@@ -402,9 +441,31 @@ TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
     tflTensors[i].dims = tensorData[i].dims;
     tflEvalTensors[i].dims = tensorData[i].dims;
 
-#if defined(EI_CLASSIFIER_ALLOCATION_HEAP)
     if(tflTensors[i].allocation_type == kTfLiteArenaRw){
-      uint8_t* start = (uint8_t*) ((uintptr_t)tensorData[i].data + (uintptr_t) tensor_arena);
+      // tensorData holds locations relative to tensor_arena (NULL on heap),
+      // relocate them into this instance's arena
+      uintptr_t offset = (uintptr_t)tensorData[i].data - (uintptr_t)tensor_arena;
+
+      // Batched instances stack the rows of every activation tensor. Scaling
+      // all offsets and sizes by the batch size keeps the memory plan valid.
+      if (inst->batch_size > 1) {
+        const TfLiteIntArray* dims = tensorData[i].dims;
+        if (dims->size < 1 || dims->size > 2 || dims->data[0] != 1) {
+          printf("ERR: tensor %d has no batch dimension\n", (int)i);
+          return kTfLiteError;
+        }
+        inst->batchDims[i][0] = dims->size;
+        inst->batchDims[i][1] = inst->batch_size;
+        if (dims->size > 1) {
+          inst->batchDims[i][2] = dims->data[1];
+        }
+        offset *= inst->batch_size;
+        tflTensors[i].bytes *= inst->batch_size;
+        tflTensors[i].dims = (TfLiteIntArray*)inst->batchDims[i];
+        tflEvalTensors[i].dims = (TfLiteIntArray*)inst->batchDims[i];
+      }
+
+      uint8_t* start = inst->tensor_arena + offset;
 
      tflTensors[i].data.data =  start;
      tflEvalTensors[i].data.data =  start;
@@ -413,10 +474,6 @@ TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
        tflTensors[i].data.data = tensorData[i].data;
        tflEvalTensors[i].data.data = tensorData[i].data;
     }
-#else
-    tflTensors[i].data.data = tensorData[i].data;
-    tflEvalTensors[i].data.data = tensorData[i].data;
-#endif // EI_CLASSIFIER_ALLOCATION_HEAP
     tflTensors[i].quantization = tensorData[i].quantization;
     if (tflTensors[i].quantization.type == kTfLiteAffineQuantization) {
       TfLiteAffineQuantization const* quant = ((TfLiteAffineQuantization const*)(tensorData[i].quantization.params));
@@ -424,19 +481,22 @@ TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
       tflTensors[i].params.zero_point = quant->zero_point->data[0];
     }
     if (tflTensors[i].allocation_type == kTfLiteArenaRw) {
-      auto data_end_ptr = (uint8_t*)tflTensors[i].data.data + tensorData[i].bytes;
-      if (data_end_ptr > tensor_boundary) {
-        tensor_boundary = data_end_ptr;
+      auto data_end_ptr = (uint8_t*)tflTensors[i].data.data + tflTensors[i].bytes;
+      if (data_end_ptr > inst->tensor_boundary) {
+        inst->tensor_boundary = data_end_ptr;
       }
     }
   }
-  if (tensor_boundary > current_location /* end of arena size */) {
+  if (inst->tensor_boundary > inst->current_location /* end of arena size */) {
     printf("ERR: tensor arena is too small, does not fit model - even without scratch buffers\n");
     return kTfLiteError;
   }
-  registrations[OP_FULLY_CONNECTED] = Register_FULLY_CONNECTED();
-  registrations[OP_SOFTMAX] = Register_SOFTMAX();
 
+  // Registrations only hold function pointers, fill them in once for all instances
+  static bool ops_registered = RegisterOps();
+  (void)ops_registered;
+
+  TfLiteNode* tflNodes = inst->tflNodes;
   for(size_t i = 0; i < 4; ++i) {
     tflNodes[i].inputs = nodeData[i].inputs;
     tflNodes[i].outputs = nodeData[i].outputs;
@@ -444,12 +504,12 @@ TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
 tflNodes[i].custom_initial_data = nullptr;
       tflNodes[i].custom_initial_data_size = 0;
 if (registrations[nodeData[i].used_op_index].init) {
-      tflNodes[i].user_data = registrations[nodeData[i].used_op_index].init(&ctx, (const char*)tflNodes[i].builtin_data, 0);
+      tflNodes[i].user_data = registrations[nodeData[i].used_op_index].init(&inst->ctx, (const char*)tflNodes[i].builtin_data, 0);
     }
   }
   for(size_t i = 0; i < 4; ++i) {
     if (registrations[nodeData[i].used_op_index].prepare) {
-      TfLiteStatus status = registrations[nodeData[i].used_op_index].prepare(&ctx, &tflNodes[i]);
+      TfLiteStatus status = registrations[nodeData[i].used_op_index].prepare(&inst->ctx, &tflNodes[i]);
       if (status != kTfLiteOk) {
         return status;
       }
@@ -458,35 +518,151 @@ if (registrations[nodeData[i].used_op_index].init) {
   return kTfLiteOk;
 }
 
+static void ReleaseInstanceBuffers(trained_model_instance* inst) {
+  inst->scratch_buffers.clear();
+  for (size_t ix = 0; ix < inst->overflow_buffers.size(); ix++) {
+    free(inst->overflow_buffers[ix]);
+  }
+  inst->overflow_buffers.clear();
+}
+
+} // namespace
+
+TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) ) {
+#ifdef EI_CLASSIFIER_ALLOCATION_HEAP
+  default_instance.tensor_arena = (uint8_t*) alloc_fnc(16, kTensorArenaSize);
+  if (!default_instance.tensor_arena) {
+    printf("ERR: failed to allocate tensor arena\n");
+    return kTfLiteError;
+  }
+#else
+  default_instance.tensor_arena = tensor_arena;
+  memset(tensor_arena, 0, kTensorArenaSize);
+#endif
+  default_instance.arena_size = kTensorArenaSize;
+  default_instance.batch_size = 1;
+  return InitInstance(&default_instance);
+}
+
+TfLiteStatus trained_model_instance_init(trained_model_instance_t** instance, int batch_size, void*(*alloc_fnc)(size_t,size_t) ) {
+  if (batch_size < 1) {
+    printf("ERR: invalid batch size %d\n", batch_size);
+    *instance = NULL;
+    return kTfLiteError;
+  }
+  void* mem = alloc_fnc(16, sizeof(trained_model_instance));
+  if (!mem) {
+    printf("ERR: failed to allocate model instance\n");
+    *instance = NULL;
+    return kTfLiteError;
+  }
+  trained_model_instance* inst = new (mem) trained_model_instance();
+  *instance = inst;
+
+  // Always on the heap, a static arena can only back the default instance
+  inst->batch_size = batch_size;
+  inst->arena_size = kTensorArenaSize * batch_size;
+  inst->tensor_arena = (uint8_t*) alloc_fnc(16, inst->arena_size);
+  if (!inst->tensor_arena) {
+    printf("ERR: failed to allocate tensor arena\n");
+    return kTfLiteError;
+  }
+  return InitInstance(inst);
+}
+
 static const int inTensorIndices[] = {
   0, 
 };
 TfLiteTensor* trained_model_input(int index) {
-  return &ctx.tensors[inTensorIndices[index]];
+  return trained_model_instance_input(&default_instance, index);
+}
+TfLiteTensor* trained_model_instance_input(trained_model_instance_t* instance, int index) {
+  return &instance->ctx.tensors[inTensorIndices[index]];
 }
 
 static const int outTensorIndices[] = {
   10, 
 };
 TfLiteTensor* trained_model_output(int index) {
-  return &ctx.tensors[outTensorIndices[index]];
+  return trained_model_instance_output(&default_instance, index);
+}
+TfLiteTensor* trained_model_instance_output(trained_model_instance_t* instance, int index) {
+  return &instance->ctx.tensors[outTensorIndices[index]];
+}
+
+int trained_model_instance_batch_size(trained_model_instance_t* instance) {
+  return instance->batch_size;
+}
+
+TfLiteStatus trained_model_instance_set_batch(trained_model_instance_t* instance, int rows) {
+  if (rows < 1 || rows > instance->batch_size) {
+    return kTfLiteError;
+  }
+  if (instance->batch_size == 1) {
+    return kTfLiteOk;
+  }
+  // Kernels read the batch from the shape on every invoke, so shrinking the
+  // first dimension skips the unused rows without preparing again
+  for(size_t i = 0; i < 11; ++i) {
+    if (instance->tflTensors[i].allocation_type == kTfLiteArenaRw) {
+      instance->batchDims[i][1] = rows;
+    }
+  }
+  return kTfLiteOk;
 }
 
 TfLiteStatus trained_model_invoke() {
+  return trained_model_instance_invoke(&default_instance);
+}
+
+#if EI_CLASSIFIER_PROFILE_NODES
+// Size of the input (incl. weights) and output tensors of a node
+static size_t NodeTensorBytes(trained_model_instance_t* instance, size_t node_index) {
+  size_t bytes = 0;
+  const TfLiteIntArray* arrays[] = { nodeData[node_index].inputs, nodeData[node_index].outputs };
+  for (const TfLiteIntArray* array : arrays) {
+    for (int ix = 0; ix < array->size; ix++) {
+      size_t tensor_bytes;
+      if (array->data[ix] >= 0 &&
+          TfLiteEvalTensorByteLength(&instance->tflEvalTensors[array->data[ix]], &tensor_bytes) == kTfLiteOk) {
+        bytes += tensor_bytes;
+      }
+    }
+  }
+  return bytes;
+}
+
+const ei_model_profile_t* trained_model_profile() {
+  return trained_model_instance_profile(&default_instance);
+}
+
+const ei_model_profile_t* trained_model_instance_profile(trained_model_instance_t* instance) {
+  return &instance->profile;
+}
+#endif // EI_CLASSIFIER_PROFILE_NODES
+
+TfLiteStatus trained_model_instance_invoke(trained_model_instance_t* instance) {
+#if EI_CLASSIFIER_PROFILE_NODES
+  ei_model_profile_clear(&instance->profile);
+#endif
   for(size_t i = 0; i < 4; ++i) {
-    TfLiteStatus status = registrations[nodeData[i].used_op_index].invoke(&ctx, &tflNodes[i]);
+#if EI_CLASSIFIER_PROFILE_NODES
+    uint64_t node_start_ns = EI_CLASSIFIER_PROFILE_READ_NS();
+#endif
+    TfLiteStatus status = registrations[nodeData[i].used_op_index].invoke(&instance->ctx, &instance->tflNodes[i]);
+#if EI_CLASSIFIER_PROFILE_NODES
+    ei_model_profile_add(&instance->profile, used_operator_names[nodeData[i].used_op_index],
+      EI_CLASSIFIER_PROFILE_READ_NS() - node_start_ns, NodeTensorBytes(instance, i));
+#endif
 
 #if EI_CLASSIFIER_PRINT_STATE
+    TfLiteNode* tflNodes = instance->tflNodes;
     ei_printf("layer %lu\n", i);
     ei_printf("    inputs:\n");
     for (size_t ix = 0; ix < tflNodes[i].inputs->size; ix++) {
       auto d = tensorData[tflNodes[i].inputs->data[ix]];
 
-      size_t data_ptr = (size_t)d.data;
-
-      if (d.allocation_type == kTfLiteArenaRw) {
-        data_ptr = (size_t)tensor_arena + data_ptr;
-      }
+      size_t data_ptr = (size_t)instance->tflTensors[tflNodes[i].inputs->data[ix]].data.data;
 
       if (d.type == TfLiteType::kTfLiteInt8) {
         int8_t* data = (int8_t*)data_ptr;
@@ -510,11 +686,7 @@ TfLiteStatus trained_model_invoke() {
     for (size_t ix = 0; ix < tflNodes[i].outputs->size; ix++) {
       auto d = tensorData[tflNodes[i].outputs->data[ix]];
 
-      size_t data_ptr = (size_t)d.data;
-
-      if (d.allocation_type == kTfLiteArenaRw) {
-        data_ptr = (size_t)tensor_arena + data_ptr;
-      }
+      size_t data_ptr = (size_t)instance->tflTensors[tflNodes[i].outputs->data[ix]].data.data;
 
       if (d.type == TfLiteType::kTfLiteInt8) {
         int8_t* data = (int8_t*)data_ptr;
@@ -544,12 +716,24 @@ TfLiteStatus trained_model_invoke() {
 
 TfLiteStatus trained_model_reset( void (*free_fnc)(void* ptr) ) {
 #ifdef EI_CLASSIFIER_ALLOCATION_HEAP
-  free_fnc(tensor_arena);
+  if (default_instance.tensor_arena) {
+    free_fnc(default_instance.tensor_arena);
+    default_instance.tensor_arena = NULL;
+  }
 #endif
-  scratch_buffers.clear();
-  for (size_t ix = 0; ix < overflow_buffers.size(); ix++) {
-    free(overflow_buffers[ix]);
+  ReleaseInstanceBuffers(&default_instance);
+  return kTfLiteOk;
+}
+
+TfLiteStatus trained_model_instance_reset(trained_model_instance_t* instance, void (*free_fnc)(void* ptr) ) {
+  if (!instance) {
+    return kTfLiteOk;
+  }
+  if (instance->tensor_arena) {
+    free_fnc(instance->tensor_arena);
   }
-  overflow_buffers.clear();
+  ReleaseInstanceBuffers(instance);
+  instance->~trained_model_instance();
+  free_fnc(instance);
   return kTfLiteOk;
 }
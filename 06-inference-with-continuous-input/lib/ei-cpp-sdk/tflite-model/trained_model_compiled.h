@@ -24,6 +24,7 @@
 #define trained_model_GEN_H
 
 #include "edge-impulse-sdk/tensorflow/lite/c/common.h"
+#include "edge-impulse-sdk/classifier/ei_model_profile.h"
 
 // Sets up the model with init and prepare steps.
 TfLiteStatus trained_model_init( void*(*alloc_fnc)(size_t,size_t) );
@@ -36,6 +37,36 @@ TfLiteStatus trained_model_invoke();
 //Frees memory allocated
 TfLiteStatus trained_model_reset( void (*free)(void* ptr) );
 
+// Independent copy of the model state (arena, tensors, nodes and scratch
+// buffers). All instances share the read-only weights, so several instances
+// can run at the same time, e.g. one per thread.
+typedef struct trained_model_instance trained_model_instance_t;
+
+// Allocates a new instance and sets it up with init and prepare steps.
+// With a batch_size above 1 the instance holds that many input windows
+// (stacked rows of the input tensor) and runs them in one invoke.
+// Call trained_model_instance_reset() afterwards, also if this fails.
+TfLiteStatus trained_model_instance_init( trained_model_instance_t **instance, int batch_size, void*(*alloc_fnc)(size_t,size_t) );
+// Returns the number of rows an instance was allocated for.
+int trained_model_instance_batch_size(trained_model_instance_t *instance);
+// Sets the number of rows (1 up to the batch size) the next invoke runs on.
+TfLiteStatus trained_model_instance_set_batch(trained_model_instance_t *instance, int rows);
+// Returns the input tensor with the given index of an instance.
+TfLiteTensor *trained_model_instance_input(trained_model_instance_t *instance, int index);
+// Returns the output tensor with the given index of an instance.
+TfLiteTensor *trained_model_instance_output(trained_model_instance_t *instance, int index);
+// Runs inference for an instance.
+TfLiteStatus trained_model_instance_invoke(trained_model_instance_t *instance);
+// Frees the instance and all memory allocated for it
+TfLiteStatus trained_model_instance_reset( trained_model_instance_t *instance, void (*free)(void* ptr) );
+
+#if EI_CLASSIFIER_PROFILE_NODES
+// Returns the time and tensor bytes of every node in the last invoke.
+const ei_model_profile_t *trained_model_profile();
+// Same for an instance.
+const ei_model_profile_t *trained_model_instance_profile(trained_model_instance_t *instance);
+#endif
+
 
 // Returns the number of input tensors.
 inline size_t trained_model_inputs() {
@@ -0,0 +1,280 @@
+/**
+ * Memory-mapped pack of IMU recordings
+ *
+ * A pack holds many recordings (e.g. every CSV file of a dataset directory)
+ * in one binary file, so a harness or evaluator can iterate them without
+ * parsing text or opening a file per recording. The file is mapped read-only
+ * and the sample data is used in place. Packs are written by
+ * 01-data-capture/csv-to-pack.py.
+ *
+ * Layout (little-endian, every section 64-byte aligned):
+ *
+ *   header      ImuPackHeader
+ *   labels      label_count x uint32 offset of the label name in strings
+ *   index       record_count x ImuPackRecord
+ *   strings     NUL-terminated names and labels
+ *   data        per recording, row_count x channel_count float32 samples
+ *               interleaved by row (accX, accY, accZ, gyrX, gyrY, gyrZ)
+ *
+ * Timestamps are not stored: row r of a recording was sampled at
+ * r * interval_ms.
+ *
+ * License: Apache-2.0
+ *
+ * Copyright 2022 EdgeImpulse, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef IMU_PACK_H
+#define IMU_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    #define IMU_PACK_USE_MMAP       0
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #define IMU_PACK_USE_MMAP       1
+#endif
+
+// File identification and format version
+#define IMU_PACK_MAGIC              "IMUPACK"
+#define IMU_PACK_VERSION            1
+
+// Sample formats
+#define IMU_PACK_FORMAT_FLOAT32     0
+
+// Fixed-size file header
+typedef struct {
+    char magic[8];              // "IMUPACK\0"
+    uint32_t version;           // IMU_PACK_VERSION
+    uint32_t sample_format;     // IMU_PACK_FORMAT_FLOAT32
+    uint32_t channel_count;     // Values per row
+    uint32_t label_count;       // Entries in the labels section
+    uint32_t record_count;      // Entries in the index section
+    uint32_t reserved;
+    uint64_t labels_offset;     // File offset of the labels section
+    uint64_t index_offset;      // File offset of the index section
+    uint64_t strings_offset;    // File offset of the strings section
+    uint64_t strings_size;      // Size of the strings section (bytes)
+} ImuPackHeader;
+
+// One recording in the index
+typedef struct {
+    uint32_t name_offset;       // Offset of the name in strings
+    uint32_t label_idx;         // Index into the labels section
+    uint32_t row_count;         // Number of rows (readings)
+    float interval_ms;          // Time between two rows (milliseconds)
+    uint64_t data_offset;       // File offset of the first sample
+} ImuPackRecord;
+
+static_assert(sizeof(ImuPackHeader) == 64, "ImuPackHeader must be 64 bytes");
+static_assert(sizeof(ImuPackRecord) == 24, "ImuPackRecord must be 24 bytes");
+
+class ImuPack {
+    public:
+        ImuPack() {
+
+        }
+
+        ~ImuPack() {
+            close();
+        }
+
+        // Map a pack file. Prints the reason and returns false if the file
+        // can't be read or is not a valid pack.
+        bool open(const char *path) {
+            close();
+
+            if (!mapFile(path)) {
+                printf("ERROR: Could not read %s\r\n", path);
+                return false;
+            }
+            if (!validate()) {
+                printf("ERROR: %s is not a valid pack file\r\n", path);
+                close();
+                return false;
+            }
+
+            return true;
+        }
+
+        // Unmap the file
+        void close() {
+            if (!file_data) {
+                return;
+            }
+#if IMU_PACK_USE_MMAP
+            munmap((void *)file_data, file_size);
+#else
+            free((void *)file_data);
+#endif
+            file_data = NULL;
+            file_size = 0;
+            header = NULL;
+            labels = NULL;
+            index = NULL;
+            strings = NULL;
+        }
+
+        // Number of recordings
+        size_t size() const {
+            return header ? header->record_count : 0;
+        }
+
+        // Values per row
+        size_t channels() const {
+            return header ? header->channel_count : 0;
+        }
+
+        // Name of a recording (its CSV filename)
+        const char *name(size_t idx) const {
+            return strings + index[idx].name_offset;
+        }
+
+        // Label of a recording
+        const char *label(size_t idx) const {
+            return strings + labels[index[idx].label_idx];
+        }
+
+        // Number of rows in a recording
+        size_t rows(size_t idx) const {
+            return index[idx].row_count;
+        }
+
+        // Time between two rows of a recording (milliseconds)
+        float intervalMs(size_t idx) const {
+            return index[idx].interval_ms;
+        }
+
+        // Samples of a recording, rows() x channels() values (in the mapping)
+        const float *data(size_t idx) const {
+            return (const float *)(file_data + index[idx].data_offset);
+        }
+
+    private:
+        ImuPack(const ImuPack&) = delete;
+        ImuPack& operator=(const ImuPack&) = delete;
+
+        // Map (or, without mmap, read) the whole file
+        bool mapFile(const char *path) {
+#if IMU_PACK_USE_MMAP
+            int fd = ::open(path, O_RDONLY);
+            if (fd < 0) {
+                return false;
+            }
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+                ::close(fd);
+                return false;
+            }
+            void *mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (mapping == MAP_FAILED) {
+                return false;
+            }
+            file_data = (const uint8_t *)mapping;
+            file_size = (size_t)st.st_size;
+#else
+            FILE *file = fopen(path, "rb");
+            if (!file) {
+                return false;
+            }
+            fseek(file, 0, SEEK_END);
+            long size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+            uint8_t *buf = size > 0 ? (uint8_t *)malloc((size_t)size) : NULL;
+            if (!buf || fread(buf, 1, (size_t)size, file) != (size_t)size) {
+                free(buf);
+                fclose(file);
+                return false;
+            }
+            fclose(file);
+            file_data = buf;
+            file_size = (size_t)size;
+#endif
+            return true;
+        }
+
+        // Check that a section of count * elem_size bytes lies in the file
+        bool inFile(uint64_t offset, uint64_t count, uint64_t elem_size) const {
+            return offset <= file_size && count <= (file_size - offset) / elem_size;
+        }
+
+        // Check the header and that every section, name and recording lies
+        // in the file
+        bool validate() {
+            if (file_size < sizeof(ImuPackHeader)) {
+                return false;
+            }
+            header = (const ImuPackHeader *)file_data;
+            if (memcmp(header->magic, IMU_PACK_MAGIC, sizeof(IMU_PACK_MAGIC)) != 0 ||
+                    header->version != IMU_PACK_VERSION ||
+                    header->sample_format != IMU_PACK_FORMAT_FLOAT32 ||
+                    header->channel_count == 0) {
+                return false;
+            }
+            if (!inFile(header->labels_offset, header->label_count, sizeof(uint32_t)) ||
+                    !inFile(header->index_offset, header->record_count, sizeof(ImuPackRecord)) ||
+                    !inFile(header->strings_offset, header->strings_size, 1) ||
+                    header->strings_size == 0 ||
+                    file_data[header->strings_offset + header->strings_size - 1] != '\0') {
+                return false;
+            }
+
+            labels = (const uint32_t *)(file_data + header->labels_offset);
+            index = (const ImuPackRecord *)(file_data + header->index_offset);
+            strings = (const char *)(file_data + header->strings_offset);
+
+            for (uint32_t i = 0; i < header->label_count; i++) {
+                if (labels[i] >= header->strings_size) {
+                    return false;
+                }
+            }
+            for (uint32_t i = 0; i < header->record_count; i++) {
+                const ImuPackRecord& record = index[i];
+                if (record.name_offset >= header->strings_size ||
+                        record.label_idx >= header->label_count ||
+                        record.data_offset % sizeof(float) != 0 ||
+                        !inFile(record.data_offset, (uint64_t)record.row_count * header->channel_count,
+                            sizeof(float))) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        const uint8_t *file_data = NULL;
+        size_t file_size = 0;
+        const ImuPackHeader *header = NULL;
+        const uint32_t *labels = NULL;
+        const ImuPackRecord *index = NULL;
+        const char *strings = NULL;
+};
+
+// Check if a path names a pack file (by its .pack extension)
+static inline bool isImuPackFile(const char *path) {
+    size_t len = strlen(path);
+    return len > 5 && strcmp(path + len - 5, ".pack") == 0;
+}
+
+#endif // IMU_PACK_H
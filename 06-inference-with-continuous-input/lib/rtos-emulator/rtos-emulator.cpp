@@ -0,0 +1,317 @@
+/**
+ * RTOS emulator class definitions
+ */
+
+#include <errno.h>
+#include <time.h>
+
+#include "time-emulator.h"
+#include "rtos-emulator.h"
+
+// Initialize a condition variable that times out against CLOCK_MONOTONIC, so
+// timeouts are not affected by changes to the wall clock
+static void init_monotonic_cond(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+// Virtual clock deadline millisec from now
+static unsigned long long virtual_deadline_from_now(uint32_t millisec) {
+    if (millisec == osWaitForever) {
+        return VIRTUAL_CLOCK_FOREVER;
+    }
+
+    return (unsigned long long)micros() + (unsigned long long)millisec * 1000;
+}
+
+// Absolute CLOCK_MONOTONIC deadline millisec from now
+static struct timespec deadline_from_now(uint32_t millisec) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += millisec / 1000;
+    deadline.tv_nsec += (long)(millisec % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    return deadline;
+}
+
+namespace rtos {
+
+/*******************************************************************************
+ * Thread
+ */
+
+// Constructor (stack settings are ignored, pthreads manages the stack)
+Thread::Thread(osPriority priority, uint32_t stack_size,
+                unsigned char *stack_mem, const char *name) :
+    thread_priority(priority), thread_task(NULL), started(false),
+    joined(false), finished(false), vclock_id(-1) {
+
+}
+
+// Destructor
+Thread::~Thread() {
+    join();
+}
+
+// Create the pthread (registered with the virtual clock scheduler if enabled)
+osStatus Thread::start(void (*task)(void)) {
+    if (started || task == NULL) {
+        return osError;
+    }
+    thread_task = task;
+
+    if (virtual_clock_enabled()) {
+        vclock_id = virtual_clock_register_thread(thread_priority);
+    }
+    if (pthread_create(&thread_handle, NULL, &Thread::entry, this) != 0) {
+        return osError;
+    }
+    started = true;
+
+    return osOK;
+}
+
+// Wait for the thread to finish
+osStatus Thread::join() {
+    if (!started) {
+        return osError;
+    }
+    if (joined) {
+        return osOK;
+    }
+
+    // Let the scheduler run the thread until it is done
+    if (vclock_id >= 0 && virtual_clock_is_registered()) {
+        std::function<bool()> done = [this] { return finished; };
+        virtual_clock_block_until(done, VIRTUAL_CLOCK_FOREVER);
+    }
+    pthread_join(thread_handle, NULL);
+    joined = true;
+
+    return osOK;
+}
+
+osPriority Thread::get_priority() const {
+    return thread_priority;
+}
+
+// Run the thread function
+void *Thread::entry(void *arg) {
+    Thread *thread = (Thread *)arg;
+
+    if (thread->vclock_id >= 0) {
+        virtual_clock_enter_thread(thread->vclock_id);
+    }
+    thread->thread_task();
+    thread->finished = true;
+    if (thread->vclock_id >= 0) {
+        virtual_clock_exit_thread();
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * EventFlags
+ */
+
+// Constructor
+EventFlags::EventFlags(uint32_t flags) : event_flags(flags & ~osFlagsError) {
+    pthread_mutex_init(&mutex, NULL);
+    init_monotonic_cond(&cond);
+}
+
+// Destructor
+EventFlags::~EventFlags() {
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+// Set flags and wake up all waiting threads (each checks its own flags)
+uint32_t EventFlags::set(uint32_t flags) {
+    if (flags & osFlagsError) {
+        return osFlagsError;
+    }
+
+    pthread_mutex_lock(&mutex);
+    event_flags |= flags;
+    uint32_t ret = event_flags;
+    pthread_cond_broadcast(&cond);
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
+
+// Clear flags
+uint32_t EventFlags::clear(uint32_t flags) {
+    pthread_mutex_lock(&mutex);
+    uint32_t ret = event_flags;
+    event_flags &= ~flags;
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
+
+// Get the currently set flags
+uint32_t EventFlags::get() const {
+    pthread_mutex_lock(&mutex);
+    uint32_t ret = event_flags;
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
+
+// Wait until any of the flags are set
+uint32_t EventFlags::wait_any(uint32_t flags, uint32_t millisec, bool clear) {
+    return wait(flags, millisec, clear, false);
+}
+
+// Wait until all of the flags are set
+uint32_t EventFlags::wait_all(uint32_t flags, uint32_t millisec, bool clear) {
+    return wait(flags, millisec, clear, true);
+}
+
+// Block on the condition variable until the flags match or we time out
+uint32_t EventFlags::wait(uint32_t flags, uint32_t millisec, bool clear, bool all) {
+    struct timespec deadline = deadline_from_now(millisec == osWaitForever ? 0 : millisec);
+    unsigned long long virtual_deadline = virtual_deadline_from_now(millisec);
+    bool use_virtual_clock = virtual_clock_is_registered();
+    uint32_t ret = osFlagsErrorTimeout;
+
+    // Flags are only set by the running thread, so the scheduler can check them
+    std::function<bool()> ready = [&] {
+        uint32_t set_flags = event_flags & flags;
+        return (all && set_flags == flags) || (!all && set_flags != 0);
+    };
+
+    pthread_mutex_lock(&mutex);
+    while (true) {
+
+        // Check if the flags we are waiting for are set
+        uint32_t set_flags = event_flags & flags;
+        if ((all && set_flags == flags) || (!all && set_flags != 0)) {
+            ret = event_flags;
+            if (clear) {
+                event_flags &= ~flags;
+            }
+            break;
+        }
+
+        // Sleep until notified (or until the deadline)
+        if (millisec == 0) {
+            break;
+        } else if (use_virtual_clock) {
+            pthread_mutex_unlock(&mutex);
+            if (!virtual_clock_block_until(ready, virtual_deadline)) {
+                millisec = 0;
+            }
+            pthread_mutex_lock(&mutex);
+        } else if (millisec == osWaitForever) {
+            pthread_cond_wait(&cond, &mutex);
+        } else if (pthread_cond_timedwait(&cond, &mutex, &deadline) == ETIMEDOUT) {
+            millisec = 0;
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
+
+/*******************************************************************************
+ * Semaphore
+ */
+
+// Constructor
+Semaphore::Semaphore(int32_t count, uint16_t max_count) :
+    tokens(count), max_tokens(max_count) {
+    pthread_mutex_init(&mutex, NULL);
+    init_monotonic_cond(&cond);
+}
+
+// Destructor
+Semaphore::~Semaphore() {
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+}
+
+// Wait forever for a token
+void Semaphore::acquire() {
+    try_acquire_for(osWaitForever);
+}
+
+// Take a token if one is available, do not wait
+bool Semaphore::try_acquire() {
+    return try_acquire_for(0);
+}
+
+// Wait up to millisec for a token
+bool Semaphore::try_acquire_for(uint32_t millisec) {
+    struct timespec deadline = deadline_from_now(millisec == osWaitForever ? 0 : millisec);
+    unsigned long long virtual_deadline = virtual_deadline_from_now(millisec);
+    bool use_virtual_clock = virtual_clock_is_registered();
+    bool acquired = false;
+
+    // Tokens are only released by the running thread
+    std::function<bool()> ready = [this] { return tokens > 0; };
+
+    pthread_mutex_lock(&mutex);
+    while (true) {
+        if (tokens > 0) {
+            tokens--;
+            acquired = true;
+            break;
+        }
+
+        // Sleep until a token is released (or until the deadline)
+        if (millisec == 0) {
+            break;
+        } else if (use_virtual_clock) {
+            pthread_mutex_unlock(&mutex);
+            if (!virtual_clock_block_until(ready, virtual_deadline)) {
+                millisec = 0;
+            }
+            pthread_mutex_lock(&mutex);
+        } else if (millisec == osWaitForever) {
+            pthread_cond_wait(&cond, &mutex);
+        } else if (pthread_cond_timedwait(&cond, &mutex, &deadline) == ETIMEDOUT) {
+            millisec = 0;
+        }
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return acquired;
+}
+
+// Give back a token and wake up one waiting thread
+int Semaphore::release() {
+    int ret = 0;
+
+    pthread_mutex_lock(&mutex);
+    if (tokens < max_tokens) {
+        tokens++;
+        pthread_cond_signal(&cond);
+    } else {
+        ret = -1;
+    }
+    pthread_mutex_unlock(&mutex);
+
+    return ret;
+}
+
+/*******************************************************************************
+ * ThisThread
+ */
+
+// Sleep the calling thread (same as delay() in the time emulator)
+void ThisThread::sleep_for(uint32_t millisec) {
+    delay(millisec);
+}
+
+} // namespace rtos
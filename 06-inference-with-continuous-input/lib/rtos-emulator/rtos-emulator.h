@@ -0,0 +1,154 @@
+/**
+ * Emulate the rtos::Thread, rtos::EventFlags, rtos::Semaphore, and
+ * rtos::ThisThread primitives from Mbed OS (used by Arduino Nano 33 BLE Sense)
+ * on top of pthreads, so threads can sleep until they are notified instead of
+ * polling with delay(). With the virtual clock of the time emulator enabled,
+ * threads and waits go through its scheduler.
+ *
+ * License: Apache-2.0
+ *
+ * Copyright 2022 EdgeImpulse, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RTOSEMU_H
+#define RTOSEMU_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Wait without timeout
+#define osWaitForever           0xFFFFFFFFU
+
+// Flag bits reserved for error codes (returned by EventFlags on failure)
+#define osFlagsError            0x80000000U
+#define osFlagsErrorTimeout     0xFFFFFFFEU
+
+// Thread priorities
+typedef enum {
+    osPriorityIdle          = 1,
+    osPriorityLow           = 8,
+    osPriorityBelowNormal   = 16,
+    osPriorityNormal        = 24,
+    osPriorityAboveNormal   = 32,
+    osPriorityHigh          = 40,
+    osPriorityRealtime      = 48
+} osPriority;
+
+// Status codes
+typedef enum {
+    osOK                    = 0,
+    osError                 = -1
+} osStatus;
+
+namespace rtos {
+
+// Thread that runs a function
+class Thread {
+    public:
+        Thread(osPriority priority = osPriorityNormal, uint32_t stack_size = 0,
+                unsigned char *stack_mem = NULL, const char *name = NULL);
+        ~Thread();
+
+        // Start the thread (only once)
+        osStatus start(void (*task)(void));
+
+        // Wait for the thread function to return
+        osStatus join();
+
+        osPriority get_priority() const;
+
+    private:
+        Thread(const Thread&);
+        Thread& operator=(const Thread&);
+        static void *entry(void *arg);
+
+        osPriority thread_priority;
+        void (*thread_task)(void);
+        pthread_t thread_handle;
+        bool started;
+        bool joined;
+        bool finished;
+        int vclock_id;
+};
+
+// Set of 31 flags that threads can wait on
+class EventFlags {
+    public:
+        EventFlags(uint32_t flags = 0);
+        ~EventFlags();
+
+        // Set flags and wake up waiting threads. Returns the flags after
+        // setting them.
+        uint32_t set(uint32_t flags);
+
+        // Clear flags. Returns the flags before clearing them.
+        uint32_t clear(uint32_t flags = 0x7FFFFFFF);
+
+        // Get the currently set flags
+        uint32_t get() const;
+
+        // Wait until any/all of the flags are set or millisec has passed.
+        // Returns the flags before clearing them, or osFlagsErrorTimeout.
+        uint32_t wait_any(uint32_t flags = 0, uint32_t millisec = osWaitForever, bool clear = true);
+        uint32_t wait_all(uint32_t flags = 0, uint32_t millisec = osWaitForever, bool clear = true);
+
+    private:
+        EventFlags(const EventFlags&);
+        EventFlags& operator=(const EventFlags&);
+        uint32_t wait(uint32_t flags, uint32_t millisec, bool clear, bool all);
+
+        uint32_t event_flags;
+        mutable pthread_mutex_t mutex;
+        pthread_cond_t cond;
+};
+
+// Counting semaphore
+class Semaphore {
+    public:
+        Semaphore(int32_t count = 0, uint16_t max_count = 0xFFFF);
+        ~Semaphore();
+
+        // Wait until a token is available and take it
+        void acquire();
+
+        // Take a token if one is available (or becomes available within
+        // millisec). Returns true if a token was taken.
+        bool try_acquire();
+        bool try_acquire_for(uint32_t millisec);
+
+        // Give back a token. Returns -1 if the semaphore was already full.
+        int release();
+
+    private:
+        Semaphore(const Semaphore&);
+        Semaphore& operator=(const Semaphore&);
+
+        int32_t tokens;
+        uint16_t max_tokens;
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+};
+
+namespace ThisThread {
+
+// Sleep the calling thread for millisec milliseconds
+void sleep_for(uint32_t millisec);
+
+} // namespace ThisThread
+
+} // namespace rtos
+
+#endif // RTOSEMU_H
@@ -0,0 +1,238 @@
+/**
+ * Lock-free single-producer/single-consumer ring buffer
+ *
+ * One thread (e.g. the sampling thread) fills slots and commits them, another
+ * thread (e.g. the inference thread) waits for, reads, and releases them. The
+ * head and tail indices are the only shared state: each one is written by a
+ * single thread and published with release/acquire ordering, so no locks are
+ * needed. The indices live on their own cache lines so the two threads do not
+ * fight over the same line.
+ *
+ * If the producer gets a full ring, the slot is written to a private discard
+ * slot instead and counted as an overrun when committed. The consumer can
+ * report overrun counts rather than the producer printing from its loop.
+ *
+ * Blocking waits use a futex on Linux, rtos::EventFlags on Mbed OS (Arduino),
+ * and a condition variable anywhere else.
+ *
+ * Instances are meant to be declared static (or on the stack): C++14 does not
+ * guarantee that operator new honors the cache line alignment.
+ *
+ * License: Apache-2.0
+ *
+ * Copyright 2022 EdgeImpulse, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#if defined(ARDUINO)
+    #include <mbed.h>
+    #define SPSC_WAIT_EVENTFLAGS    1
+#elif defined(__linux__)
+    #include <time.h>
+    #include <unistd.h>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #define SPSC_WAIT_FUTEX         1
+#else
+    #include <chrono>
+    #include <condition_variable>
+    #include <mutex>
+    #define SPSC_WAIT_CONDVAR       1
+#endif
+
+// Size of a cache line, used to keep the producer and consumer indices apart
+#ifndef SPSC_CACHE_LINE_SIZE
+#define SPSC_CACHE_LINE_SIZE        64
+#endif
+
+// Ring buffer of slots of type T. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscRingBuffer {
+    static_assert(Capacity >= 2, "Capacity must be at least 2");
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        SpscRingBuffer() : head(0), tail(0), waiting(0), overrun_count(0) {
+
+        }
+
+        /***********************************************************************
+         * Producer
+         */
+
+        // Get the slot to fill next. Never returns NULL: if the ring is full,
+        // the private discard slot is returned and commitWrite() counts an
+        // overrun.
+        T *beginWrite() {
+            uint32_t h = head.load(std::memory_order_relaxed);
+            if (h - cached_tail >= Capacity) {
+                cached_tail = tail.load(std::memory_order_acquire);
+            }
+            write_discarded = (h - cached_tail >= Capacity);
+
+            return write_discarded ? &discard_slot : &slots[h & (Capacity - 1)];
+        }
+
+        // Publish the slot returned by beginWrite() to the consumer
+        // Returns false if the slot was dropped because the ring was full
+        bool commitWrite() {
+            if (write_discarded) {
+                overrun_count.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+
+            // seq_cst so the store is ordered before reading the waiting flag
+            uint32_t h = head.load(std::memory_order_relaxed) + 1;
+            head.store(h, std::memory_order_seq_cst);
+            if (waiting.load(std::memory_order_seq_cst)) {
+                notifyConsumer();
+            }
+
+            return true;
+        }
+
+        /***********************************************************************
+         * Consumer
+         */
+
+        // Oldest committed slot, or NULL if the ring is empty
+        const T *front() {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            if (cached_head == t) {
+                cached_head = head.load(std::memory_order_acquire);
+                if (cached_head == t) {
+                    return NULL;
+                }
+            }
+
+            return &slots[t & (Capacity - 1)];
+        }
+
+        // Hand the slot returned by front() back to the producer
+        void pop() {
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            tail.store(t + 1, std::memory_order_release);
+        }
+
+        // Block until a slot is available or timeout_ms has passed
+        // Returns the oldest committed slot, or NULL on timeout
+        const T *waitFront(unsigned long timeout_ms) {
+            const T *slot = front();
+            if (slot != NULL) {
+                return slot;
+            }
+
+            // Announce that we are about to sleep, then re-check so a commit
+            // between front() and here cannot be missed
+            waiting.store(1, std::memory_order_seq_cst);
+            uint32_t t = tail.load(std::memory_order_relaxed);
+            uint32_t h = head.load(std::memory_order_seq_cst);
+            if (h == t) {
+                waitForCommit(h, timeout_ms);
+            }
+            waiting.store(0, std::memory_order_relaxed);
+
+            return front();
+        }
+
+        /***********************************************************************
+         * Status (safe from either thread)
+         */
+
+        // Number of committed slots that have not been popped yet
+        size_t size() const {
+            return head.load(std::memory_order_acquire) -
+                    tail.load(std::memory_order_acquire);
+        }
+
+        // Number of slots dropped because the consumer fell behind
+        uint32_t overruns() const {
+            return overrun_count.load(std::memory_order_relaxed);
+        }
+
+        static constexpr size_t capacity() {
+            return Capacity;
+        }
+
+    private:
+#if SPSC_WAIT_FUTEX
+        void waitForCommit(uint32_t expected_head, unsigned long timeout_ms) {
+            struct timespec timeout;
+            timeout.tv_sec = timeout_ms / 1000;
+            timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+            // The kernel only sleeps if head still equals expected_head
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&head),
+                    FUTEX_WAIT_PRIVATE, expected_head, &timeout, NULL, 0);
+        }
+
+        void notifyConsumer() {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&head),
+                    FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+        }
+#elif SPSC_WAIT_EVENTFLAGS
+        void waitForCommit(uint32_t expected_head, unsigned long timeout_ms) {
+            (void)expected_head;
+            event_flags.wait_any(0x01, timeout_ms);
+        }
+
+        void notifyConsumer() {
+            event_flags.set(0x01);
+        }
+#else
+        void waitForCommit(uint32_t expected_head, unsigned long timeout_ms) {
+            std::unique_lock<std::mutex> lock(wait_mutex);
+            wait_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&] {
+                return head.load(std::memory_order_acquire) != expected_head;
+            });
+        }
+
+        void notifyConsumer() {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            wait_cond.notify_one();
+        }
+#endif
+
+        // Written by the producer only
+        alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> head;
+        uint32_t cached_tail = 0;
+        bool write_discarded = false;
+
+        // Written by the consumer only
+        alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> tail;
+        uint32_t cached_head = 0;
+        std::atomic<uint32_t> waiting;
+
+        // Shared counters and wait primitives
+        alignas(SPSC_CACHE_LINE_SIZE) std::atomic<uint32_t> overrun_count;
+#if SPSC_WAIT_EVENTFLAGS
+        rtos::EventFlags event_flags;
+#elif SPSC_WAIT_CONDVAR
+        std::mutex wait_mutex;
+        std::condition_variable wait_cond;
+#endif
+
+        // Slots (and the slot that absorbs writes when the ring is full)
+        alignas(SPSC_CACHE_LINE_SIZE) T slots[Capacity];
+        T discard_slot;
+};
+
+#endif // SPSC_RING_BUFFER_H
@@ -1,40 +1,231 @@
-#define _POSIX_C_SOURCE 199309L
+#define _POSIX_C_SOURCE 200112L
 
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include <unistd.h>
+#include <atomic>
+#include <vector>
 
 #include "time-emulator.h"
 
+/*******************************************************************************
+ * Virtual clock
+ */
+
+// Scheduler state of an emulated thread
+enum vthread_state {
+    VTHREAD_READY,
+    VTHREAD_RUNNING,
+    VTHREAD_BLOCKED,
+    VTHREAD_DONE
+};
+
+// Emulated thread known to the scheduler
+struct vthread {
+    int priority;
+    vthread_state state;
+    unsigned long long deadline_us;         // Wake up time when blocked
+    const std::function<bool()> *ready;     // Wake up condition when blocked
+};
+
+static std::atomic<bool> vclock_on(false);
+static std::atomic<unsigned long long> vclock_now_us(0);
+static pthread_mutex_t vclock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t vclock_cond = PTHREAD_COND_INITIALIZER;
+static std::vector<vthread> vclock_threads;
+static int vclock_current = -1;
+static thread_local int vclock_self = -1;
+
+// Can this thread run now? (vclock_mutex must be held)
+static bool vclock_runnable(const vthread &t) {
+    if (t.state == VTHREAD_READY) {
+        return true;
+    }
+    if (t.state != VTHREAD_BLOCKED) {
+        return false;
+    }
+
+    return (t.deadline_us <= vclock_now_us) || (t.ready && *t.ready && (*t.ready)());
+}
+
+// Pick the thread to run next: the ready thread with the highest priority
+// (lowest id on ties). If no thread is ready, advance the clock to the next
+// deadline. Returns -1 if no thread can ever run again. (vclock_mutex held)
+static int vclock_pick_next() {
+    while (true) {
+        int next = -1;
+        for (size_t i = 0; i < vclock_threads.size(); i++) {
+            if (vclock_runnable(vclock_threads[i]) &&
+                (next < 0 || vclock_threads[i].priority > vclock_threads[next].priority)) {
+                next = (int)i;
+            }
+        }
+        if (next >= 0) {
+            return next;
+        }
+
+        // Nobody can run: jump to the earliest deadline
+        unsigned long long earliest = VIRTUAL_CLOCK_FOREVER;
+        for (size_t i = 0; i < vclock_threads.size(); i++) {
+            if ((vclock_threads[i].state == VTHREAD_BLOCKED) &&
+                (vclock_threads[i].deadline_us < earliest)) {
+                earliest = vclock_threads[i].deadline_us;
+            }
+        }
+        if (earliest == VIRTUAL_CLOCK_FOREVER) {
+            return -1;
+        }
+        vclock_now_us = earliest;
+    }
+}
+
+// Hand the CPU from the calling thread to the next thread (vclock_mutex held)
+static void vclock_schedule() {
+    int next = vclock_pick_next();
+    if (next < 0) {
+        for (size_t i = 0; i < vclock_threads.size(); i++) {
+            if (vclock_threads[i].state == VTHREAD_BLOCKED) {
+                fprintf(stderr, "ERROR: Virtual clock deadlock, all threads wait forever\r\n");
+                abort();
+            }
+        }
+        vclock_current = -1;
+        return;
+    }
+
+    vclock_threads[next].state = VTHREAD_RUNNING;
+    vclock_current = next;
+    pthread_cond_broadcast(&vclock_cond);
+}
+
+// Switch to the virtual clock and register the calling (main) thread
+void virtual_clock_enable(void) {
+    pthread_mutex_lock(&vclock_mutex);
+    if (!vclock_on) {
+        vthread main_thread = {0, VTHREAD_RUNNING, VIRTUAL_CLOCK_FOREVER, NULL};
+        vclock_threads.push_back(main_thread);
+        vclock_self = (int)vclock_threads.size() - 1;
+        vclock_current = vclock_self;
+        vclock_now_us = 0;
+        vclock_on = true;
+    }
+    pthread_mutex_unlock(&vclock_mutex);
+}
+
+int virtual_clock_enabled(void) {
+    return vclock_on ? 1 : 0;
+}
+
+int virtual_clock_is_registered(void) {
+    return (vclock_on && vclock_self >= 0) ? 1 : 0;
+}
+
+// Add a thread that is ready to run once the current thread blocks
+int virtual_clock_register_thread(int priority) {
+    pthread_mutex_lock(&vclock_mutex);
+    vthread t = {priority, VTHREAD_READY, VIRTUAL_CLOCK_FOREVER, NULL};
+    vclock_threads.push_back(t);
+    int id = (int)vclock_threads.size() - 1;
+    pthread_mutex_unlock(&vclock_mutex);
+
+    return id;
+}
+
+// Wait for our turn before running the thread function
+void virtual_clock_enter_thread(int id) {
+    pthread_mutex_lock(&vclock_mutex);
+    vclock_self = id;
+    while (vclock_current != id) {
+        pthread_cond_wait(&vclock_cond, &vclock_mutex);
+    }
+    pthread_mutex_unlock(&vclock_mutex);
+}
+
+// Thread function returned: let the next thread run
+void virtual_clock_exit_thread(void) {
+    pthread_mutex_lock(&vclock_mutex);
+    vclock_threads[vclock_self].state = VTHREAD_DONE;
+    vclock_schedule();
+    pthread_mutex_unlock(&vclock_mutex);
+    vclock_self = -1;
+}
+
+// Block until ready() or the deadline, while the other threads run
+bool virtual_clock_block_until(const std::function<bool()> &ready,
+                                unsigned long long deadline_us) {
+    bool ret;
+
+    pthread_mutex_lock(&vclock_mutex);
+    if (vclock_self < 0) {
+
+        // Threads unknown to the scheduler can only wait for the deadline
+        while ((vclock_now_us < deadline_us) && !(ready && ready())) {
+            pthread_cond_wait(&vclock_cond, &vclock_mutex);
+        }
+    } else {
+        vthread &self = vclock_threads[vclock_self];
+        self.state = VTHREAD_BLOCKED;
+        self.deadline_us = deadline_us;
+        self.ready = &ready;
+        vclock_schedule();
+        while (vclock_current != vclock_self) {
+            pthread_cond_wait(&vclock_cond, &vclock_mutex);
+        }
+        vclock_threads[vclock_self].ready = NULL;
+    }
+    ret = ready ? ready() : false;
+    pthread_mutex_unlock(&vclock_mutex);
+
+    return ret;
+}
+
+/*******************************************************************************
+ * Arduino functions
+ */
+
+// Sleep until CLOCK_MONOTONIC has advanced by the given number of microseconds.
+// The deadline is absolute, so the thread sleeps once in the kernel instead of
+// waking up to poll the clock, and signals do not stretch the delay.
+static void sleep_monotonic_us(unsigned long us) {
+    struct timespec deadline;
+    if (clock_gettime(CLOCK_MONOTONIC, &deadline) == -1) {
+        return;
+    }
+    deadline.tv_sec += us / 1000000;
+    deadline.tv_nsec += (us % 1000000) * 1000;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR);
+}
+
 // Sleeps the program by the number of milliseconds specified
 // Note: Linux is NOT (by default) a real-time OS. Delay is best effort.
 void delay(unsigned long ms) {
-    struct timespec req, rem;
-    req.tv_sec = 0;
-    req.tv_nsec = 500000;
-
-    // Wake up every half millisecond to check timer
-    unsigned long t_start = millis();
-    while (millis() - t_start < ms) {
-        nanosleep(&req, &rem);
-    }
+    delayMicroseconds(ms * 1000);
 }
 
 // Sleeps the program by the number of microseconds specified
 // Note: Linux is NOT (by default) a real-time OS. Delay is best effort.
 void delayMicroseconds(unsigned long us) {
-    struct timespec req, rem;
-    req.tv_sec = 0;
-    req.tv_nsec = 500;
-
-    // Wake up every half microsecond to check timer
-    unsigned long t_start = micros();
-    while (micros() - t_start < us) {
-        nanosleep(&req, &rem);
+    if (vclock_on) {
+        virtual_clock_block_until(std::function<bool()>(), vclock_now_us + us);
+    } else {
+        sleep_monotonic_us(us);
     }
 }
 
 // Return elapsed time in microseconds
 unsigned long micros(void) {
+    if (vclock_on) {
+        return vclock_now_us;
+    }
+
     struct timespec time_now;
     if (clock_gettime(CLOCK_MONOTONIC, &time_now) == -1) {
         return 0;
@@ -44,6 +235,10 @@ unsigned long micros(void) {
 
 // Return elapsed time in milliseconds
 unsigned long millis(void) {
+    if (vclock_on) {
+        return vclock_now_us / 1000;
+    }
+
     struct timespec time_now;
     if (clock_gettime(CLOCK_MONOTONIC, &time_now) == -1) {
         return 0;
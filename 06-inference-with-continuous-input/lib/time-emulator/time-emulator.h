@@ -33,8 +33,44 @@ void delayMicroseconds(unsigned long us);
 unsigned long micros(void);
 unsigned long millis(void);
 
+// Switch to the virtual clock: time starts at 0 and only advances when every
+// emulated thread is blocked (it jumps to the next deadline), and only one
+// emulated thread runs at a time. Replays run at CPU speed and are
+// reproducible. Call from the main thread before starting any threads; the
+// calling thread is registered with the scheduler.
+void virtual_clock_enable(void);
+int virtual_clock_enabled(void);
+
 #ifdef __cplusplus
 }
 #endif
 
+#ifdef __cplusplus
+#include <functional>
+
+// Deadline for threads that block without timeout
+#define VIRTUAL_CLOCK_FOREVER   0xFFFFFFFFFFFFFFFFULL
+
+// Scheduler hooks for the RTOS emulator (virtual clock only)
+
+// Register a new thread (called by the thread that starts it). Threads with a
+// higher priority run first when several are ready. Returns the thread id.
+int virtual_clock_register_thread(int priority);
+
+// Called first in the new thread: wait until the scheduler runs it
+void virtual_clock_enter_thread(int id);
+
+// Called last in the thread: hand the CPU to the next thread
+void virtual_clock_exit_thread(void);
+
+// Is the calling thread registered with the scheduler?
+int virtual_clock_is_registered(void);
+
+// Block the calling thread until ready() returns true (evaluated by the
+// scheduler while no other thread runs) or the virtual clock reaches
+// deadline_us. Returns the result of ready() on wake up.
+bool virtual_clock_block_until(const std::function<bool()> &ready,
+                                unsigned long long deadline_us);
+#endif // __cplusplus
+
 #endif // TIME_EMULATOR_H
\ No newline at end of file
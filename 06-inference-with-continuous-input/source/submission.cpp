@@ -11,12 +11,17 @@
     #include <Arduino_LSM9DS1.h>
     #include <magic-wand-capstone_inferencing.h>
 #else
-    #include <thread>
     #include "time-emulator.h"
+    #include "rtos-emulator.h"
     #include "imu-emulator.h"
     #include "edge-impulse-sdk/classifier/ei_run_classifier.h"
 #endif
 
+// Lock-free ring buffer between the sampling and inference threads (on
+// Arduino, copy spsc-ring-buffer.h into the sketch folder)
+#include <atomic>
+#include "spsc-ring-buffer.h"
+
 // Settings
 #define LED_R_PIN           22        // Red LED pin
 
@@ -32,10 +37,17 @@
 // Define the number of times inference happens each full window (1 second)
 #define SLICES_PER_WINDOW   4                           // Inferences per sec
 
-// Raw buffer (half of the double buffer) should be big enough for 1 slice
+// Raw buffer (one slot of the ring buffer) should be big enough for 1 slice
 // This is also the "number of readings per slice"
 #define RAW_BUF_SIZE        (NUM_CHANNELS * NUM_READINGS) / SLICES_PER_WINDOW
 
+// Number of slices the sampling thread can get ahead of the inference thread
+#define RAW_RING_SLICES     4
+
+// Event flags that wake up the inference thread
+#define SLICE_READY_FLAG    0x01                        // Slice committed
+#define STOP_FLAG           0x02                        // Threads stopping
+
 // Function declarations
 static int get_signal_data(size_t offset, size_t length, float *out_ptr);
 void do_sampling();
@@ -45,13 +57,23 @@ void do_inference();
 static const float means[] = {0.4869, -0.6364, 8.329, -0.1513, 4.631, -9.8836};
 static const float std_devs[] = {3.062, 7.2209, 6.9951, 61.3324, 104.1638, 108.3149};
 
-// Double buffer (used to capture raw samples from sensor)
-static float raw_buf_0[RAW_BUF_SIZE];
-static float raw_buf_1[RAW_BUF_SIZE];
+// One slice of raw samples from the sensor, with how long it took to sample
+// (since the previous slice) and the largest deviation from the sampling
+// period between two samples
+typedef struct {
+    float samples[RAW_BUF_SIZE];
+    unsigned long sampling_us;
+    unsigned long jitter_us;
+} raw_slice_t;
+
+// Ring buffer of raw slices (filled by the sampling thread, drained by the
+// inference thread) and the slot currently being written
+static SpscRingBuffer<raw_slice_t, RAW_RING_SLICES> raw_ring;
 static float *raw_buf_wr;
-static float *raw_buf_rd;
 static int raw_buf_count = 0;
-static bool raw_buf_ready = false;
+
+// Inference thread sleeps on these until the sampling thread notifies it
+static rtos::EventFlags inference_flags;
 
 // Buffer that contains a full window for inference. Note that this is now a 
 // ring buffer where older samples are overwritten!
@@ -62,16 +84,11 @@ static int input_buf_slice = 0;
 static signal_t sig;
 
 // Handles to threads
-#if ARDUINO
-    static rtos::Thread thread_sampling(osPriorityHigh);
-    static rtos::Thread thread_inference(osPriorityLow);
-#else
-    static std::thread thread_sampling;
-    static std::thread thread_inference;
-#endif
+static rtos::Thread thread_sampling(osPriorityHigh);
+static rtos::Thread thread_inference(osPriorityLow);
 
 // Global flag that controls the threads
-static volatile bool running = true;
+static std::atomic<bool> running(true);
 
 /*******************************************************************************
  * Functions
@@ -81,8 +98,10 @@ static volatile bool running = true;
 // Note that we must now start at the correct slice in the ring buffer.
 static int get_signal_data(size_t offset, size_t length, float *out_ptr) {
 
-    // Find where to start reading from the ring buffer
-    size_t idx = offset + (input_buf_slice * RAW_BUF_SIZE);
+    // Find where to start reading from the ring buffer (the SDK may read the
+    // window in several chunks, so offset can be anywhere in the window)
+    size_t idx = (offset + (input_buf_slice * RAW_BUF_SIZE)) %
+                    (NUM_CHANNELS * NUM_READINGS);
 
     // Copy the elements in the ring buffer to the output buffer
     for (size_t i = 0; i < length; i++) {
@@ -93,7 +112,7 @@ static int get_signal_data(size_t offset, size_t length, float *out_ptr) {
         // Increment and wrap the ring buffer pointer
         idx++;
         if (idx >= (NUM_CHANNELS * NUM_READINGS)) {
-            idx = offset;
+            idx = 0;
         }
     }
 
@@ -115,6 +134,7 @@ static int get_signal_data(size_t offset, size_t length, float *out_ptr) {
 // Call this if you want to stop the threads
 void stop_threads() {
     running = false;
+    inference_flags.set(STOP_FLAG);
     thread_sampling.join();
     thread_inference.join();
 }
@@ -127,12 +147,20 @@ void stop_threads() {
 void do_sampling() {
     
     unsigned long time_start, time_target, time_actual, to_sleep;
+    unsigned long sample_us, prev_sample_us, slice_start_us, jitter_us;
     float acc_x, acc_y, acc_z, gyr_x, gyr_y, gyr_z;
     static bool led_state = false;
   
+    // Get the first slot of the ring buffer to write to
+    raw_slice_t *slice_wr = raw_ring.beginWrite();
+    raw_buf_wr = slice_wr->samples;
+    slice_wr->jitter_us = 0;
+
     // Initialize times
     time_start = millis();
     time_target = 0;
+    slice_start_us = micros();
+    prev_sample_us = slice_start_us;
 
     // Run this thread forever
     while (running) {
@@ -147,11 +175,7 @@ void do_sampling() {
         }
     
         // Sleep before sampling
-#if ARDUINO
         rtos::ThisThread::sleep_for(to_sleep);
-#else
-        std::this_thread::sleep_for(std::chrono::milliseconds(to_sleep));
-#endif
     
         // Toggle LED to show that sampling is happening
 #if ARDUINO
@@ -160,8 +184,21 @@ void do_sampling() {
 #endif
         
         // Get raw readings from the sensors
+        sample_us = micros();
         IMU.readAcceleration(acc_x, acc_y, acc_z);
         IMU.readGyroscope(gyr_x, gyr_y, gyr_z);
+
+        // Keep track of the largest deviation from the sampling period
+        if (raw_buf_count > 0) {
+            jitter_us = sample_us - prev_sample_us;
+            jitter_us = (jitter_us > SAMPLING_PERIOD_US) ?
+                        (jitter_us - SAMPLING_PERIOD_US) :
+                        (SAMPLING_PERIOD_US - jitter_us);
+            if (jitter_us > slice_wr->jitter_us) {
+                slice_wr->jitter_us = jitter_us;
+            }
+        }
+        prev_sample_us = sample_us;
     
         // Store the raw readings in the buffer (use the write pointer)
         raw_buf_wr[raw_buf_count + 0] = acc_x;
@@ -174,17 +211,17 @@ void do_sampling() {
         // Increment the counter by the number of readings you stored
         raw_buf_count += NUM_CHANNELS;
     
-        // Swap pointers if buffer is full
+        // Hand the slice to the inference thread if it is full and move on
+        // to the next slot (overruns are counted by the ring buffer)
         if (raw_buf_count >= RAW_BUF_SIZE) {
             raw_buf_count = 0;
-            raw_buf_ready = true;
-            if (raw_buf_wr == &raw_buf_0[0]) {
-                raw_buf_wr = raw_buf_1;
-                raw_buf_rd = raw_buf_0;
-            } else {
-                raw_buf_wr = raw_buf_0;
-                raw_buf_rd = raw_buf_1;
-            }
+            slice_wr->sampling_us = sample_us - slice_start_us;
+            slice_start_us = sample_us;
+            raw_ring.commitWrite();
+            slice_wr = raw_ring.beginWrite();
+            raw_buf_wr = slice_wr->samples;
+            slice_wr->jitter_us = 0;
+            inference_flags.set(SLICE_READY_FLAG);
         }
     }
 }
@@ -196,24 +233,21 @@ void do_inference() {
     ei_impulse_result_t result; // Used to store inference output
     EI_IMPULSE_ERROR res;       // Return code from inference
     int start_slice_offset;     // Index of the current slice in input_buf
+    uint32_t overruns_reported = 0;
 
     // Do inference forever
     while (running) {
     
-        // If buffer is already full, it has been overrun
-        if (raw_buf_ready) {
-            ei_printf("ERROR: Buffer overrun\r\n");
+        // Sleep until the sampling thread commits a slice (or we are asked
+        // to stop). Flags stay set until we wait, so no wakeup is missed.
+        const raw_slice_t *slice = raw_ring.front();
+        if (slice == NULL) {
+            inference_flags.wait_any(SLICE_READY_FLAG | STOP_FLAG);
             continue;
         }
-    
-        // Wait until buffer is full
-        while (!raw_buf_ready) {
-            delay(10);
-            if (!running) {
-                break;
-            }
-        }
-        raw_buf_ready = false;
+        const float *raw_buf_rd = slice->samples;
+        unsigned long sampling_us = slice->sampling_us;
+        unsigned long sampling_jitter_us = slice->jitter_us;
     
         // Compute the index of the current slice for input_buf
         start_slice_offset = RAW_BUF_SIZE * input_buf_slice;
@@ -251,6 +285,17 @@ void do_inference() {
             input_buf[start_slice_offset + (NUM_CHANNELS * i) + 4] = gyr_y;
             input_buf[start_slice_offset + (NUM_CHANNELS * i) + 5] = gyr_z;
         }
+
+        // Give the slot back to the sampling thread
+        raw_ring.pop();
+
+        // Report slices the sampling thread had to drop since last time
+        uint32_t overruns = raw_ring.overruns();
+        if (overruns != overruns_reported) {
+            ei_printf("ERROR: Buffer overrun (%lu slices dropped)\r\n",
+                        (unsigned long)(overruns - overruns_reported));
+            overruns_reported = overruns;
+        }
     
         // Increment and wrap slice counter
         input_buf_slice++;
@@ -260,6 +305,11 @@ void do_inference() {
     
         // Call run_classifier() to perform preprocessing and inferece
         res = run_classifier(&sig, &result, false);
+
+        // Add how long it took to sample the slice
+        result.timing.sampling_us = sampling_us;
+        result.timing.sampling = (int)(sampling_us / 1000);
+        result.timing.sampling_jitter_us = sampling_jitter_us;
     
         // Find the label with the highest classification value
         float max_val = 0.0;
@@ -273,10 +323,18 @@ void do_inference() {
     
         // Print return code and how long it took to perform inference
         ei_printf("run_classifier returned: %d\r\n", res);
-        ei_printf("Timing: DSP %d ms, inference %d ms, anomaly %d ms\r\n", 
+        ei_printf("Timing: DSP %d ms, inference %d ms, anomaly %d ms, "
+                "sampling %d ms (jitter %ld us), DSP %ld ns, quantize %ld ns, "
+                "invoke %ld ns, postprocess %ld ns\r\n", 
                 result.timing.dsp, 
                 result.timing.classification, 
-                result.timing.anomaly);
+                result.timing.anomaly,
+                result.timing.sampling,
+                (long)result.timing.sampling_jitter_us,
+                (long)result.timing.dsp_ns,
+                (long)result.timing.quantize_ns,
+                (long)result.timing.invoke_ns,
+                (long)result.timing.postprocess_ns);
     
         // Print inference/prediction results
         ei_printf("Predictions:\r\n");
@@ -319,10 +377,6 @@ void setup() {
     Serial.begin(115200);
 #endif
 
-    // Initialize double buffer pointers
-    raw_buf_wr = raw_buf_0;
-    raw_buf_rd = raw_buf_1;
-
     // Clear ring buffer
     memset(input_buf, 0, (NUM_CHANNELS * NUM_READINGS) * sizeof(float));
 
@@ -337,21 +391,11 @@ void setup() {
     sig.get_data = &get_signal_data;
 
     // Start threads
-#if ARDUINO
-    thread_sampling.start(mbed::callback(&do_sampling));
-    thread_inference.start(mbed::callback(&do_inference));
-#else
-    thread_sampling = std::thread(do_sampling);
-    thread_inference = std::thread(do_inference);
-#endif
+    thread_sampling.start(do_sampling);
+    thread_inference.start(do_inference);
 }
 
 // Sleep indefinitely to let the threads do the work
 void loop() {
-
-#if ARDUINO
     rtos::ThisThread::sleep_for(100);
-#else
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-#endif
 }
\ No newline at end of file
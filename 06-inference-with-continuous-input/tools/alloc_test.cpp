@@ -0,0 +1,200 @@
+/**
+ * Steady-state allocation test
+ *
+ * Checks that an inference does not touch the heap once the model is
+ * prepared: binds a DSP scratch arena of EI_CLASSIFIER_DSP_ARENA_SIZE bytes
+ * (see ei_dsp_arena_bind()), opens the default EON session and runs
+ * run_classifier() and run_classifier_continuous() over the windows of a
+ * dataset (by default the standardized test set). The first pass over the
+ * dataset is a warm-up. During the passes after it, every call of
+ * ei_malloc() or ei_calloc() (which this test overrides to count them) and
+ * every allocation that did not fit in the arena fails the test.
+ *
+ * Usage: alloc_test.out [--passes N] [dataset directory or pack]
+ *
+ *   --passes N    Passes over the dataset after the warm-up (default: 2)
+ *
+ * Exits with 0 if no call allocated, 1 otherwise.
+ *
+ * License: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "dataset.h"
+
+// Default dataset, relative to the lab directory
+#define DEFAULT_DATASET_DIR     "../Datasets/magic-wand-standardized/testing"
+
+// Passes over the dataset after the warm-up
+#define DEFAULT_PASSES          2
+
+// Allocations made through the SDK's allocation hooks
+static size_t alloc_count = 0;
+static size_t alloc_bytes = 0;
+
+#if EIDSP_SCRATCH_ARENA
+// DSP scratch arena of the test thread
+static uint8_t arena_buffer[EI_CLASSIFIER_DSP_ARENA_SIZE + EI_DSP_ARENA_ALIGNMENT];
+static ei_dsp_arena_t arena;
+#endif // EIDSP_SCRATCH_ARENA
+
+/*******************************************************************************
+ * Allocation hooks (replace the weak ones of the porting layer)
+ */
+
+void *ei_malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return malloc(size);
+}
+
+void *ei_calloc(size_t nitems, size_t size) {
+    alloc_count++;
+    alloc_bytes += nitems * size;
+    return calloc(nitems, size);
+}
+
+void ei_free(void *ptr) {
+    free(ptr);
+}
+
+/*******************************************************************************
+ * Functions
+ */
+
+// run_classifier() over every window, false if a call failed
+static bool run_windows(const Dataset& dataset) {
+    for (const Recording& recording : dataset.recordings) {
+        signal_t signal;
+        numpy::signal_from_buffer(recording.window(), EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &signal);
+
+        ei_impulse_result_t result;
+        EI_IMPULSE_ERROR res = run_classifier(&signal, &result, false);
+        if (res != EI_IMPULSE_OK) {
+            printf("ERROR: run_classifier() failed on %s (%d)\r\n", recording.name.c_str(), res);
+            return false;
+        }
+    }
+    return true;
+}
+
+// run_classifier_continuous() over the slices of every window, false if a
+// call failed
+static bool run_slices(const Dataset& dataset) {
+    const size_t slice_values = EI_CLASSIFIER_SLICE_SIZE * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+
+    for (const Recording& recording : dataset.recordings) {
+        for (size_t offset = 0; offset + slice_values <= EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+                offset += slice_values) {
+            signal_t signal;
+            numpy::signal_from_buffer(recording.window() + offset, slice_values, &signal);
+
+            ei_impulse_result_t result;
+            EI_IMPULSE_ERROR res = run_classifier_continuous(&signal, &result, false);
+            if (res != EI_IMPULSE_OK) {
+                printf("ERROR: run_classifier_continuous() failed on %s (%d)\r\n",
+                    recording.name.c_str(), res);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Run one of the passes above after the warm-up, false if it failed or
+// allocated
+static bool check_pass(const char *name, bool (*pass)(const Dataset&), const Dataset& dataset,
+        int passes) {
+    // Warm-up, prepares the model and fills the caches
+    if (!pass(dataset)) {
+        return false;
+    }
+
+    alloc_count = 0;
+    alloc_bytes = 0;
+#if EIDSP_SCRATCH_ARENA
+    arena.failed = 0;
+#endif
+    for (int ix = 0; ix < passes; ix++) {
+        if (!pass(dataset)) {
+            return false;
+        }
+    }
+
+    size_t arena_failed = 0;
+#if EIDSP_SCRATCH_ARENA
+    arena_failed = arena.failed;
+#endif
+    bool ok = alloc_count == 0 && arena_failed == 0;
+    printf("%-28s %s (%u allocations, %u bytes, %u did not fit in the arena)\r\n", name,
+        ok ? "OK" : "FAILED", (unsigned int)alloc_count, (unsigned int)alloc_bytes,
+        (unsigned int)arena_failed);
+    return ok;
+}
+
+/*******************************************************************************
+ * Main
+ */
+
+int main(int argc, char **argv) {
+
+    std::string path = DEFAULT_DATASET_DIR;
+    int passes = DEFAULT_PASSES;
+
+    // Parse arguments
+    for (int ix = 1; ix < argc; ix++) {
+        if (strcmp(argv[ix], "--passes") == 0 && ix + 1 < argc) {
+            passes = atoi(argv[++ix]);
+        } else if (argv[ix][0] == '-') {
+            printf("ERROR: Unknown option %s\r\n", argv[ix]);
+            return 1;
+        } else {
+            path = argv[ix];
+        }
+    }
+    if (passes < 1) {
+        passes = 1;
+    }
+
+#if !EIDSP_SCRATCH_ARENA
+    printf("ERROR: The allocation test needs EIDSP_SCRATCH_ARENA=1\r\n");
+    return 1;
+#else
+    Dataset dataset;
+    if (!load_dataset(path, dataset)) {
+        return 1;
+    }
+    if (dataset.recordings.empty()) {
+        printf("ERROR: No recordings in %s\r\n", path.c_str());
+        return 1;
+    }
+
+    if (ei_eon_session_init() != EI_IMPULSE_OK) {
+        printf("ERROR: Could not open the default session\r\n");
+        return 1;
+    }
+
+    ei_dsp_arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+    ei_dsp_arena_bind(&arena);
+
+    printf("Steady-state allocations over %u windows, %d passes (arena: %u bytes)\r\n",
+        (unsigned int)dataset.recordings.size(), passes, (unsigned int)EI_CLASSIFIER_DSP_ARENA_SIZE);
+
+    bool ok = check_pass("run_classifier", run_windows, dataset, passes);
+
+    run_classifier_init();
+    ok = check_pass("run_classifier_continuous", run_slices, dataset, passes) && ok;
+    run_classifier_deinit();
+
+    ei_dsp_arena_bind(NULL);
+    ei_eon_session_deinit();
+
+    return ok ? 0 : 1;
+#endif // EIDSP_SCRATCH_ARENA
+}
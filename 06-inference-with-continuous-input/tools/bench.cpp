@@ -0,0 +1,371 @@
+/**
+ * Inference benchmark
+ *
+ * Loads every recording in a dataset directory or pack file once (by default
+ * the standardized test set) and runs run_classifier() over the windows in a
+ * tight loop. Reports the p50/p90/p99/max latency of one call, the time spent
+ * in DSP and in the model invoke, and the number of windows per second.
+ *
+ * The benchmark runs twice: single-threaded through run_classifier() on the
+ * default EON session, then with N threads that each run
+ * run_classifier_session() on their own session.
+ *
+ * Usage: bench.out [--threads N] [--passes N] [--json] [dataset directory or pack]
+ *
+ *   --threads N   Threads for the multi-threaded run (default: all cores,
+ *                 1 skips the multi-threaded run)
+ *   --passes N    Passes over the dataset per thread (default: 50)
+ *   --json        Print the results as JSON instead of a table
+ *
+ * License: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "dataset.h"
+
+// Default dataset, relative to the lab directory
+#define DEFAULT_DATASET_DIR     "../Datasets/magic-wand-standardized/testing"
+
+// Passes over the dataset per thread
+#define DEFAULT_PASSES          50
+
+// Timings of every call in one run
+struct Samples {
+    std::vector<int64_t> latency_ns;
+    std::vector<int64_t> dsp_ns;
+    std::vector<int64_t> invoke_ns;
+};
+
+// Distribution of one timing
+struct Summary {
+    double mean;
+    int64_t p50;
+    int64_t p90;
+    int64_t p99;
+    int64_t max;
+};
+
+// Results of one run
+struct RunResult {
+    int threads;
+    size_t inferences;
+    int64_t wall_ns;
+    Summary latency;
+    Summary dsp;
+    Summary invoke;
+};
+
+/*******************************************************************************
+ * Functions
+ */
+
+// Nearest-rank percentile of sorted values
+static int64_t percentile(const std::vector<int64_t>& sorted, int pct) {
+    size_t rank = (sorted.size() * pct + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Summarize a set of timings
+static Summary summarize(std::vector<int64_t> values) {
+
+    Summary summary = { };
+    if (values.empty()) {
+        return summary;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    double sum = 0.0;
+    for (int64_t value : values) {
+        sum += value;
+    }
+
+    summary.mean = sum / values.size();
+    summary.p50 = percentile(values, 50);
+    summary.p90 = percentile(values, 90);
+    summary.p99 = percentile(values, 99);
+    summary.max = values.back();
+
+    return summary;
+}
+
+// Time one call to the classifier and record its timings. A null session
+// runs run_classifier() on the default session.
+static bool time_inference(ei_eon_session_t *session, const Recording& recording, Samples& samples) {
+
+    signal_t sig;
+    ei_impulse_result_t result;
+
+    numpy::signal_from_buffer(recording.window(), EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &sig);
+
+    int64_t start_ns = ei_read_timer_ns();
+    EI_IMPULSE_ERROR res = session ?
+        run_classifier_session(session, &sig, &result, false) :
+        run_classifier(&sig, &result, false);
+    int64_t latency_ns = ei_read_timer_ns() - start_ns;
+
+    if (res != EI_IMPULSE_OK) {
+        printf("ERROR: run_classifier returned %d for %s\r\n", res, recording.name.c_str());
+        return false;
+    }
+
+    samples.latency_ns.push_back(latency_ns);
+    samples.dsp_ns.push_back(result.timing.dsp_ns);
+    samples.invoke_ns.push_back(result.timing.invoke_ns);
+
+    return true;
+}
+
+// Run passes over the recordings (one warm-up pass is not recorded)
+static bool run_passes(ei_eon_session_t *session, const std::vector<Recording>& recordings,
+        int passes, Samples& samples) {
+
+    Samples warmup;
+    for (const Recording& recording : recordings) {
+        if (!time_inference(session, recording, warmup)) {
+            return false;
+        }
+    }
+
+    samples.latency_ns.reserve(passes * recordings.size());
+    samples.dsp_ns.reserve(passes * recordings.size());
+    samples.invoke_ns.reserve(passes * recordings.size());
+
+    for (int pass = 0; pass < passes; pass++) {
+        for (const Recording& recording : recordings) {
+            if (!time_inference(session, recording, samples)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Merge the timings of all threads into one result
+static RunResult make_result(int threads, int64_t wall_ns, const std::vector<Samples>& per_thread) {
+
+    Samples all;
+    for (const Samples& samples : per_thread) {
+        all.latency_ns.insert(all.latency_ns.end(), samples.latency_ns.begin(), samples.latency_ns.end());
+        all.dsp_ns.insert(all.dsp_ns.end(), samples.dsp_ns.begin(), samples.dsp_ns.end());
+        all.invoke_ns.insert(all.invoke_ns.end(), samples.invoke_ns.begin(), samples.invoke_ns.end());
+    }
+
+    RunResult result;
+    result.threads = threads;
+    result.inferences = all.latency_ns.size();
+    result.wall_ns = wall_ns;
+    result.latency = summarize(all.latency_ns);
+    result.dsp = summarize(all.dsp_ns);
+    result.invoke = summarize(all.invoke_ns);
+
+    return result;
+}
+
+// Single-threaded run through run_classifier() on the default session
+static bool run_single(const std::vector<Recording>& recordings, int passes, RunResult& result) {
+
+    std::vector<Samples> samples(1);
+
+    if (ei_eon_session_init() != EI_IMPULSE_OK) {
+        printf("ERROR: Could not open the default session\r\n");
+        return false;
+    }
+
+    int64_t start_ns = ei_read_timer_ns();
+    bool ok = run_passes(NULL, recordings, passes, samples[0]);
+    int64_t wall_ns = ei_read_timer_ns() - start_ns;
+
+    ei_eon_session_deinit();
+
+    result = make_result(1, wall_ns, samples);
+    return ok;
+}
+
+// Multi-threaded run, one session per thread
+static bool run_threaded(const std::vector<Recording>& recordings, int passes, int threads,
+        RunResult& result) {
+
+    std::vector<ei_eon_session_t> sessions(threads);
+    std::vector<Samples> samples(threads);
+    std::vector<char> ok(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (int ix = 0; ix < threads; ix++) {
+        memset(&sessions[ix], 0, sizeof(ei_eon_session_t));
+        if (ei_eon_session_open(&sessions[ix]) != EI_IMPULSE_OK) {
+            printf("ERROR: Could not open session %d\r\n", ix);
+            for (int jx = 0; jx < ix; jx++) {
+                ei_eon_session_close(&sessions[jx]);
+            }
+            return false;
+        }
+    }
+
+    int64_t start_ns = ei_read_timer_ns();
+    for (int ix = 0; ix < threads; ix++) {
+        workers.emplace_back([&, ix]() {
+            ok[ix] = run_passes(&sessions[ix], recordings, passes, samples[ix]);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    int64_t wall_ns = ei_read_timer_ns() - start_ns;
+
+    for (int ix = 0; ix < threads; ix++) {
+        ei_eon_session_close(&sessions[ix]);
+    }
+
+    result = make_result(threads, wall_ns, samples);
+    return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+// Windows per second over the wall time of a run
+static double windows_per_sec(const RunResult& result) {
+    return result.wall_ns > 0 ? result.inferences * 1e9 / result.wall_ns : 0.0;
+}
+
+// Print one timing distribution as a JSON object
+static void print_summary_json(const char *name, const Summary& summary, bool last) {
+    printf("      \"%s\": {\"mean\": %.0f, \"p50\": %lld, \"p90\": %lld, \"p99\": %lld, \"max\": %lld}%s\n",
+        name,
+        summary.mean,
+        (long long)summary.p50,
+        (long long)summary.p90,
+        (long long)summary.p99,
+        (long long)summary.max,
+        last ? "" : ",");
+}
+
+// Print all runs as JSON
+static void print_json(const std::string& dir, size_t windows, int passes,
+        const std::vector<RunResult>& results) {
+
+    printf("{\n");
+    printf("  \"dataset\": \"%s\",\n", dir.c_str());
+    printf("  \"windows\": %u,\n", (unsigned int)windows);
+    printf("  \"passes\": %d,\n", passes);
+    printf("  \"runs\": [\n");
+    for (size_t ix = 0; ix < results.size(); ix++) {
+        const RunResult& result = results[ix];
+        printf("    {\n");
+        printf("      \"threads\": %d,\n", result.threads);
+        printf("      \"inferences\": %u,\n", (unsigned int)result.inferences);
+        printf("      \"wall_ns\": %lld,\n", (long long)result.wall_ns);
+        printf("      \"windows_per_sec\": %.1f,\n", windows_per_sec(result));
+        print_summary_json("latency_ns", result.latency, false);
+        print_summary_json("dsp_ns", result.dsp, false);
+        print_summary_json("invoke_ns", result.invoke, true);
+        printf("    }%s\n", ix + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+// Print one timing distribution as a table row (microseconds)
+static void print_summary_row(const char *name, const Summary& summary) {
+    printf("  %-10s %10.1f %10.1f %10.1f %10.1f %10.1f\r\n",
+        name,
+        summary.mean / 1000.0,
+        summary.p50 / 1000.0,
+        summary.p90 / 1000.0,
+        summary.p99 / 1000.0,
+        summary.max / 1000.0);
+}
+
+// Print all runs as tables
+static void print_table(const std::string& dir, size_t windows, int passes,
+        const std::vector<RunResult>& results) {
+
+    printf("Dataset: %s (%u windows, %d passes)\r\n", dir.c_str(), (unsigned int)windows, passes);
+    for (const RunResult& result : results) {
+        printf("\r\n");
+        printf("%d thread(s): %u inferences in %.3f s, %.1f windows/sec\r\n",
+            result.threads,
+            (unsigned int)result.inferences,
+            result.wall_ns / 1e9,
+            windows_per_sec(result));
+        printf("  %-10s %10s %10s %10s %10s %10s\r\n", "(us)", "mean", "p50", "p90", "p99", "max");
+        print_summary_row("latency", result.latency);
+        print_summary_row("dsp", result.dsp);
+        print_summary_row("invoke", result.invoke);
+    }
+}
+
+/*******************************************************************************
+ * Main
+ */
+
+int main(int argc, char **argv) {
+
+    std::string dir = DEFAULT_DATASET_DIR;
+    int passes = DEFAULT_PASSES;
+    int threads = (int)std::thread::hardware_concurrency();
+    bool json = false;
+
+    // Parse arguments
+    for (int ix = 1; ix < argc; ix++) {
+        if (strcmp(argv[ix], "--threads") == 0 && ix + 1 < argc) {
+            threads = atoi(argv[++ix]);
+        } else if (strcmp(argv[ix], "--passes") == 0 && ix + 1 < argc) {
+            passes = atoi(argv[++ix]);
+        } else if (strcmp(argv[ix], "--json") == 0) {
+            json = true;
+        } else if (argv[ix][0] == '-') {
+            printf("ERROR: Unknown option %s\r\n", argv[ix]);
+            return 1;
+        } else {
+            dir = argv[ix];
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (passes < 1) {
+        passes = 1;
+    }
+
+    // Load every recording once
+    Dataset dataset;
+    if (!load_dataset(dir, dataset)) {
+        return 1;
+    }
+    const std::vector<Recording>& recordings = dataset.recordings;
+    if (recordings.empty()) {
+        printf("ERROR: No recordings in %s\r\n", dir.c_str());
+        return 1;
+    }
+
+    std::vector<RunResult> results;
+    RunResult result;
+
+    if (!run_single(recordings, passes, result)) {
+        return 1;
+    }
+    results.push_back(result);
+
+    if (threads > 1) {
+        if (!run_threaded(recordings, passes, threads, result)) {
+            return 1;
+        }
+        results.push_back(result);
+    }
+
+    if (json) {
+        print_json(dir, recordings.size(), passes, results);
+    } else {
+        print_table(dir, recordings.size(), passes, results);
+    }
+
+    return 0;
+}
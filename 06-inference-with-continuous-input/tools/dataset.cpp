@@ -0,0 +1,139 @@
+/**
+ * Dataset loading for the desktop tools (see dataset.h)
+ *
+ * License: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <dirent.h>
+#include <algorithm>
+#include <exception>
+
+#include "csv.h"
+#include "model-parameters/model_metadata.h"
+#include "dataset.h"
+
+// Number of values in one window of raw readings
+#define WINDOW_SIZE     (EI_CLASSIFIER_RAW_SAMPLE_COUNT * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME)
+
+// Check if a filename ends with .csv
+static bool is_csv_file(const std::string& name) {
+    const std::string ext = ".csv";
+    return name.size() > ext.size() &&
+        name.compare(name.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+// Read one CSV recording into a window of interleaved readings
+static bool load_recording(const std::string& path, std::vector<float>& window) {
+
+    float timestamp, accX, accY, accZ, gyrX, gyrY, gyrZ;
+
+    window.clear();
+    window.reserve(WINDOW_SIZE);
+
+    try {
+        io::CSVReader<7> csv_reader(path);
+        csv_reader.read_header( io::ignore_extra_column,
+                                "timestamp",
+                                "accX",
+                                "accY",
+                                "accZ",
+                                "gyrX",
+                                "gyrY",
+                                "gyrZ");
+
+        // Keep at most one window of readings
+        while (window.size() < WINDOW_SIZE &&
+                csv_reader.read_row(timestamp, accX, accY, accZ, gyrX, gyrY, gyrZ)) {
+            const float reading[] = {accX, accY, accZ, gyrX, gyrY, gyrZ};
+            window.insert(window.end(), reading, reading + EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
+        }
+    } catch (const std::exception& e) {
+        printf("ERROR: %s\r\n", e.what());
+        return false;
+    }
+
+    // Short recordings are padded with zeros
+    window.resize(WINDOW_SIZE, 0.0f);
+
+    return true;
+}
+
+std::string label_from_filename(const std::string& name) {
+    return name.substr(0, name.find('.'));
+}
+
+// Load every CSV file in a directory
+static bool load_dataset_dir(const std::string& dir, std::vector<Recording>& recordings) {
+
+    std::vector<std::string> names;
+
+    // List the CSV files in the directory
+    DIR *dp = opendir(dir.c_str());
+    if (!dp) {
+        printf("ERROR: Could not open directory %s\r\n", dir.c_str());
+        return false;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dp)) != NULL) {
+        if (is_csv_file(entry->d_name)) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dp);
+
+    // Sort so that every run sees the recordings in the same order
+    std::sort(names.begin(), names.end());
+
+    for (const std::string& name : names) {
+        Recording recording;
+        recording.name = name;
+        recording.label = label_from_filename(name);
+        recording.mapped = NULL;
+        if (!load_recording(dir + "/" + name, recording.samples)) {
+            return false;
+        }
+        recordings.push_back(std::move(recording));
+    }
+
+    return true;
+}
+
+// Use the recordings of a mapped pack in place
+static bool load_dataset_pack(const std::string& path, Dataset& dataset) {
+
+    if (!dataset.pack.open(path.c_str())) {
+        return false;
+    }
+    if (dataset.pack.channels() != EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME) {
+        printf("ERROR: %s has %u channels, the model expects %d\r\n",
+            path.c_str(), (unsigned int)dataset.pack.channels(), EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
+        return false;
+    }
+
+    for (size_t idx = 0; idx < dataset.pack.size(); idx++) {
+        Recording recording;
+        recording.name = dataset.pack.name(idx);
+        recording.label = dataset.pack.label(idx);
+        recording.mapped = dataset.pack.data(idx);
+
+        // Windows that are too short are copied and padded with zeros
+        size_t length = dataset.pack.rows(idx) * EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+        if (length < WINDOW_SIZE) {
+            recording.samples.assign(recording.mapped, recording.mapped + length);
+            recording.samples.resize(WINDOW_SIZE, 0.0f);
+            recording.mapped = NULL;
+        }
+
+        dataset.recordings.push_back(std::move(recording));
+    }
+
+    return true;
+}
+
+bool load_dataset(const std::string& path, Dataset& dataset) {
+    if (isImuPackFile(path.c_str())) {
+        return load_dataset_pack(path, dataset);
+    }
+    return load_dataset_dir(path, dataset.recordings);
+}
@@ -0,0 +1,53 @@
+/**
+ * Dataset loading for the desktop tools (benchmark and evaluator)
+ *
+ * A dataset is either a directory of CSV recordings with the same columns as
+ * the files in tests/ (timestamp, accX, accY, accZ, gyrX, gyrY, gyrZ) or a
+ * pack file of such recordings (*.pack, see lib/imu-pack/imu-pack.h). Each
+ * recording is one window of EI_CLASSIFIER_RAW_SAMPLE_COUNT interleaved
+ * readings, ready to be passed to run_classifier(). The label of a CSV
+ * recording is its filename up to the first '.' (e.g. alpha.0696.csv is
+ * "alpha"), a pack stores the labels in its index.
+ *
+ * License: Apache-2.0
+ */
+
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <string>
+#include <vector>
+
+#include "imu-pack.h"
+
+// One recording, cut or zero-padded to a full window
+struct Recording {
+    std::string name;
+    std::string label;
+
+    // Window in a mapped pack, or NULL if it is in samples
+    const float *mapped;
+
+    // Window read from a CSV file (or padded from a short pack recording)
+    std::vector<float> samples;
+
+    const float *window() const {
+        return mapped ? mapped : samples.data();
+    }
+};
+
+// Recordings of a dataset. Windows of a pack stay in the mapping, so the
+// dataset must outlive its recordings.
+struct Dataset {
+    std::vector<Recording> recordings;
+    ImuPack pack;
+};
+
+// Load a directory of CSV files (every *.csv file, sorted by name) or a pack
+// file. Returns false and prints the reason if something can't be read.
+bool load_dataset(const std::string& path, Dataset& dataset);
+
+// Label of a recording from its filename (up to the first '.')
+std::string label_from_filename(const std::string& name);
+
+#endif // DATASET_H
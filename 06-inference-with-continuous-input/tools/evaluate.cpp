@@ -0,0 +1,269 @@
+/**
+ * Offline evaluation of the model over labeled datasets
+ *
+ * Loads every recording in the given dataset directories or pack files (by
+ * default the standardized training and testing sets), takes the label of
+ * each recording from its filename prefix (or the pack index) and classifies
+ * all windows in process across a pool of threads. Each thread runs
+ * run_classifier_session() on its own EON session. The prediction is the label with the highest
+ * classification value, as in the ANS: line of the app.
+ *
+ * Reports the accuracy per directory and overall, the confusion matrix, the
+ * recall and precision of every class, the misclassified recordings and the
+ * number of windows classified per second.
+ *
+ * Usage: evaluate.out [--threads N] [dataset directory or pack ...]
+ *
+ * License: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "dataset.h"
+
+// Default datasets, relative to the lab directory
+static const char *default_dataset_dirs[] = {
+    "../Datasets/magic-wand-standardized/training",
+    "../Datasets/magic-wand-standardized/testing"
+};
+
+// Recording with its expected and predicted class
+struct Sample {
+    const Recording *recording;
+    size_t split;
+    int label_idx;
+    int predicted_idx;
+    float score;
+};
+
+/*******************************************************************************
+ * Functions
+ */
+
+// Index of a label in the model's categories (-1 if the model lacks it)
+static int find_label_idx(const std::string& label) {
+    for (int i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+        if (label == ei_classifier_inferencing_categories[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Classify one recording, keep the label with the highest value
+static bool classify(ei_eon_session_t *session, Sample& sample) {
+
+    signal_t sig;
+    ei_impulse_result_t result;
+
+    numpy::signal_from_buffer(sample.recording->window(), EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE, &sig);
+
+    EI_IMPULSE_ERROR res = run_classifier_session(session, &sig, &result, false);
+    if (res != EI_IMPULSE_OK) {
+        printf("ERROR: run_classifier returned %d for %s\r\n", res, sample.recording->name.c_str());
+        return false;
+    }
+
+    sample.predicted_idx = 0;
+    sample.score = result.classification[0].value;
+    for (int i = 1; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+        if (result.classification[i].value > sample.score) {
+            sample.score = result.classification[i].value;
+            sample.predicted_idx = i;
+        }
+    }
+
+    return true;
+}
+
+// Classify every sample on a pool of threads, one EON session per thread.
+// Threads take the next unclassified sample until there are none left.
+static bool classify_all(std::vector<Sample>& samples, int threads) {
+
+    std::atomic<size_t> next_idx(0);
+    std::atomic<bool> ok(true);
+    std::vector<std::thread> workers;
+
+    for (int ix = 0; ix < threads; ix++) {
+        workers.emplace_back([&]() {
+            ei_eon_session_t session;
+            memset(&session, 0, sizeof(session));
+            if (ei_eon_session_open(&session) != EI_IMPULSE_OK) {
+                printf("ERROR: Could not open an EON session\r\n");
+                ok = false;
+                return;
+            }
+
+            size_t idx;
+            while (ok && (idx = next_idx++) < samples.size()) {
+                if (!classify(&session, samples[idx])) {
+                    ok = false;
+                }
+            }
+
+            ei_eon_session_close(&session);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    return ok;
+}
+
+// Print the accuracy of the samples of one split (all splits if split < 0)
+static void print_accuracy(const char *name, const std::vector<Sample>& samples, int split) {
+
+    size_t total = 0;
+    size_t correct = 0;
+    for (const Sample& sample : samples) {
+        if (split < 0 || sample.split == (size_t)split) {
+            total++;
+            correct += (sample.predicted_idx == sample.label_idx);
+        }
+    }
+
+    printf("  %-48s %4u / %4u  %6.2f%%\r\n",
+        name,
+        (unsigned int)correct,
+        (unsigned int)total,
+        total ? 100.0 * correct / total : 0.0);
+}
+
+// Print the confusion matrix (rows: actual, columns: predicted) with the
+// recall and precision of each class
+static void print_confusion_matrix(const std::vector<Sample>& samples) {
+
+    unsigned int matrix[EI_CLASSIFIER_LABEL_COUNT][EI_CLASSIFIER_LABEL_COUNT] = { };
+    for (const Sample& sample : samples) {
+        matrix[sample.label_idx][sample.predicted_idx]++;
+    }
+
+    printf("  %-10s", "");
+    for (int j = 0; j < EI_CLASSIFIER_LABEL_COUNT; j++) {
+        printf(" %8s", ei_classifier_inferencing_categories[j]);
+    }
+    printf("   %8s\r\n", "recall");
+
+    for (int i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+        unsigned int row_total = 0;
+        printf("  %-10s", ei_classifier_inferencing_categories[i]);
+        for (int j = 0; j < EI_CLASSIFIER_LABEL_COUNT; j++) {
+            printf(" %8u", matrix[i][j]);
+            row_total += matrix[i][j];
+        }
+        printf("   %7.2f%%\r\n", row_total ? 100.0 * matrix[i][i] / row_total : 0.0);
+    }
+
+    printf("  %-10s", "precision");
+    for (int j = 0; j < EI_CLASSIFIER_LABEL_COUNT; j++) {
+        unsigned int col_total = 0;
+        for (int i = 0; i < EI_CLASSIFIER_LABEL_COUNT; i++) {
+            col_total += matrix[i][j];
+        }
+        printf(" %7.2f%%", col_total ? 100.0 * matrix[j][j] / col_total : 0.0);
+    }
+    printf("\r\n");
+}
+
+/*******************************************************************************
+ * Main
+ */
+
+int main(int argc, char **argv) {
+
+    std::vector<std::string> dirs;
+    int threads = (int)std::thread::hardware_concurrency();
+
+    // Parse arguments
+    for (int ix = 1; ix < argc; ix++) {
+        if (strcmp(argv[ix], "--threads") == 0 && ix + 1 < argc) {
+            threads = atoi(argv[++ix]);
+        } else if (argv[ix][0] == '-') {
+            printf("ERROR: Unknown option %s\r\n", argv[ix]);
+            return 1;
+        } else {
+            dirs.push_back(argv[ix]);
+        }
+    }
+    if (dirs.empty()) {
+        dirs.assign(default_dataset_dirs, default_dataset_dirs + 2);
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    // Load every recording into memory
+    int64_t load_start_ns = ei_read_timer_ns();
+    std::vector<Dataset> datasets(dirs.size());
+    for (size_t split = 0; split < dirs.size(); split++) {
+        if (!load_dataset(dirs[split], datasets[split])) {
+            return 1;
+        }
+    }
+    int64_t load_ns = ei_read_timer_ns() - load_start_ns;
+
+    // Match the labels to the model's categories
+    std::vector<Sample> samples;
+    for (size_t split = 0; split < dirs.size(); split++) {
+        for (const Recording& recording : datasets[split].recordings) {
+            Sample sample = { &recording, split, find_label_idx(recording.label), -1, 0.0f };
+            if (sample.label_idx < 0) {
+                printf("ERROR: Label %s of %s/%s is not in the model\r\n",
+                    recording.label.c_str(), dirs[split].c_str(), recording.name.c_str());
+                return 1;
+            }
+            samples.push_back(sample);
+        }
+    }
+    if (samples.empty()) {
+        printf("ERROR: No recordings found\r\n");
+        return 1;
+    }
+
+    // Classify everything
+    int64_t start_ns = ei_read_timer_ns();
+    if (!classify_all(samples, threads)) {
+        return 1;
+    }
+    int64_t classify_ns = ei_read_timer_ns() - start_ns;
+
+    printf("Accuracy:\r\n");
+    for (size_t split = 0; split < dirs.size(); split++) {
+        print_accuracy(dirs[split].c_str(), samples, (int)split);
+    }
+    if (dirs.size() > 1) {
+        print_accuracy("total", samples, -1);
+    }
+
+    printf("\r\nConfusion matrix (rows: actual, columns: predicted):\r\n");
+    print_confusion_matrix(samples);
+
+    printf("\r\nMisclassified:\r\n");
+    for (const Sample& sample : samples) {
+        if (sample.predicted_idx != sample.label_idx) {
+            printf("  %s/%s: %s, %f\r\n",
+                dirs[sample.split].c_str(),
+                sample.recording->name.c_str(),
+                ei_classifier_inferencing_categories[sample.predicted_idx],
+                sample.score);
+        }
+    }
+
+    printf("\r\nThroughput: %u windows in %.3f ms on %d thread(s), %.1f windows/sec "
+        "(loading took %.3f ms)\r\n",
+        (unsigned int)samples.size(),
+        classify_ns / 1e6,
+        threads,
+        classify_ns > 0 ? samples.size() * 1e9 / classify_ns : 0.0,
+        load_ns / 1e6);
+
+    return 0;
+}
@@ -0,0 +1,258 @@
+/**
+ * Flatten features equivalence test
+ *
+ * Checks the flatten kernel, ei_dsp_flatten_compute_moments() and
+ * ei_dsp_flatten_write_features(), against the reference path it
+ * replaced: numpy::scale() and numpy::transpose() of the window, then
+ * numpy::mean(), min(), max(), rms(), stdev(), skew() and kurtosis() of
+ * every axis.
+ *
+ * Every window of a dataset (by default the standardized test set) is
+ * read as 1 to 13 interleaved axes, with full and partial windows and
+ * several scales. min and max must be bit-identical. mean, rms and stdev
+ * must be within MAX_MOMENT_DIFF of the reference path, skew and kurtosis
+ * within MAX_SHAPE_DIFF (both relative to values above 1). The reference
+ * path works in float too, so where it is further off than that, the
+ * feature is checked against the same bounds around a float64 computation
+ * of it instead.
+ *
+ * Usage: flatten_test.out [dataset directory or pack]
+ *
+ * Exits with 0 if every feature is within its bound, 1 otherwise.
+ *
+ * License: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+#include "dataset.h"
+
+// Default dataset, relative to the lab directory
+#define DEFAULT_DATASET_DIR     "../Datasets/magic-wand-standardized/testing"
+
+// Largest number of axes a window is read as
+#define MAX_AXES                13
+
+// Bounds on the difference to the reference for mean, rms and stdev, and
+// for skew and kurtosis (relative to values above 1)
+#define MAX_MOMENT_DIFF         1.3e-6f
+#define MAX_SHAPE_DIFF          4e-6f
+
+// Features per axis, in the order they are written
+#define FEATURES_PER_AXIS       7
+
+static const char *feature_names[FEATURES_PER_AXIS] = {
+    "mean", "min", "max", "rms", "stdev", "skew", "kurtosis"
+};
+
+// Scales the windows are checked with
+static const float scales[] = { 1.0f, 0.5f, 2.0f, 0.1f };
+
+// Largest difference to the reference path and to float64 seen for each
+// feature
+static float max_diff[FEATURES_PER_AXIS] = { 0 };
+static float max_exact_diff[FEATURES_PER_AXIS] = { 0 };
+
+// Features that were checked against float64
+static size_t exact_checks = 0;
+
+/*******************************************************************************
+ * Functions
+ */
+
+// Features of an interleaved buffer (rows x axes) with the reference path,
+// one row of FEATURES_PER_AXIS values per axis
+static bool reference_features(const float *buffer, size_t rows, size_t axes, float scale,
+        float *out) {
+    matrix_t input_matrix(rows, axes);
+    if (!input_matrix.buffer) {
+        return false;
+    }
+    memcpy(input_matrix.buffer, buffer, rows * axes * sizeof(float));
+
+    if (numpy::scale(&input_matrix, scale) != EIDSP_OK ||
+            numpy::transpose(&input_matrix) != EIDSP_OK) {
+        return false;
+    }
+
+    for (size_t axis = 0; axis < input_matrix.rows; axis++) {
+        matrix_t row_matrix(1, input_matrix.cols, input_matrix.buffer + (axis * input_matrix.cols));
+        float *f = out + (axis * FEATURES_PER_AXIS);
+
+        matrix_t mean_matrix(1, 1, f + 0);
+        matrix_t min_matrix(1, 1, f + 1);
+        matrix_t max_matrix(1, 1, f + 2);
+        matrix_t rms_matrix(1, 1, f + 3);
+        matrix_t stdev_matrix(1, 1, f + 4);
+        matrix_t skew_matrix(1, 1, f + 5);
+        matrix_t kurtosis_matrix(1, 1, f + 6);
+
+        if (numpy::mean(&row_matrix, &mean_matrix) != EIDSP_OK ||
+                numpy::min(&row_matrix, &min_matrix) != EIDSP_OK ||
+                numpy::max(&row_matrix, &max_matrix) != EIDSP_OK ||
+                numpy::rms(&row_matrix, &rms_matrix) != EIDSP_OK ||
+                numpy::stdev(&row_matrix, &stdev_matrix) != EIDSP_OK ||
+                numpy::skew(&row_matrix, &skew_matrix) != EIDSP_OK ||
+                numpy::kurtosis(&row_matrix, &kurtosis_matrix) != EIDSP_OK) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Same features computed in float64, two passes per axis
+static void exact_features(const float *buffer, size_t rows, size_t axes, float scale,
+        double *out) {
+    for (size_t axis = 0; axis < axes; axis++) {
+        double *f = out + (axis * FEATURES_PER_AXIS);
+        double n = (double)rows;
+        double sum = 0, sum_squares = 0, m2 = 0, m3 = 0, m4 = 0;
+        float min = FLT_MAX, max = -FLT_MAX;
+
+        for (size_t row = 0; row < rows; row++) {
+            float x = buffer[(row * axes) + axis] * scale;
+            if (x < min) min = x;
+            if (x > max) max = x;
+            sum += x;
+            sum_squares += (double)x * x;
+        }
+        double mean = sum / n;
+        for (size_t row = 0; row < rows; row++) {
+            double d = (double)(buffer[(row * axes) + axis] * scale) - mean;
+            m2 += d * d;
+            m3 += d * d * d;
+            m4 += d * d * d * d;
+        }
+        m2 /= n;
+        m3 /= n;
+        m4 /= n;
+
+        f[0] = mean;
+        f[1] = min;
+        f[2] = max;
+        f[3] = sqrt(sum_squares / n);
+        f[4] = sqrt(m2);
+        f[5] = m2 == 0.0 ? 0.0 : m3 / (m2 * sqrt(m2));
+        f[6] = m2 == 0.0 ? -3.0 : (m4 / (m2 * m2)) - 3.0;
+    }
+}
+
+// Same features with the flatten kernel
+static void kernel_features(const float *buffer, size_t rows, size_t axes, float scale,
+        float *out) {
+    ei_dsp_config_flatten_t config = {
+        1, (int)axes, scale, true, true, true, true, true, true, true
+    };
+    ei_dsp_flatten_moments_t moments[MAX_AXES];
+
+    ei_dsp_flatten_compute_moments(buffer, rows, axes, scale, moments);
+    for (size_t axis = 0; axis < axes; axis++) {
+        ei_dsp_flatten_write_features(&config, &moments[axis], out + (axis * FEATURES_PER_AXIS));
+    }
+}
+
+// Compare both paths on one buffer, false if a feature is out of bounds
+static bool check_buffer(const std::string& name, const float *buffer, size_t rows, size_t axes,
+        float scale) {
+    float expected[MAX_AXES * FEATURES_PER_AXIS];
+    float actual[MAX_AXES * FEATURES_PER_AXIS];
+    double exact[MAX_AXES * FEATURES_PER_AXIS];
+
+    if (!reference_features(buffer, rows, axes, scale, expected)) {
+        printf("ERROR: Reference path failed on %s\r\n", name.c_str());
+        return false;
+    }
+    kernel_features(buffer, rows, axes, scale, actual);
+    exact_features(buffer, rows, axes, scale, exact);
+
+    bool ok = true;
+    for (size_t ix = 0; ix < axes * FEATURES_PER_AXIS; ix++) {
+        size_t feature = ix % FEATURES_PER_AXIS;
+        float diff = std::fabs(actual[ix] - expected[ix]);
+        float exact_diff = (float)std::fabs(actual[ix] - exact[ix]);
+        float bound = feature >= 5 ? MAX_SHAPE_DIFF : MAX_MOMENT_DIFF;
+        if (std::fabs(exact[ix]) > 1.0) {
+            bound *= (float)std::fabs(exact[ix]);
+        }
+
+        // min and max only select values, they have to match exactly
+        if (feature == 1 || feature == 2) {
+            bound = 0.0f;
+        }
+
+        if (diff > max_diff[feature]) {
+            max_diff[feature] = diff;
+        }
+        if (exact_diff > max_exact_diff[feature]) {
+            max_exact_diff[feature] = exact_diff;
+        }
+        if (diff <= bound) {
+            continue;
+        }
+
+        exact_checks++;
+        if (!(exact_diff <= bound)) {
+            printf("FAILED: %s, %u rows x %u axes, scale %g: %s of axis %u is %.9g, expected %.9g "
+                "(float64: %.9g)\r\n",
+                name.c_str(), (unsigned int)rows, (unsigned int)axes, scale, feature_names[feature],
+                (unsigned int)(ix / FEATURES_PER_AXIS), actual[ix], expected[ix], exact[ix]);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/*******************************************************************************
+ * Main
+ */
+
+int main(int argc, char **argv) {
+
+    std::string path = argc > 1 ? argv[1] : DEFAULT_DATASET_DIR;
+
+    Dataset dataset;
+    if (!load_dataset(path, dataset)) {
+        return 1;
+    }
+    if (dataset.recordings.empty()) {
+        printf("ERROR: No recordings in %s\r\n", path.c_str());
+        return 1;
+    }
+
+    size_t checked = 0;
+    size_t failed = 0;
+    for (const Recording& recording : dataset.recordings) {
+        for (size_t axes = 1; axes <= MAX_AXES; axes++) {
+            // Full window, half a window and a window that doesn't end on a stripe
+            size_t full_rows = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE / axes;
+            size_t rows_list[] = { full_rows, full_rows / 2, full_rows - 1 };
+
+            for (size_t rows : rows_list) {
+                if (rows == 0) {
+                    continue;
+                }
+                for (float scale : scales) {
+                    if (!check_buffer(recording.name, recording.window(), rows, axes, scale)) {
+                        failed++;
+                    }
+                    checked++;
+                }
+            }
+        }
+    }
+
+    printf("Flatten features of %u windows, %u checks, %u failed, %u features checked against float64\r\n",
+        (unsigned int)dataset.recordings.size(), (unsigned int)checked, (unsigned int)failed,
+        (unsigned int)exact_checks);
+    for (size_t feature = 0; feature < FEATURES_PER_AXIS; feature++) {
+        printf("  %-10s max diff %.3g (float64: %.3g)\r\n", feature_names[feature], max_diff[feature],
+            max_exact_diff[feature]);
+    }
+
+    return failed == 0 ? 0 : 1;
+}
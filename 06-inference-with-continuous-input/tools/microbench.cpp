@@ -0,0 +1,707 @@
+/**
+ * Microbenchmarks of the SDK building blocks
+ *
+ * Times the DSP primitives and inference stages one at a time, on synthetic
+ * inputs generated from a fixed seed:
+ *
+ *   numpy/...      numpy:: matrix ops on a window shaped like the model's
+ *                  (one row per axis)
+ *   rfft/N         numpy::rfft() at every EI_CLASSIFIER_LOAD_FFT_* size
+ *   spectral/...   spectral::feature::spectral_analysis() on the window
+ *   speechpy/...   speechpy::feature::mfcc() and mfe() on 1 s of 16 kHz audio
+ *   dsp/...        extract_raw_features() with the model's raw block config
+ *   nn/...         input quantization of run_nn_inference(), the int8
+ *                  quantization of the raw input path, trained_model_invoke()
+ *                  and run_nn_inference() on the default EON session
+ *   classifier/... run_classifier() end to end
+ *
+ * Every benchmark first runs for the warm-up time (at least one call), which
+ * also estimates its cost and sizes the batch of calls of one repetition so
+ * that it takes at least the minimum time. The batch is then timed for the
+ * given number of repetitions. Ops that destroy their input (log, spectral
+ * analysis) restore it before every call, that copy is included in the time.
+ *
+ * Reports the median and fastest time per op over the repetitions, and the
+ * bytes and number of allocations per op made through ei_malloc() and
+ * ei_calloc(), which this tool overrides to count them.
+ *
+ * With --arena the DSP scratch of the benchmark thread comes from an arena (see
+ * ei_dsp_arena_bind()) and the peak arena use of every benchmark is reported
+ * too. The arena is EI_CLASSIFIER_DSP_ARENA_SIZE bytes unless a size is given.
+ * Benchmarks that need more scratch than the arena holds (with the model's
+ * size, the audio ones) are skipped.
+ * --expect-no-allocs turns the allocation counts into a check: the tool fails
+ * if any benchmark allocated during its timed repetitions or was skipped
+ * (so filter out the ones that don't fit in the arena), e.g.
+ *
+ *   microbench.out --arena --expect-no-allocs --filter classifier/
+ *
+ * The same check over dataset windows, without the timing, is make test (see
+ * tools/alloc_test.cpp).
+ *
+ * Usage: microbench.out [--filter TEXT] [--repeats N] [--warmup-ms N]
+ *                       [--min-time-ms N] [--arena [BYTES]] [--expect-no-allocs]
+ *                       [--list] [--json]
+ *
+ *   --filter TEXT     Only run benchmarks with TEXT in their name
+ *   --repeats N       Timed repetitions per benchmark (default: 5)
+ *   --warmup-ms N     Warm-up time per benchmark (default: 20)
+ *   --min-time-ms N   Minimum time of one repetition (default: 50)
+ *   --arena [BYTES]   Take the DSP scratch from an arena of BYTES bytes
+ *                     (default: EI_CLASSIFIER_DSP_ARENA_SIZE) instead of the
+ *                     heap
+ *   --expect-no-allocs
+ *                     Fail if a benchmark allocates after its warm-up or
+ *                     is skipped
+ *   --list            Print the benchmark names and exit
+ *   --json            Print the results as JSON instead of a table
+ *
+ * License: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "edge-impulse-sdk/classifier/ei_run_classifier.h"
+
+// Defaults of the repetition control
+#define DEFAULT_REPEATS         5
+#define DEFAULT_WARMUP_MS       20
+#define DEFAULT_MIN_TIME_MS     50
+
+// Audio clip for mfcc() and mfe()
+#define AUDIO_FREQUENCY         16000
+#define AUDIO_SAMPLE_COUNT      16000
+
+// Runs the op under test a number of times, false if it failed
+typedef std::function<bool(size_t)> BenchFn;
+
+struct Benchmark {
+    std::string name;
+    BenchFn run;
+};
+
+// Repetition control
+struct Options {
+    int repeats;
+    int64_t warmup_ns;
+    int64_t min_time_ns;
+};
+
+// Results of one benchmark
+struct BenchResult {
+    std::string name;
+    size_t iterations;
+    double ns_per_op;
+    double min_ns_per_op;
+    double bytes_per_op;
+    double allocs_per_op;
+    size_t arena_peak;              // Peak DSP arena use, 0 without --arena
+};
+
+// Inputs shared by the benchmarks
+struct Fixture {
+    std::vector<float> window;      // Interleaved raw window, as run_classifier() gets it
+    std::vector<float> axes;        // Same samples, one row per axis
+    std::vector<float> positive;    // Window made positive, input of log()
+    std::vector<float> work;        // Scratch of the size of the window
+    std::vector<float> out;         // Output of the ops
+    std::vector<float> weights;     // Second operand of dot()
+    std::vector<float> audio;       // Audio clip
+    std::vector<float> fft_in;      // Input of the largest FFT
+    std::vector<float> fft_out;     // Magnitudes of the largest FFT
+    std::vector<float> mfcc_out;    // Output of mfcc()
+    std::vector<float> mfe_out;     // Output of mfe()
+    std::vector<float> mfe_energies;
+    std::vector<int8_t> quantized;  // Quantized model input
+};
+
+// Allocations made through the SDK's allocation hooks
+static size_t alloc_count = 0;
+static size_t alloc_bytes = 0;
+
+#if EIDSP_SCRATCH_ARENA
+// DSP scratch arena of --arena
+static std::vector<uint8_t> arena_buffer;
+static ei_dsp_arena_t arena;
+#endif // EIDSP_SCRATCH_ARENA
+
+/*******************************************************************************
+ * Allocation hooks (replace the weak ones of the porting layer)
+ */
+
+void *ei_malloc(size_t size) {
+    alloc_count++;
+    alloc_bytes += size;
+    return malloc(size);
+}
+
+void *ei_calloc(size_t nitems, size_t size) {
+    alloc_count++;
+    alloc_bytes += nitems * size;
+    return calloc(nitems, size);
+}
+
+void ei_free(void *ptr) {
+    free(ptr);
+}
+
+/*******************************************************************************
+ * Functions
+ */
+
+// Fill a buffer with a fixed pseudo-random sequence in [-amplitude, amplitude]
+static void fill_random(std::vector<float>& values, uint32_t seed, float amplitude) {
+    for (float& value : values) {
+        seed = seed * 1664525u + 1013904223u;
+        value = amplitude * ((float)(seed >> 8) / (float)(1 << 23) - 1.0f);
+    }
+}
+
+// Build the synthetic inputs
+static void make_fixture(Fixture& f) {
+
+    const size_t axes = EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+    const size_t samples = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+
+    // IMU-like window: a slow sine per axis plus noise
+    f.window.resize(EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE);
+    fill_random(f.window, 1, 0.5f);
+    for (size_t ix = 0; ix < samples; ix++) {
+        for (size_t axis = 0; axis < axes; axis++) {
+            f.window[ix * axes + axis] += 4.0f * sinf(0.1f * (axis + 1) * ix);
+        }
+    }
+
+    f.axes.resize(f.window.size());
+    for (size_t ix = 0; ix < samples; ix++) {
+        for (size_t axis = 0; axis < axes; axis++) {
+            f.axes[axis * samples + ix] = f.window[ix * axes + axis];
+        }
+    }
+
+    f.positive = f.axes;
+    for (float& value : f.positive) {
+        value = fabsf(value) + 0.1f;
+    }
+
+    f.work = f.axes;
+    f.out.resize(f.window.size());
+    f.weights.resize(samples * 16);
+    fill_random(f.weights, 2, 1.0f);
+
+    f.audio.resize(AUDIO_SAMPLE_COUNT);
+    fill_random(f.audio, 3, 2000.0f);
+
+    matrix_size_t mfcc_size = speechpy::feature::calculate_mfcc_buffer_size(
+        f.audio.size(), AUDIO_FREQUENCY, 0.02f, 0.01f, 13, 3);
+    f.mfcc_out.resize(mfcc_size.rows * mfcc_size.cols);
+    matrix_size_t mfe_size = speechpy::feature::calculate_mfe_buffer_size(
+        f.audio.size(), AUDIO_FREQUENCY, 0.02f, 0.01f, 40, 3);
+    f.mfe_out.resize(mfe_size.rows * mfe_size.cols);
+    f.mfe_energies.resize(mfe_size.rows);
+
+    f.fft_in.resize(4096);
+    fill_random(f.fft_in, 4, 1.0f);
+    f.fft_out.resize(4096 / 2 + 1);
+
+    f.quantized.resize(EI_CLASSIFIER_NN_INPUT_FRAME_SIZE);
+}
+
+// Register a benchmark of a numpy op on the scratch window (6 x 100). The
+// scratch is reset to the window once per batch, ops that work in place keep
+// it finite.
+static void add_numpy_op(std::vector<Benchmark>& benchmarks, const char *name, Fixture& f,
+        std::function<int(matrix_t *, matrix_t *)> op) {
+
+    benchmarks.push_back({ std::string("numpy/") + name, [&f, op](size_t n) {
+        matrix_t m(EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME, EI_CLASSIFIER_RAW_SAMPLE_COUNT, f.work.data());
+        matrix_t out(EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME, 1, f.out.data());
+        memcpy(f.work.data(), f.axes.data(), f.work.size() * sizeof(float));
+        for (size_t ix = 0; ix < n; ix++) {
+            if (op(&m, &out) != EIDSP_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+}
+
+// Register every benchmark
+static void make_benchmarks(std::vector<Benchmark>& benchmarks, Fixture& f) {
+
+    const size_t axes = EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+    const size_t samples = EI_CLASSIFIER_RAW_SAMPLE_COUNT;
+
+    // Elementwise ops
+    add_numpy_op(benchmarks, "scale", f, [](matrix_t *m, matrix_t *) {
+        return numpy::scale(m, -1.0f);
+    });
+    add_numpy_op(benchmarks, "add", f, [](matrix_t *m, matrix_t *) {
+        return numpy::add(m, 0.5f);
+    });
+    add_numpy_op(benchmarks, "subtract", f, [](matrix_t *m, matrix_t *) {
+        return numpy::subtract(m, 0.5f);
+    });
+    add_numpy_op(benchmarks, "clip", f, [](matrix_t *m, matrix_t *) {
+        return numpy::clip(m, -3.0f, 3.0f);
+    });
+    add_numpy_op(benchmarks, "normalize", f, [](matrix_t *m, matrix_t *) {
+        return numpy::normalize(m);
+    });
+    add_numpy_op(benchmarks, "transpose", f, [](matrix_t *m, matrix_t *) {
+        return numpy::transpose(m);
+    });
+    benchmarks.push_back({ "numpy/log", [&f](size_t n) {
+        matrix_t m(axes, samples, f.work.data());
+        for (size_t ix = 0; ix < n; ix++) {
+            memcpy(f.work.data(), f.positive.data(), f.work.size() * sizeof(float));
+            if (numpy::log(&m) != EIDSP_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+
+    // Reductions over every row
+    add_numpy_op(benchmarks, "sum", f, [](matrix_t *m, matrix_t *out) {
+        out->buffer[0] = numpy::sum(m->buffer, m->rows * m->cols);
+        return (int)EIDSP_OK;
+    });
+    add_numpy_op(benchmarks, "min", f, [](matrix_t *m, matrix_t *out) {
+        return numpy::min(m, out);
+    });
+    add_numpy_op(benchmarks, "max", f, [](matrix_t *m, matrix_t *out) {
+        return numpy::max(m, out);
+    });
+    add_numpy_op(benchmarks, "rms", f, [](matrix_t *m, matrix_t *out) {
+        return numpy::rms(m, out);
+    });
+    add_numpy_op(benchmarks, "mean", f, [](matrix_t *m, matrix_t *out) {
+        return numpy::mean(m, out);
+    });
+    add_numpy_op(benchmarks, "stdev", f, [](matrix_t *m, matrix_t *out) {
+        return numpy::stdev(m, out);
+    });
+    add_numpy_op(benchmarks, "skew", f, [](matrix_t *m, matrix_t *out) {
+        return numpy::skew(m, out);
+    });
+    add_numpy_op(benchmarks, "kurtosis", f, [](matrix_t *m, matrix_t *out) {
+        return numpy::kurtosis(m, out);
+    });
+
+    // Reductions over every column, on the interleaved window (100 x 6)
+    benchmarks.push_back({ "numpy/mean_axis0", [&f](size_t n) {
+        matrix_t m(samples, axes, f.window.data());
+        matrix_t out(axes, 1, f.out.data());
+        for (size_t ix = 0; ix < n; ix++) {
+            if (numpy::mean_axis0(&m, &out) != EIDSP_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+    benchmarks.push_back({ "numpy/std_axis0", [&f](size_t n) {
+        matrix_t m(samples, axes, f.window.data());
+        matrix_t out(axes, 1, f.out.data());
+        for (size_t ix = 0; ix < n; ix++) {
+            if (numpy::std_axis0(&m, &out) != EIDSP_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+
+    // (6 x 100) . (100 x 16)
+    benchmarks.push_back({ "numpy/dot", [&f](size_t n) {
+        matrix_t m1(axes, samples, f.axes.data());
+        matrix_t m2(samples, 16, f.weights.data());
+        matrix_t out(axes, 16, f.out.data());
+        for (size_t ix = 0; ix < n; ix++) {
+            if (numpy::dot(&m1, &m2, &out) != EIDSP_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+
+    // Real FFT (magnitudes) at every size the SDK can load CMSIS-DSP tables for
+    for (size_t n_fft = 32; n_fft <= 4096; n_fft *= 2) {
+        benchmarks.push_back({ "rfft/" + std::to_string(n_fft), [&f, n_fft](size_t n) {
+            for (size_t ix = 0; ix < n; ix++) {
+                if (numpy::rfft(f.fft_in.data(), n_fft, f.fft_out.data(), n_fft / 2 + 1, n_fft) != EIDSP_OK) {
+                    return false;
+                }
+            }
+            return true;
+        } });
+    }
+
+    // Spectral analysis of every axis, as the spectral features block runs it
+    static float edges[] = { 0.1f, 0.5f, 1.0f, 2.0f, 5.0f };
+    const struct {
+        const char *name;
+        spectral::filter_t filter;
+    } spectral_filters[] = {
+        { "spectral/none", spectral::filter_none },
+        { "spectral/lowpass", spectral::filter_lowpass },
+        { "spectral/highpass", spectral::filter_highpass }
+    };
+    for (const auto& config : spectral_filters) {
+        spectral::filter_t filter = config.filter;
+        benchmarks.push_back({ config.name, [&f, filter](size_t n) {
+            matrix_t m(axes, samples, f.work.data());
+            matrix_t edges_matrix(5, 1, edges);
+            matrix_t out(axes, spectral::feature::calculate_spectral_buffer_size(true, 3, 5), f.out.data());
+            for (size_t ix = 0; ix < n; ix++) {
+                memcpy(f.work.data(), f.axes.data(), f.work.size() * sizeof(float));
+                int ret = spectral::feature::spectral_analysis(&out, &m, EI_CLASSIFIER_FREQUENCY, filter,
+                    3.0f, 6, 128, 3, 0.1f, &edges_matrix);
+                if (ret != EIDSP_OK) {
+                    return false;
+                }
+            }
+            return true;
+        } });
+    }
+
+    // MFCC (13 coefficients) and MFE (40 filters), 20 ms frames every 10 ms
+    benchmarks.push_back({ "speechpy/mfcc", [&f](size_t n) {
+        signal_t signal;
+        numpy::signal_from_buffer(f.audio.data(), f.audio.size(), &signal);
+        matrix_t out(f.mfcc_out.size() / 13, 13, f.mfcc_out.data());
+        for (size_t ix = 0; ix < n; ix++) {
+            int ret = speechpy::feature::mfcc(&out, &signal, AUDIO_FREQUENCY, 0.02f, 0.01f,
+                13, 40, 256, 300, 0, true, 3);
+            if (ret != EIDSP_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+    benchmarks.push_back({ "speechpy/mfe", [&f](size_t n) {
+        signal_t signal;
+        numpy::signal_from_buffer(f.audio.data(), f.audio.size(), &signal);
+        matrix_t out(f.mfe_energies.size(), 40, f.mfe_out.data());
+        matrix_t energies(f.mfe_energies.size(), 1, f.mfe_energies.data());
+        for (size_t ix = 0; ix < n; ix++) {
+            int ret = speechpy::feature::mfe(&out, &energies, &signal, AUDIO_FREQUENCY, 0.02f, 0.01f,
+                40, 256, 300, 0, 3);
+            if (ret != EIDSP_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+
+    // Raw features block of the model
+    benchmarks.push_back({ "dsp/extract_raw_features", [&f](size_t n) {
+        signal_t signal;
+        numpy::signal_from_buffer(f.window.data(), f.window.size(), &signal);
+        matrix_t out(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, f.out.data());
+        for (size_t ix = 0; ix < n; ix++) {
+            if (extract_raw_features(&signal, &out, ei_dsp_blocks[0].config, EI_CLASSIFIER_FREQUENCY) != EIDSP_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+
+    // Input quantization of run_nn_inference() on the model's input tensor
+    benchmarks.push_back({ "nn/quantize_input", [&f](size_t n) {
+        matrix_t features(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, f.window.data());
+        for (size_t ix = 0; ix < n; ix++) {
+            inference_tflite_fill_input(eon_default_session.input, &features);
+        }
+        return true;
+    } });
+
+#if (EI_CLASSIFIER_TFLITE_INPUT_QUANTIZED == 1) && !EI_CLASSIFIER_OBJECT_DETECTION
+    // Scale and quantize pass of the raw input path (run_nn_inference_signal())
+    benchmarks.push_back({ "nn/quantize_raw_input", [&f](size_t n) {
+        for (size_t ix = 0; ix < n; ix++) {
+            ei_eon_quantize_input(f.quantized.data(), f.window.data(), f.quantized.size(), 1.0f);
+        }
+        return true;
+    } });
+#endif
+
+    benchmarks.push_back({ "nn/trained_model_invoke", [](size_t n) {
+        for (size_t ix = 0; ix < n; ix++) {
+            if (trained_model_invoke() != kTfLiteOk) {
+                return false;
+            }
+        }
+        return true;
+    } });
+
+    benchmarks.push_back({ "nn/run_nn_inference", [&f](size_t n) {
+        matrix_t features(1, EI_CLASSIFIER_NN_INPUT_FRAME_SIZE, f.window.data());
+        ei_impulse_result_t result;
+        for (size_t ix = 0; ix < n; ix++) {
+            if (run_nn_inference(&features, &result, false) != EI_IMPULSE_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+
+    benchmarks.push_back({ "classifier/run_classifier", [&f](size_t n) {
+        signal_t signal;
+        numpy::signal_from_buffer(f.window.data(), f.window.size(), &signal);
+        ei_impulse_result_t result;
+        for (size_t ix = 0; ix < n; ix++) {
+            if (run_classifier(&signal, &result, false) != EI_IMPULSE_OK) {
+                return false;
+            }
+        }
+        return true;
+    } });
+}
+
+// Warm up, size the batch and time the repetitions of one benchmark
+static bool run_benchmark(const Benchmark& bench, const Options& options, BenchResult& result) {
+
+#if EIDSP_SCRATCH_ARENA
+    arena.peak = 0;
+#endif
+
+    // Warm up with growing batches, at least one call
+    size_t batch = 1;
+    size_t calls = 0;
+    int64_t warmup_start_ns = ei_read_timer_ns();
+    int64_t warmup_elapsed_ns;
+    do {
+        if (!bench.run(batch)) {
+            return false;
+        }
+        calls += batch;
+        batch *= 2;
+        warmup_elapsed_ns = ei_read_timer_ns() - warmup_start_ns;
+    } while (warmup_elapsed_ns < options.warmup_ns);
+
+    // Calls per repetition
+    double estimate_ns = std::max(1.0, (double)warmup_elapsed_ns / calls);
+    size_t iterations = (size_t)std::ceil(options.min_time_ns / estimate_ns);
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    alloc_count = 0;
+    alloc_bytes = 0;
+
+    std::vector<double> ns_per_op;
+    for (int rep = 0; rep < options.repeats; rep++) {
+        int64_t start_ns = ei_read_timer_ns();
+        if (!bench.run(iterations)) {
+            return false;
+        }
+        ns_per_op.push_back((double)(ei_read_timer_ns() - start_ns) / iterations);
+    }
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+
+    double ops = (double)iterations * options.repeats;
+    result.name = bench.name;
+    result.iterations = iterations;
+    result.ns_per_op = ns_per_op[ns_per_op.size() / 2];
+    result.min_ns_per_op = ns_per_op.front();
+    result.bytes_per_op = alloc_bytes / ops;
+    result.allocs_per_op = alloc_count / ops;
+#if EIDSP_SCRATCH_ARENA
+    result.arena_peak = arena.peak;
+#else
+    result.arena_peak = 0;
+#endif
+
+    return true;
+}
+
+// Print all results as JSON
+static void print_json(const Options& options, const std::vector<BenchResult>& results) {
+
+    printf("{\n");
+    printf("  \"repeats\": %d,\n", options.repeats);
+    printf("  \"min_time_ns\": %lld,\n", (long long)options.min_time_ns);
+    printf("  \"benchmarks\": [\n");
+    for (size_t ix = 0; ix < results.size(); ix++) {
+        const BenchResult& result = results[ix];
+        printf("    {\"name\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f, \"min_ns_per_op\": %.1f, "
+            "\"bytes_per_op\": %.1f, \"allocs_per_op\": %.2f, \"arena_peak_bytes\": %u}%s\n",
+            result.name.c_str(),
+            (unsigned int)result.iterations,
+            result.ns_per_op,
+            result.min_ns_per_op,
+            result.bytes_per_op,
+            result.allocs_per_op,
+            (unsigned int)result.arena_peak,
+            ix + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+// Print one result as a table row
+static void print_row(const BenchResult& result) {
+    printf("%-28s %12.1f %12.1f %12.1f %10.2f %10u %12u\r\n",
+        result.name.c_str(),
+        result.ns_per_op,
+        result.min_ns_per_op,
+        result.bytes_per_op,
+        result.allocs_per_op,
+        (unsigned int)result.iterations,
+        (unsigned int)result.arena_peak);
+}
+
+/*******************************************************************************
+ * Main
+ */
+
+int main(int argc, char **argv) {
+
+    Options options = {
+        DEFAULT_REPEATS,
+        DEFAULT_WARMUP_MS * 1000000LL,
+        DEFAULT_MIN_TIME_MS * 1000000LL
+    };
+    std::string filter;
+    bool list = false;
+    bool json = false;
+    bool use_arena = false;
+    size_t arena_size = 0;
+    bool expect_no_allocs = false;
+
+    // Parse arguments
+    for (int ix = 1; ix < argc; ix++) {
+        if (strcmp(argv[ix], "--filter") == 0 && ix + 1 < argc) {
+            filter = argv[++ix];
+        } else if (strcmp(argv[ix], "--repeats") == 0 && ix + 1 < argc) {
+            options.repeats = atoi(argv[++ix]);
+        } else if (strcmp(argv[ix], "--warmup-ms") == 0 && ix + 1 < argc) {
+            options.warmup_ns = atoi(argv[++ix]) * 1000000LL;
+        } else if (strcmp(argv[ix], "--min-time-ms") == 0 && ix + 1 < argc) {
+            options.min_time_ns = atoi(argv[++ix]) * 1000000LL;
+        } else if (strcmp(argv[ix], "--arena") == 0) {
+            use_arena = true;
+            if (ix + 1 < argc && isdigit((unsigned char)argv[ix + 1][0])) {
+                arena_size = strtoul(argv[++ix], NULL, 10);
+            }
+        } else if (strcmp(argv[ix], "--expect-no-allocs") == 0) {
+            expect_no_allocs = true;
+        } else if (strcmp(argv[ix], "--list") == 0) {
+            list = true;
+        } else if (strcmp(argv[ix], "--json") == 0) {
+            json = true;
+        } else {
+            printf("ERROR: Unknown option %s\r\n", argv[ix]);
+            return 1;
+        }
+    }
+    if (options.repeats < 1) {
+        options.repeats = 1;
+    }
+
+    Fixture fixture;
+    make_fixture(fixture);
+
+    std::vector<Benchmark> benchmarks;
+    make_benchmarks(benchmarks, fixture);
+
+    if (list) {
+        for (const Benchmark& bench : benchmarks) {
+            printf("%s\r\n", bench.name.c_str());
+        }
+        return 0;
+    }
+
+    // The nn/ benchmarks use the model of the default session
+    if (ei_eon_session_init() != EI_IMPULSE_OK) {
+        printf("ERROR: Could not open the default session\r\n");
+        return 1;
+    }
+
+    if (use_arena) {
+#if EIDSP_SCRATCH_ARENA
+        if (arena_size == 0) {
+            arena_size = EI_CLASSIFIER_DSP_ARENA_SIZE;
+        }
+        // Room to align the start of the arena, so all of arena_size is usable
+        arena_buffer.resize(arena_size + EI_DSP_ARENA_ALIGNMENT);
+        ei_dsp_arena_init(&arena, arena_buffer.data(), arena_buffer.size());
+        ei_dsp_arena_bind(&arena);
+#else
+        printf("ERROR: --arena needs EIDSP_SCRATCH_ARENA=1\r\n");
+        ei_eon_session_deinit();
+        return 1;
+#endif
+    }
+
+    if (!json) {
+        printf("%-28s %12s %12s %12s %10s %10s %12s\r\n",
+            "benchmark", "ns/op", "min ns/op", "bytes/op", "allocs/op", "iterations", "arena bytes");
+    }
+
+    std::vector<BenchResult> results;
+    std::vector<std::string> allocating;
+    std::vector<std::string> skipped;
+    for (const Benchmark& bench : benchmarks) {
+        if (bench.name.find(filter) == std::string::npos) {
+            continue;
+        }
+
+        BenchResult result;
+#if EIDSP_SCRATCH_ARENA
+        arena.failed = 0;
+#endif
+        if (!run_benchmark(bench, options, result)) {
+#if EIDSP_SCRATCH_ARENA
+            if (use_arena && arena.failed > 0) {
+                if (!json) {
+                    printf("%-28s skipped, needs more than %u bytes of arena\r\n",
+                        bench.name.c_str(), (unsigned int)arena_size);
+                }
+                skipped.push_back(bench.name);
+                continue;
+            }
+#endif
+            printf("ERROR: %s failed\r\n", bench.name.c_str());
+            ei_eon_session_deinit();
+            return 1;
+        }
+        results.push_back(result);
+        if (result.allocs_per_op > 0) {
+            allocating.push_back(result.name);
+        }
+
+        if (!json) {
+            print_row(result);
+        }
+    }
+
+#if EIDSP_SCRATCH_ARENA
+    ei_dsp_arena_bind(NULL);
+#endif
+    ei_eon_session_deinit();
+
+    if (json) {
+        print_json(options, results);
+    }
+
+    if (expect_no_allocs && (!allocating.empty() || !skipped.empty())) {
+        for (const std::string& name : allocating) {
+            printf("ERROR: %s allocated from the heap after its warm-up\r\n", name.c_str());
+        }
+        for (const std::string& name : skipped) {
+            printf("ERROR: %s was skipped, it did not fit in the arena\r\n", name.c_str());
+        }
+        return 1;
+    }
+
+    return 0;
+}